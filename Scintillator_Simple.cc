@@ -37,6 +37,7 @@
 #include "DetectorConstruction.hh"
 #include "PhysicsList.hh"
 #include "ActionInitialization.hh"
+#include "SimulationConfig.hh"
 
 // Randomize class to set seed number
 #include "Randomize.hh"
@@ -46,6 +47,24 @@
 #include "G4UIExecutive.hh"
 #include "G4VisExecutive.hh"
 
+#include <fstream>
+#include <sstream>
+
+// True when the macro contains /run/initialize itself, i.e. it gives the
+// options that must precede initialization (/scint/det/..., /scint/pipeline/stage)
+static G4bool MacroInitializes(const G4String& fileName)
+{
+	std::ifstream in(fileName.c_str());
+	std::string line;
+	while(std::getline(in, line))
+	{
+		std::istringstream words(line);
+		std::string command;
+		if(words >> command && command == "/run/initialize") return true;
+	}
+	return false;
+}
+
 int main(int argc, char** argv)
 {
 	// Seed number setting
@@ -60,11 +79,16 @@ int main(int argc, char** argv)
 	  G4RunManager* runManager = new G4RunManager;
 	#endif
 
+	// Run options (/scint/...), created on the master before any worker
+	SimulationConfig::Instance();
+
 	runManager->SetUserInitialization(new DetectorConstruction());
 	runManager->SetUserInitialization(new PhysicsList());
 	runManager->SetUserInitialization(new ActionInitialization());
 
-	runManager->Initialize();
+	// Initialized here unless the macro does it after its pre-init options
+	const G4String macro = (argc == 1) ? G4String("vis.mac") : G4String(argv[1]);
+	if(!MacroInitializes(macro)) runManager->Initialize();
 
 	// Construct UI and visualization manager
 	G4UImanager* UImanager = G4UImanager::GetUIpointer();
@@ -81,8 +105,7 @@ int main(int argc, char** argv)
 	else		// batch mode
 	{
 	   G4String command = "/control/execute ";
-	   G4String filename = argv[1];
-	   UImanager->ApplyCommand(command+filename);
+	   UImanager->ApplyCommand(command+macro);
 	}
 
 	// Free the store
@@ -0,0 +1,90 @@
+#!/bin/sh
+#
+# Fixed-seed reference workloads of Scintillator_Simple.
+#
+#   run_benchmarks.sh <Scintillator_Simple> [--update-baseline] [workload ...]
+#
+# Each workload writes bench_<workload>.json (run statistics). Events/s,
+# steps/s, startup time and peak RSS are compared with bench/baseline.txt;
+# the script fails when a metric is worse than the baseline by more than
+# BENCH_TOLERANCE (default 0.10, i.e. 10 %). Without a baseline the
+# script fails unless --update-baseline is given.
+#
+# Environment: BENCH_THREADS (default 4), BENCH_TOLERANCE.
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+export BENCH_DIR
+BASELINE="$BENCH_DIR/baseline.txt"
+
+EXE="$1"
+if [ -z "$EXE" ] || [ ! -x "$EXE" ]; then
+    echo "usage: $0 <Scintillator_Simple> [--update-baseline] [workload ...]"
+    exit 2
+fi
+shift
+
+UPDATE=0
+if [ "$1" = "--update-baseline" ]; then
+    UPDATE=1
+    shift
+fi
+
+# Checked before the workloads so a missing baseline cannot pass the gate
+if [ $UPDATE -eq 0 ] && [ ! -f "$BASELINE" ]; then
+    echo "ERROR: no baseline ($BASELINE)" >&2
+    echo "       run with --update-baseline on the reference machine and commit it" >&2
+    exit 1
+fi
+
+WORKLOADS="$*"
+[ -z "$WORKLOADS" ] && WORKLOADS="phantom_optics phantom_optics_defer phantom_nooptics phsp_driven large_grid"
+
+: ${BENCH_THREADS:=4}
+: ${BENCH_TOLERANCE:=0.10}
+export BENCH_THREADS
+
+# value of a numeric top-level key in a run statistics file
+metric() {
+    sed -n "s/^  \"$2\": \([-0-9.eE+]*\),*$/\1/p" "$1"
+}
+
+RESULTS=bench_results.txt
+: > "$RESULTS"
+STATUS=0
+
+for w in $WORKLOADS; do
+    echo "=== $w ($BENCH_THREADS threads)"
+    # Macros refer to each other through {BENCH_DIR}
+    if ! "$EXE" "$BENCH_DIR/$w.mac" > "bench_$w.log" 2>&1; then
+        echo "    FAILED, see bench_$w.log"
+        STATUS=1
+        continue
+    fi
+    for m in events_per_s steps_per_s startup_time_s peak_rss_mb; do
+        v=$(metric "bench_$w.json" $m)
+        echo "$w $m $v" >> "$RESULTS"
+        echo "    $m = $v"
+    done
+done
+
+if [ $UPDATE -eq 1 ]; then
+    { echo "# workload metric value  (threads: $BENCH_THREADS, host: $(uname -n))"; cat "$RESULTS"; } > "$BASELINE"
+    echo "Baseline written to $BASELINE"
+    exit $STATUS
+fi
+
+# Throughputs must not drop, startup time and memory must not grow
+awk -v tol="$BENCH_TOLERANCE" '
+    FNR == NR { if ($1 !~ /^#/) base[$1 " " $2] = $3; next }
+    {
+        key = $1 " " $2; b = base[key]
+        if (b == "" || b == 0) { printf "  %-40s %12g   (no baseline)\n", key, $3; next }
+        r = $3 / b
+        worse = ($2 ~ /_per_s$/) ? (r < 1 - tol) : (r > 1 + tol)
+        printf "  %-40s %12g   baseline %12g   ratio %.3f %s\n", key, $3, b, r, worse ? "REGRESSION" : "ok"
+        if (worse) bad = 1
+    }
+    END { exit bad }
+' "$BASELINE" "$RESULTS" || STATUS=1
+
+exit $STATUS
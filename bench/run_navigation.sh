@@ -0,0 +1,65 @@
+#!/bin/sh
+#
+# Navigation of the pixel grid: the same workload (bench/navigation.mac,
+# 1000 x 1000 pixels, face readout) with every /scint/det/layout.
+#
+#   run_navigation.sh <Scintillator_Simple> [layout ...]
+#
+# Prints events/s, steps/s, startup time and peak RSS of every layout and
+# its event rate relative to the replica layout. Steps/s alone does not rank
+# the layouts: the single-volume layout has no pixel boundaries and needs
+# fewer steps for the same photons. The maps of all layouts must agree within
+# statistics (the random sequences differ with the geometry), which is
+# checked against the first layout with scint_validate when SCINT_VALIDATE
+# names it. Environment: BENCH_THREADS (default 4).
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+export BENCH_DIR
+
+EXE="$1"
+if [ -z "$EXE" ] || [ ! -x "$EXE" ]; then
+    echo "usage: $0 <Scintillator_Simple> [layout ...]"
+    exit 2
+fi
+shift
+
+LAYOUTS="$*"
+[ -z "$LAYOUTS" ] && LAYOUTS="replica nested single"
+
+: ${BENCH_THREADS:=4}
+export BENCH_THREADS
+
+metric() {
+    sed -n "s/^  \"$2\": \([-0-9.eE+]*\),*$/\1/p" "$1"
+}
+
+STATUS=0
+REFERENCE=
+printf "%-10s %12s %14s %10s %10s %8s\n" layout events/s steps/s startup_s rss_mb speedup
+for layout in $LAYOUTS; do
+    BENCH_LAYOUT=$layout
+    export BENCH_LAYOUT
+    if ! "$EXE" "$BENCH_DIR/navigation.mac" > "bench_navigation_$layout.log" 2>&1; then
+        echo "$layout: FAILED, see bench_navigation_$layout.log"
+        STATUS=1
+        continue
+    fi
+    json="bench_navigation_$layout.json"
+    rate=$(metric "$json" events_per_s)
+    [ -z "$REFERENCE" ] && REFERENCE=$rate
+    printf "%-10s %12s %14s %10s %10s %8s\n" "$layout" "$rate" "$(metric "$json" steps_per_s)" \
+        "$(metric "$json" startup_time_s)" "$(metric "$json" peak_rss_mb)" \
+        $(awk -v a="$rate" -v b="$REFERENCE" 'BEGIN { if (b > 0) printf "%.2f", a/b; else print "n/a" }')
+done
+
+if [ -n "$SCINT_VALIDATE" ]; then
+    first=
+    for layout in $LAYOUTS; do
+        [ -f "bench_navigation_${layout}_Moments.out" ] || continue
+        if [ -z "$first" ]; then first=$layout; continue; fi
+        echo "=== $layout against $first"
+        "$SCINT_VALIDATE" "bench_navigation_${layout}_Moments.out" "bench_navigation_${first}_Moments.out" || STATUS=1
+    done
+fi
+
+exit $STATUS
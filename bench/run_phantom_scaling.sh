@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Cost of the voxelised phantom against the number of voxels.
+#
+#   run_phantom_scaling.sh <Scintillator_Simple> <scint_phantom> [voxel_mm ...]
+#
+# Runs bench/voxel_phantom.mac with the water box, then with the test phantom
+# of scint_phantom (300 x 300 x 200 mm, water with bone and lung inserts) at
+# every voxel size (default 4 2 1 mm, i.e. 0.28 to 18 million voxels), and
+# prints events/s, startup time and peak RSS against the voxel count. With
+# regular navigation the event rate should fall far slower than the voxel
+# count grows. Environment: BENCH_THREADS (default 4).
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+export BENCH_DIR
+
+EXE="$1"
+TOOL="$2"
+if [ -z "$EXE" ] || [ ! -x "$EXE" ] || [ -z "$TOOL" ] || [ ! -x "$TOOL" ]; then
+    echo "usage: $0 <Scintillator_Simple> <scint_phantom> [voxel_mm ...]"
+    exit 2
+fi
+shift 2
+
+SIZES="$*"
+[ -z "$SIZES" ] && SIZES="4 2 1"
+
+: ${BENCH_THREADS:=4}
+export BENCH_THREADS
+
+metric() {
+    sed -n "s/^  \"$2\": \([-0-9.eE+]*\),*$/\1/p" "$1"
+}
+
+# run <tag> <phantom file|none> <voxels>
+run() {
+    BENCH_TAG=$1
+    BENCH_PHANTOM=$2
+    export BENCH_TAG BENCH_PHANTOM
+    if ! "$EXE" "$BENCH_DIR/voxel_phantom.mac" > "bench_phantom_$1.log" 2>&1; then
+        echo "$1: FAILED, see bench_phantom_$1.log"
+        STATUS=1
+        return
+    fi
+    json="bench_phantom_$1.json"
+    printf "%-10s %12s %12s %10s %10s\n" "$1" "$3" "$(metric "$json" events_per_s)" \
+        "$(metric "$json" startup_time_s)" "$(metric "$json" peak_rss_mb)"
+}
+
+STATUS=0
+printf "%-10s %12s %12s %10s %10s\n" phantom voxels events/s startup_s rss_mb
+run water none 1
+for v in $SIZES; do
+    n=$(awk -v v="$v" 'BEGIN { printf "%d %d %d", 300/v, 300/v, 200/v }')
+    if ! "$TOOL" -n $n -v $v $v $v -t -o "bench_phantom_${v}mm.scp" > /dev/null; then
+        echo "${v}mm: scint_phantom failed"
+        STATUS=1
+        continue
+    fi
+    run "${v}mm" "bench_phantom_${v}mm.scp" $(echo $n | awk '{ print $1*$2*$3 }')
+done
+
+exit $STATUS
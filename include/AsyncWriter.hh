@@ -0,0 +1,129 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef AsyncWriter_hh_
+#define AsyncWriter_hh_
+
+#include "globals.hh"
+#include "BlockFile.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+// Background writer of the run outputs (/scint/output/async). Worker and
+// master threads hand complete buffers to a bounded queue and return; a
+// single I/O thread writes them in order. Producers only wait when the
+// queue holds more than /scint/output/asyncQueue MB. When the writer is
+// not running every request is written synchronously by the caller.
+// With compression every file is written as a BlockFile (block-compressed
+// on the I/O thread). Errors of the I/O thread are reported by the next Flush().
+class AsyncWriter
+{
+public:
+	static AsyncWriter* Instance();
+	~AsyncWriter();
+
+	// Master side, around each run
+	void Start(G4double queueMB);
+	void Stop();
+	// Waits until every queued buffer has been written
+	void Flush();
+
+	G4bool IsRunning() const { return fRunning; }
+
+	// Codec and uncompressed block size of the files opened from now on
+	void SetCompression(BlockCodec codec, size_t blockSize);
+	BlockCodec GetCodec() const { return fCodec; }
+	size_t GetBlockSize() const { return fBlockSize; }
+
+	// Replaces fileName with data (written as <file>.tmp, then renamed);
+	// data is taken over and left empty
+	void WriteFile(const G4String& fileName, std::string& data);
+	// Appends data to fileName, which is truncated by the first call and
+	// stays open until Close()
+	void Append(const G4String& fileName, std::string& data);
+	void Close(const G4String& fileName);
+
+	// Since Start(); stored bytes are after compression
+	G4double GetBytesWritten() const { return fBytesWritten; }
+	G4double GetBytesStored() const { return fBytesStored; }
+	G4long GetBuffersWritten() const { return fBuffersWritten; }
+	G4double GetMaxQueuedBytes() const { return fMaxQueued; }
+	G4double GetProducerWait() const { return fProducerWait; }   // s, summed over threads
+	G4double GetWriteTime() const { return fWriteTime; }         // s, I/O thread
+
+private:
+	AsyncWriter();
+
+	enum Kind { kReplace, kAppend, kClose };
+	struct Request
+	{
+		Kind kind;
+		std::string fileName;
+		std::string data;
+	};
+
+	void Submit(Kind kind, const G4String& fileName, std::string& data);
+	struct OpenFile
+	{
+		FILE* file;
+		BlockWriter* writer;   // NULL without compression
+	};
+
+	void Execute(Request& request);
+	G4bool CloseFile(OpenFile& open);
+	void Loop();
+	void CloseAll();
+
+	static AsyncWriter fInstance;
+
+	std::thread fThread;
+	std::mutex fMutex, fErrorMutex;
+	std::condition_variable fNotEmpty, fNotFull, fDrained;
+	std::deque<Request> fQueue;
+	size_t fQueuedBytes, fMaxQueueBytes;
+	G4bool fBusy, fStop, fRunning;
+
+	// Owned by the I/O thread (by the caller when synchronous)
+	std::map<std::string, OpenFile> fOpen;
+	BlockCodec fCodec;
+	size_t fBlockSize;
+	std::vector<std::string> fErrors;
+
+	G4double fBytesWritten, fBytesStored, fMaxQueued, fProducerWait, fWriteTime;
+	G4long fBuffersWritten;
+};
+
+#endif
@@ -0,0 +1,165 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef BlockFile_hh_
+#define BlockFile_hh_
+
+// Block-compressed files (no Geant4 dependency, shared with the tools).
+//
+// The data is cut into blocks of a fixed uncompressed size that are
+// compressed independently, so a reader can decompress any range or all
+// blocks in parallel. An index of the blocks and a footer close the file;
+// files without them (writer killed) are read by walking the blocks.
+//   BlockFileHeader | (BlockHeader, packed data)... | BlockIndexEntry... | BlockFileFooter
+// BlockReader reads plain files as they are, so every reader of the run
+// outputs accepts both.
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define BLOCKFILE_MAGIC "SCBLOCK"
+#define BLOCKFILE_INDEX_MAGIC "SCBLKIX"
+#define BLOCKFILE_VERSION 1
+
+// zlib and zstd are only available when found at build time
+// (SCINT_USE_ZLIB, SCINT_USE_ZSTD); the built-in LZ codec always is
+enum BlockCodec { kCodecStored = 0, kCodecBuiltin = 1, kCodecZlib = 2, kCodecZstd = 3 };
+
+struct BlockFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t codec;       // requested codec, blocks may be stored instead
+	uint64_t blockSize;   // uncompressed bytes per block (the last one is shorter)
+};
+
+struct BlockHeader
+{
+	uint32_t codec;
+	uint32_t rawSize;
+	uint32_t packedSize;
+	uint32_t checksum;    // Adler-32 of the uncompressed block
+};
+
+struct BlockIndexEntry
+{
+	uint64_t offset;      // of the BlockHeader in the file
+	uint64_t rawOffset;   // of the first uncompressed byte
+};
+
+struct BlockFileFooter
+{
+	uint64_t indexOffset;
+	uint64_t nBlocks;
+	uint64_t rawSize;
+	char magic[8];
+};
+
+bool IsBlockCodecAvailable(BlockCodec codec);
+const char* GetBlockCodecName(BlockCodec codec);
+// "stored" is accepted for "none"
+bool ParseBlockCodec(const std::string& name, BlockCodec& codec);
+// Names of the codecs built in, for messages
+std::string GetBlockCodecNames();
+
+// Streaming compressor; the framed bytes are appended to a caller buffer
+class BlockWriter
+{
+public:
+	BlockWriter(BlockCodec codec, size_t blockSize);
+
+	void Write(const char* data, size_t n, std::string& out);
+	// Last partial block, index and footer
+	void Finish(std::string& out);
+
+	uint64_t GetRawSize() const { return fRawSize; }
+	uint64_t GetPackedSize() const { return fOffset; }
+
+private:
+	void Begin(std::string& out);
+	void WriteBlock(const char* data, size_t n, std::string& out);
+
+	BlockCodec fCodec;
+	size_t fBlockSize;
+	std::string fPending, fPacked;
+	std::vector<BlockIndexEntry> fIndex;
+	uint64_t fOffset, fRawSize;
+};
+
+// Random access to the uncompressed content of a block or plain file;
+// blocks are read with pread, so ReadAll() can decode them on several threads
+class BlockReader
+{
+public:
+	BlockReader();
+	~BlockReader();
+
+	bool Open(const std::string& fileName, std::string& error);
+	// Block or plain data embedded at [offset, offset+size) of a larger file
+	bool Open(const std::string& fileName, uint64_t offset, uint64_t size, std::string& error);
+	void Close();
+
+	bool IsCompressed() const { return fCompressed; }
+	uint64_t GetSize() const { return fSize; }
+	uint64_t GetStoredSize() const { return fStoredSize; }
+	size_t GetNumberOfBlocks() const { return fIndex.size(); }
+	// Of the file header, kCodecStored and 0 for plain files
+	BlockCodec GetCodec() const { return BlockCodec(fHeader.codec); }
+	uint64_t GetBlockSize() const { return fHeader.blockSize; }
+	// Bytes after the last complete block of a file without index
+	// (writer killed); ReadAll() fails on such files
+	uint64_t GetTruncatedBytes() const { return fTruncated; }
+
+	// Decompresses only the blocks covering [offset, offset+n)
+	bool Read(uint64_t offset, char* data, size_t n, std::string& error);
+	bool ReadAll(std::string& data, std::string& error, int nThreads = 1);
+
+	// Whole uncompressed content of a file
+	static bool ReadFile(const std::string& fileName, std::string& data, std::string& error, int nThreads = 1);
+
+private:
+	bool Fetch(uint64_t offset, char* data, size_t n) const;
+	bool ReadIndex(uint64_t fileSize);
+	size_t GetRawBlockSize(size_t k) const;
+	bool DecodeBlock(size_t k, char* data, std::string& packed, std::string& error) const;
+
+	std::string fFileName;
+	int fFd;
+	bool fCompressed;
+	uint64_t fBase, fSize, fStoredSize, fTruncated;
+	BlockFileHeader fHeader;
+	std::vector<BlockIndexEntry> fIndex;
+
+	// Last decoded block, for sequential Read() calls
+	size_t fCached;
+	std::string fCache, fPacked;
+};
+
+#endif
@@ -0,0 +1,86 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef Checkpoint_hh_
+#define Checkpoint_hh_
+
+#include "globals.hh"
+
+#include <stdint.h>
+
+class Run;
+
+#define CKPT_MAGIC "SCICKPT"
+#define CKPT_VERSION 5
+
+struct CheckpointHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t generation;
+	int32_t threadId;   // -1: master (base file) or sequential run
+	uint32_t reserved;
+	uint64_t nTotal;    // events requested for the whole job (base file)
+};
+
+// Periodic checkpoints of the accumulated results (/scint/checkpoint/).
+//
+// Each worker writes <dir>/worker<tid>_g<gen>.ckpt with its run state and
+// random engine every N events or T seconds. At the start of every run the
+// master writes <dir>/base.ckpt with the results restored from earlier jobs
+// and the state of its engine, which seeds the events. All files are
+// written under a temporary name and renamed, so a job killed at any time
+// leaves the last complete checkpoint. The generation number keeps worker
+// files of an earlier job from being counted twice after a resume.
+class Checkpoint
+{
+public:
+	// Worker side, called from Run::RecordEvent
+	static void WriteWorker(const Run& run);
+
+	// Master side
+	static void BeginRun(const Run& run);
+	static void EndRun();
+
+	// Loads the last checkpoint and restores the random engine; returns the
+	// number of events still to simulate to reach nTotal (0: the total of
+	// the interrupted job), -1 when there is nothing to resume
+	static G4long Resume(G4long nTotal);
+	// Adds the results restored by Resume to the merged run
+	static void RestoreInto(Run* run);
+
+private:
+	static G4String WorkerFile(G4int generation, G4int threadId);
+	static G4String BaseFile();
+	static void RemoveWorkerFiles();
+
+	static Run* fResumed;
+};
+
+#endif
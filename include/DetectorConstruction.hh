@@ -39,6 +39,12 @@
 #include "G4MaterialPropertiesTable.hh"
 
 #include "G4LogicalVolume.hh"
+
+#include <stdint.h>
+#include <vector>
+
+class G4OpticalSurface;
+
 class DetectorConstruction: public G4VUserDetectorConstruction
 {
 public:
@@ -51,13 +57,41 @@ public:
 	void SetSurfaceProperty();
 	void SetDimension();
 
+	// Voxelised phantom of /scint/det/phantom in place of the water box
+	void ConstructVoxelPhantom(G4LogicalVolume* lv_World);
+
+	// Material index of the voxels, shared by all threads
+	size_t GetVoxelMemoryBytes() const { return fVoxelIndex.capacity()*sizeof(size_t); }
+
+	// Source-independent description of everything upstream of the panel
+	G4String GetPhantomDescription() const;
+	// Water box used when no voxel phantom is set (configuration only,
+	// the same whether or not the phantom is built)
+	G4String GetWaterBoxDescription() const;
+
+	// Panel in global coordinates: full sizes and z of the -z (readout) face
+	G4double GetScintSizeX() const { return ScintSzX; }
+	G4double GetScintSizeY() const { return ScintSzY; }
+	G4double GetScintSizeZ() const { return ScintSzZ; }
+	G4double GetReadoutFaceZ() const { return pv_Scint->GetTranslation().z() - 0.5*ScintSzZ; }
+	G4ThreeVector GetScintCentre() const { return pv_Scint->GetTranslation(); }
+
+	// Optical model of the panel (optical photon filter)
+	const G4Material* GetScintMaterial() const { return fDRZ_high; }
+	const G4OpticalSurface* GetWrapSurface() const { return fWrap; }
+
 private:
 
 	//Geometry
 	G4LogicalVolume* lv_Scint;
+	// Sensitive volume: RepY, or lv_Scint in the single-volume layout
+	G4LogicalVolume* lv_Pixel;
 
 	G4VPhysicalVolume* pv_World;
 	G4VPhysicalVolume* pv_Scint;
+	G4VPhysicalVolume* pv_RepY;   // NULL in the single-volume layout
+
+	G4OpticalSurface* fWrap;
 
 
 	//Material
@@ -91,6 +125,14 @@ private:
 	G4double WaterBoxY;
 	G4double WaterBoxZ;
 
+	// Voxelised phantom: grid, voxel size, file hash, materials and the
+	// material index of every voxel (empty with the water box)
+	G4int fVoxelN[3];
+	G4double fVoxelSize[3];
+	uint64_t fPhantomHash;
+	std::vector<G4Material*> fVoxelMaterials;
+	std::vector<size_t> fVoxelIndex;
+
 
 
 
@@ -0,0 +1,79 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef EventRecord_hh_
+#define EventRecord_hh_
+
+// Per-event dataset layout (no Geant4 dependency, shared with tools).
+//
+// File = EventFileHeader | nEvents EventEntry | tensor data.
+// The entries have a fixed stride, so the table can be mapped as an array
+// of records; each entry points at its two pixel tensors (energy deposit
+// in MeV, detected photon weight) in the data section. A tensor is either
+// dense, float32[nPixelY*nPixelX] row-major, or sparse, count uint32
+// pixel indices iy*nPixelX+ix (ascending) followed by count float32 values.
+// Lengths in mm, energies in MeV, offsets in bytes from dataOffset.
+
+#include <stdint.h>
+
+#define EVENT_MAGIC    "SCEVENT"
+#define EVENT_VERSION  1
+
+enum EventTensorEncoding { kTensorDense = 0, kTensorSparse = 1 };
+
+struct EventEntry
+{
+	int32_t eventID;
+	int32_t pdg;            // first primary
+	int32_t nPrimaries;
+	int32_t reserved;
+	float x, y, z;          // first primary vertex
+	float dirX, dirY, dirZ; // first primary direction
+	float kinE;             // summed over the primaries
+	float weight;           // first primary
+	float edep;             // total in the panel
+	float photons;          // total detected weight
+	uint32_t edepCount, photonCount;        // stored values
+	uint32_t edepEncoding, photonEncoding;  // EventTensorEncoding
+	uint64_t edepOffset, photonOffset;
+};
+
+struct EventFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t entrySize;
+	uint64_t nEvents;
+	uint32_t nPixelX, nPixelY;
+	double pitchX, pitchY;   // mm
+	uint64_t dataOffset;     // of the tensor data in the file
+	uint64_t dataSize;
+};
+
+#endif
@@ -0,0 +1,90 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef EventWriter_hh_
+#define EventWriter_hh_
+
+#include "globals.hh"
+#include "EventRecord.hh"
+#include "SimulationConfig.hh"
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+class G4Event;
+
+// Per-thread buffered writer of the event dataset (EventRecord.hh).
+// Entries and tensors are buffered separately and go to the part files
+// <file>.index and <file>.data, through the AsyncWriter when it is running
+// at construction. Merge() on the master concatenates the parts of all
+// workers into one file with the entry table first.
+class EventWriter
+{
+public:
+	typedef std::vector<std::pair<G4int, G4float> > PixelValues;
+
+	EventWriter(const G4String& fileName, G4int nPixel, EventEncoding encoding, size_t bufferBytes);
+	~EventWriter();
+
+	// Pixel values in any order, a pixel may repeat (summed);
+	// both vectors are sorted and reduced in place
+	void Write(const G4Event* event, PixelValues& edep, PixelValues& photons);
+	void Flush();
+	void Close();
+
+	G4long GetNumberOfEvents() const { return fNEvents; }
+	const G4String& GetFileName() const { return fFileName; }
+	size_t GetMemoryBytes() const { return fIndex.capacity() + fData.capacity() + fDense.capacity()*sizeof(float); }
+
+	// Parts (base names) are removed once copied cleanly; false when a part
+	// was missing or corrupt (it is kept) or the output could not be written.
+	// The output is not compressed so the entry table can be mapped directly
+	static G4bool Merge(const std::vector<G4String>& parts, const G4String& output,
+			G4int nPixel, G4double pitchX, G4double pitchY);
+
+private:
+	// Appends one tensor to the data buffer and fills its fields of the entry
+	void AddTensor(PixelValues& values, uint32_t& count, uint32_t& encoding, uint64_t& offset, float& total);
+	void Append(const G4String& fileName, std::ofstream& out, std::string& data);
+
+	G4String fFileName;
+	std::ofstream fIndexOut, fDataOut;
+	std::string fIndex, fData;
+	std::vector<float> fDense;
+	size_t fBufferBytes;
+	G4int fNPixel;
+	EventEncoding fEncoding;
+	uint64_t fDataSize;   // tensor bytes of this part, written and buffered
+	G4long fNEvents;
+	G4bool fAsync, fOpen;
+};
+
+#endif
@@ -0,0 +1,58 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef MemoryReport_hh_
+#define MemoryReport_hh_
+
+#include "globals.hh"
+
+#include <cstddef>
+
+// Memory accounting of the run. The owners of the larger per-thread data
+// record the bytes they hold for the calling thread; Run::GetSummary
+// copies them into the worker summary, so the master reports them per
+// worker at end of run next to the resident set size of the process.
+// Read-only data (geometry, materials and their property vectors, the
+// phase-space input, the spectral response) exists once and is reported
+// as shared.
+class MemoryReport
+{
+public:
+	enum Component { kPixelMaps, kHitIndex, kHits, kPhaseSpaceBuffer, kEventBuffer, kOpticalBatch, kNComponents };
+
+	static void SetThreadUsage(Component component, size_t bytes);
+	static size_t GetThreadUsage(G4int component);
+	static const char* GetComponentName(G4int component);
+
+	// Of the whole process, bytes
+	static size_t GetResidentSize();
+	static size_t GetPeakResidentSize();
+};
+
+#endif
@@ -0,0 +1,96 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef Monitor_hh_
+#define Monitor_hh_
+
+#include "globals.hh"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+class PixelMap;
+
+// Live progress of the current run served on a Unix domain socket
+// (/scint/monitor/socket). Workers publish their counters and a
+// downsampled copy of their map into their own slot with relaxed atomic
+// stores; a master-side thread sums the slots when a client asks:
+//   "status\n" : events, target, events/s, ETA, relative uncertainty
+//   "map\n"    : downsampled merged pixel map
+class Monitor
+{
+public:
+	static Monitor* Instance();
+	~Monitor();
+
+	// Master side, around each run
+	void Start(const G4String& socketPath, G4int nSlots, G4long nEventsToProcess, G4int nPixel, G4int mapSize);
+	void Stop();
+
+	G4bool IsRunning() const { return fRunning.load(std::memory_order_relaxed); }
+
+	// Worker side; sum and sum2 are the running sums of the detected
+	// photons per event and of their squares
+	void Publish(G4int threadId, G4long nEvents, G4double sum, G4double sum2);
+	void PublishMap(G4int threadId, const PixelMap& map);
+
+private:
+	Monitor();
+
+	struct Slot
+	{
+		std::atomic<int64_t> nEvents;
+		std::atomic<double> sum;
+		std::atomic<double> sum2;
+		std::atomic<double>* map;
+		char pad[64];   // keeps slots of different threads off the same cache line
+	};
+
+	void Serve();
+	std::string Status() const;
+	std::string Map() const;
+
+	static Monitor fInstance;
+
+	std::atomic<bool> fRunning;
+	std::thread fThread;
+	int fSocket;
+	G4String fSocketPath;
+
+	Slot* fSlots;
+	G4int fNSlots;
+	G4long fNEventsToProcess;
+	G4int fNPixel;
+	G4int fMapSize;
+	G4double fStartTime;
+};
+
+#endif
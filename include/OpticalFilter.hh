@@ -0,0 +1,81 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef OpticalFilter_hh_
+#define OpticalFilter_hh_
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <unordered_set>
+
+class G4MaterialPropertyVector;
+
+// Analytic fate of an optical photon at creation, for face readout.
+//
+// The panel is a homogeneous box without scattering, so a photon travels
+// straight to the first face on its path. Photons reaching the readout
+// face (-z) survive bulk absorption with exp(-L/ABSLENGTH); photons
+// reaching another face can only come back through a reflection on the
+// wrap, so their reach probability is at most the wrap REFLECTIVITY
+// (the phantom on the +z face has no RINDEX and absorbs them as well).
+// With the current wrap (reflectivity 0) their loss is certain.
+class OpticalFilter
+{
+public:
+	OpticalFilter();
+	~OpticalFilter();
+
+	// Reads the panel and wrap from the detector construction; the filter
+	// stays inactive when the wrap is not a dielectric_metal surface
+	void Initialize();
+	G4bool IsActive() const { return fActive; }
+
+	// Reach probability of the readout face (upper bound for photons
+	// needing a reflection); directExit tells whether the photon goes
+	// straight to the readout face
+	G4double ReachProbability(const G4ThreeVector& pos, const G4ThreeVector& dir,
+			G4double energy, G4bool& directExit) const;
+
+	// Validation mode: photons predicted lost in the current event
+	void MarkPredictedLost(G4int trackID) { fPredictedLost.insert(trackID); }
+	G4bool IsPredictedLost(G4int trackID) const { return fPredictedLost.count(trackID) > 0; }
+	void Clear() { fPredictedLost.clear(); }
+
+private:
+	G4bool fActive;
+	G4ThreeVector fMin, fMax;   // panel corners, readout face at fMin.z()
+
+	const G4MaterialPropertyVector* fReflectivity;
+	const G4MaterialPropertyVector* fAbsLength;
+
+	std::unordered_set<G4int> fPredictedLost;
+};
+
+#endif
@@ -0,0 +1,87 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef OutputManager_hh_
+#define OutputManager_hh_
+
+#include "globals.hh"
+
+#include <vector>
+
+// Location and inventory of the run outputs (/scint/output/directory).
+//
+// At the start of every run the master creates a unique directory
+// <base>/run_<date-time>_<job>_<host>_p<pid>_r<run>_s<seed>; every writer
+// asks Path() for the location of its file and Register()s it, and the
+// master writes manifest.json describing the run and every file at the
+// end of the run. Names with a directory component (e.g. the pipeline
+// cache) are used as given. With the base "none" the outputs go to the
+// current directory as before.
+class OutputManager
+{
+public:
+	static OutputManager* Instance();
+
+	// Master, before the workers start
+	void BeginRun(G4int runID, long seed);
+	// Master, after all outputs are written
+	void EndRun(G4int nEvents);
+
+	G4String Path(const G4String& name) const;
+	// Thread-safe
+	void Register(const G4String& path, const G4String& description, G4int thread = -1);
+
+	const G4String& GetRunDirectory() const { return fRunDir; }
+	const G4String& GetJobId() const { return fJobId; }
+	const G4String& GetHost() const { return fHost; }
+	const G4String& GetStartTime() const { return fStartTime; }
+	G4int GetRunID() const { return fRunID; }
+	long GetSeed() const { return fSeed; }
+
+private:
+	OutputManager();
+
+	static OutputManager fInstance;
+
+	struct Entry
+	{
+		G4String path;
+		G4String description;
+		G4int thread;
+	};
+
+	G4String fRunDir;      // empty: current directory
+	G4String fJobId, fHost;
+	G4String fStartTime;
+	G4int fRunID;
+	long fSeed;
+	std::vector<Entry> fFiles;
+};
+
+#endif
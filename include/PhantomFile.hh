@@ -0,0 +1,95 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef PhantomFile_hh_
+#define PhantomFile_hh_
+
+// Voxelised phantom (no Geant4 dependency, shared with scint_phantom):
+// nx x ny x nz voxels, each holding an index into a material list. A
+// material is a NIST name (or any material known to the simulation) and a
+// density; CT densities become one material per density step.
+//
+//   PhantomFileHeader | materials | uint16 index per voxel, x fastest
+//
+// A material is stored as uint32 length, name, float64 density [g/cm3]
+// (0: density of the named material). Files may be block-compressed.
+
+#include "BlockFile.hh"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define PHANTOMFILE_MAGIC "SCPHANT"
+#define PHANTOMFILE_VERSION 1
+
+struct PhantomFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t nMaterials;
+	uint32_t n[3];      // voxels along x, y, z
+	uint32_t reserved;
+	double voxel[3];    // full voxel size [mm]
+};
+
+struct PhantomMaterial
+{
+	PhantomMaterial() : density(0.) {}
+	PhantomMaterial(const std::string& aName, double aDensity) : name(aName), density(aDensity) {}
+	std::string name;
+	double density;     // g/cm3, 0: default of the named material
+};
+
+class PhantomData
+{
+public:
+	PhantomData();
+
+	bool Read(const std::string& fileName, std::string& error);
+	bool Write(const std::string& fileName, std::string& error,
+			BlockCodec codec = kCodecStored, size_t blockSize = 1<<20) const;
+
+	uint64_t GetNumberOfVoxels() const { return uint64_t(n[0])*n[1]*n[2]; }
+	uint64_t Index(uint32_t ix, uint32_t iy, uint32_t iz) const { return (uint64_t(iz)*n[1] + iy)*n[0] + ix; }
+	// FNV-1a of the file content (pipeline cache key)
+	uint64_t GetHash() const { return fHash; }
+
+	uint32_t n[3];
+	double voxel[3];
+	std::vector<PhantomMaterial> materials;
+	std::vector<uint16_t> material;   // per voxel
+
+private:
+	void Serialise(std::string& data) const;
+
+	uint64_t fHash;
+};
+
+#endif
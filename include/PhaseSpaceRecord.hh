@@ -0,0 +1,63 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef PhaseSpaceRecord_hh_
+#define PhaseSpaceRecord_hh_
+
+// Binary phase-space layout (no Geant4 dependency, shared with tools).
+//
+// File = PhaseSpaceHeader followed by nRecords PhaseSpaceRecord.
+// Records of one event are contiguous. Lengths in mm, energy in MeV.
+
+#include <stdint.h>
+
+#define PHSP_MAGIC    "SCIPHSP"
+#define PHSP_VERSION  1
+
+struct PhaseSpaceRecord
+{
+	float x, y, z;
+	float dirX, dirY, dirZ;
+	float kinE;
+	float weight;
+	int32_t pdg;
+	int32_t eventID;
+};
+
+struct PhaseSpaceHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	uint64_t nRecords;
+	uint64_t nPrimaries;   // primaries simulated to produce this file
+	double planeZ;
+};
+
+#endif
@@ -0,0 +1,75 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef PhaseSpaceSource_hh_
+#define PhaseSpaceSource_hh_
+
+#include "globals.hh"
+#include "PhaseSpaceRecord.hh"
+
+#include <vector>
+#include <map>
+#include <utility>
+
+class G4Event;
+
+// Read-only phase space loaded once and shared by all worker threads.
+// One event is one source primary: event k replays the records stored for
+// source event k and stays empty when that primary did not reach the plane,
+// so N events correspond to N primaries of the full simulation whichever
+// thread processes them. Events beyond the source primaries wrap around
+// (the same primaries again, with a warning).
+class PhaseSpaceSource
+{
+public:
+	static const PhaseSpaceSource* GetSource(const G4String& fileName);
+
+	void GeneratePrimaryVertices(G4Event* anEvent) const;
+
+	G4long GetNumberOfRecords() const { return fRecords.size(); }
+	G4long GetNumberOfStoredEvents() const { return fGroupBegin.size() - 1; }
+	G4long GetNumberOfPrimaries() const { return fHeader.nPrimaries; }
+
+	// All loaded phase spaces (one copy for all threads)
+	static size_t GetSharedMemoryBytes();
+
+private:
+	PhaseSpaceSource(const G4String& fileName);
+
+	PhaseSpaceHeader fHeader;
+	std::vector<PhaseSpaceRecord> fRecords;
+	std::vector<size_t> fGroupBegin;
+	// (source event, group), sorted by source event
+	std::vector<std::pair<G4int, size_t> > fEventGroup;
+	mutable G4bool fWrapped;
+
+	static std::map<G4String, PhaseSpaceSource*> fSources;
+};
+
+#endif
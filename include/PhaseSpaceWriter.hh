@@ -0,0 +1,78 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef PhaseSpaceWriter_hh_
+#define PhaseSpaceWriter_hh_
+
+#include "globals.hh"
+#include "PhaseSpaceRecord.hh"
+#include "BlockFile.hh"
+
+#include <fstream>
+#include <vector>
+
+// Per-thread buffered writer of raw PhaseSpaceRecord (no header).
+// Full buffers go to the AsyncWriter when it is running at construction.
+// Parts written by the workers are concatenated by Merge() on the master.
+class PhaseSpaceWriter
+{
+public:
+	PhaseSpaceWriter(const G4String& fileName, G4int bufferSize);
+	~PhaseSpaceWriter();
+
+	inline void Fill(const PhaseSpaceRecord& rec)
+	{
+		fBuffer.push_back(rec);
+		if(fBuffer.size() >= fCapacity) Flush();
+	}
+	void Flush();
+	void Close();
+
+	G4long GetNumberOfRecords() const { return fNRecords; }
+	const G4String& GetFileName() const { return fFileName; }
+
+	// Concatenate part files (plain or block-compressed) into one file with
+	// header, block-compressed unless codec is kCodecStored. Parts are removed
+	// once copied cleanly; false when a part was missing or corrupt (it is
+	// kept) or the output could not be written
+	static G4bool Merge(const std::vector<G4String>& parts, const G4String& output,
+			G4double planeZ, G4long nPrimaries, BlockCodec codec = kCodecStored, size_t blockSize = 1 << 20);
+
+private:
+	static void Append(std::ofstream& out, BlockWriter* writer, const char* data, size_t n, std::string& packed);
+
+	G4String fFileName;
+	std::ofstream fOut;
+	std::vector<PhaseSpaceRecord> fBuffer;
+	size_t fCapacity;
+	G4long fNRecords;
+	G4bool fAsync, fOpen;
+};
+
+#endif
@@ -34,6 +34,7 @@
 #include "G4VModularPhysicsList.hh"
 
 class G4VPhysicsConstructor;
+class G4OpticalPhysics;
 
 class PhysicsList: public G4VModularPhysicsList
 {
@@ -42,8 +43,11 @@ public:
 	virtual ~PhysicsList();
 
 	virtual void SetCuts();
+	virtual void ConstructProcess();
 private:
 
+	G4OpticalPhysics* fOpticalPhysics;
+
 	G4double defaultCutValue;
 };
 
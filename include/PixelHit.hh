@@ -0,0 +1,92 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef PixelHit_hh_
+#define PixelHit_hh_
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+#include "globals.hh"
+
+// Optical photons detected in one pixel during one event.
+// Hits are aggregated per pixel by the sensitive detector, so an event
+// holds at most one hit per fired pixel.
+class PixelHit: public G4VHit
+{
+public:
+	PixelHit(G4int pixel);
+	virtual ~PixelHit();
+
+	inline void* operator new(size_t);
+	inline void operator delete(void*);
+
+	virtual void Print();
+
+	inline void AddPhoton(G4double time, G4double energy, G4double weight)
+	{
+		if(fNPhotons == 0 || time < fTime) fTime = time;
+		fNPhotons++;
+		fEnergy += energy;
+		fWeight += weight;
+	}
+
+	// Row-major pixel index iy*nPixel + ix
+	G4int GetPixel() const { return fPixel; }
+	G4int GetNPhotons() const { return fNPhotons; }
+	// Arrival time of the first photon
+	G4double GetTime() const { return fTime; }
+	// Summed photon energy and weight
+	G4double GetEnergy() const { return fEnergy; }
+	G4double GetWeight() const { return fWeight; }
+
+private:
+	G4int fPixel;
+	G4int fNPhotons;
+	G4float fTime;
+	G4float fEnergy;
+	G4double fWeight;
+};
+
+typedef G4THitsCollection<PixelHit> PixelHitsCollection;
+
+extern G4ThreadLocal G4Allocator<PixelHit>* PixelHitAllocator;
+
+inline void* PixelHit::operator new(size_t)
+{
+	if(!PixelHitAllocator) PixelHitAllocator = new G4Allocator<PixelHit>;
+	return (void*)PixelHitAllocator->MallocSingle();
+}
+
+inline void PixelHit::operator delete(void* hit)
+{
+	PixelHitAllocator->FreeSingle((PixelHit*)hit);
+}
+
+#endif
@@ -0,0 +1,124 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef PixelMap_hh_
+#define PixelMap_hh_
+
+// Accumulated pixel values with dense or sparse storage (no Geant4
+// dependency, shared with the tools).
+//
+// A map starts sparse (hash map of the fired cells) and switches to a
+// dense array once the occupancy makes the array the smaller of the two,
+// so narrow beams on fine grids keep per-thread memory small.
+// Cells are numbered row-major over nFrames x ni x nj.
+
+#include <stdint.h>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#define PIXELMAP_MAGIC "SCIMAP"
+#define PIXELMAP_VERSION 2
+
+// Binary layout: header, then nFrames*ni*nj doubles (dense) or
+// nEntries (uint64 cell, double value) pairs sorted by cell (sparse)
+struct PixelMapHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t sparse;
+	uint64_t nFrames;
+	uint64_t ni;
+	uint64_t nj;
+	uint64_t nEntries;
+};
+
+// Version 2: header followed by the pixel pitch in mm (0 when unknown)
+struct PixelMapGeometry
+{
+	double pitchX;
+	double pitchY;
+};
+
+class PixelMap
+{
+public:
+	PixelMap(int64_t ni = 0, int64_t nj = 0, int64_t nFrames = 1);
+
+	inline void Fill(int64_t cell, double weight)
+	{
+		if(fDense) { fValue[cell] += weight; return; }
+		fSparse[cell] += weight;
+		if(int64_t(fSparse.size()) > fSwitchSize) ToDense();
+	}
+	// False, and nothing added, when the grids differ
+	bool Add(const PixelMap& other);
+	bool SameGrid(const PixelMap& other) const
+	{ return fNi == other.fNi && fNj == other.fNj && fNFrames == other.fNFrames; }
+	void Scale(double factor);
+
+	double Get(int64_t cell) const;
+	// Non-zero cells in increasing cell order
+	void GetEntries(std::vector<std::pair<int64_t, double> >& entries) const;
+	// Sum over frames rebinned to ci x cj cells, row-major
+	void Downsample(int64_t ci, int64_t cj, std::vector<double>& coarse) const;
+
+	// Pixel pitch in mm along j (x) and i (y), written with the map
+	void SetPitch(double pitchX, double pitchY) { fPitchX = pitchX; fPitchY = pitchY; }
+	double GetPitchX() const { return fPitchX; }
+	double GetPitchY() const { return fPitchY; }
+
+	int64_t GetNi() const { return fNi; }
+	int64_t GetNj() const { return fNj; }
+	int64_t GetNFrames() const { return fNFrames; }
+	int64_t GetNCells() const { return fNCells; }
+	bool IsDense() const { return fDense; }
+	double GetOccupancy() const;
+	// Approximate heap usage of the storage
+	size_t GetMemoryBytes() const;
+
+	bool WriteBinary(const std::string& fileName) const;
+	bool ReadBinary(const std::string& fileName, std::string& error);
+	// Same layout within a larger stream (checkpoints)
+	bool Write(std::ostream& out) const;
+	bool Read(std::istream& in, std::string& error);
+
+private:
+	void ToDense();
+
+	int64_t fNi, fNj, fNFrames, fNCells;
+	int64_t fSwitchSize;
+	double fPitchX, fPitchY;
+	bool fDense;
+	std::vector<double> fValue;
+	std::unordered_map<int64_t, double> fSparse;
+};
+
+#endif
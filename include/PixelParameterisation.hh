@@ -0,0 +1,67 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef PixelParameterisation_hh_
+#define PixelParameterisation_hh_
+
+#include "G4VNestedParameterisation.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Material;
+class G4VPhysicalVolume;
+class G4VTouchable;
+
+// Pixels of one column of the panel (/scint/det/layout nested): copy n is
+// placed at row n along y of its mother, a replica column along x. The
+// material may depend on the column (parent copy number) and the row, so
+// per-pixel materials do not need one logical volume per pixel; the panel
+// uses one material for all pixels.
+class PixelParameterisation: public G4VNestedParameterisation
+{
+public:
+	PixelParameterisation(G4Material* material, G4int nPixel, G4double pitch);
+	virtual ~PixelParameterisation();
+
+	virtual void ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const;
+
+	using G4VNestedParameterisation::ComputeMaterial;
+	virtual G4Material* ComputeMaterial(G4VPhysicalVolume* currentVol, const G4int repNo,
+			const G4VTouchable* parentTouch = 0);
+	virtual G4int GetNumberOfMaterials() const;
+	virtual G4Material* GetMaterial(G4int idx) const;
+
+private:
+	std::vector<G4Material*> fMaterials;
+	G4int fNPixel;
+	G4double fPitch;
+};
+
+#endif
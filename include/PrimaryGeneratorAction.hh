@@ -34,6 +34,8 @@
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "G4GeneralParticleSource.hh"
 
+class PhaseSpaceSource;
+
 class PrimaryGeneratorAction: public G4VUserPrimaryGeneratorAction
 {
 public:
@@ -46,6 +48,10 @@ private:
 
 	G4GeneralParticleSource *fPrimary;
 
+	// Phase-space input (panel stage), shared between threads
+	const PhaseSpaceSource* fPhspSource;
+	G4String fPhspSourceFile;
+
 };
 
 #endif
@@ -0,0 +1,225 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef Run_hh_
+#define Run_hh_
+
+#include "G4Run.hh"
+#include "globals.hh"
+#include "G4SystemOfUnits.hh"
+#include "VariableContainer_wjcheon.hh"
+#include "PixelMap.hh"
+#include "MemoryReport.hh"
+
+#include <vector>
+#include <iosfwd>
+
+class G4Event;
+class G4ParticleDefinition;
+class SteppingProfiler;
+class RunFileWriter;
+
+// Step and optical photon counters of one run.
+// Worker runs are merged into the master run, which keeps one
+// summary per worker for the end-of-run report.
+class Run: public G4Run
+{
+public:
+	enum StepCategory { kGamma, kElectron, kPositron, kOpticalPhoton, kOther, kNCategories };
+
+	struct WorkerSummary
+	{
+		G4int threadId;
+		G4int nEvents;
+		G4double wallTime;   // s, begin of run to last event
+		G4double cpuTime;    // s, thread CPU time over the same interval
+		G4long nSteps;
+		G4long nPhotonsCreated;
+		G4long nPhotonsDetected;
+		size_t memory[MemoryReport::kNComponents];   // bytes held by the worker
+	};
+
+	Run();
+	virtual ~Run();
+
+	virtual void RecordEvent(const G4Event*);
+	virtual void Merge(const G4Run*);
+
+	inline void AddStep(const G4ParticleDefinition* particle)
+	{
+		if(particle == fOpticalPhoton) fSteps[kOpticalPhoton]++;
+		else if(particle == fElectron) fSteps[kElectron]++;
+		else if(particle == fGamma) fSteps[kGamma]++;
+		else if(particle == fPositron) fSteps[kPositron]++;
+		else fSteps[kOther]++;
+	}
+	inline void AddPhotonCreated() { fPhotonsCreated++; }
+	// Optical filter: reach probability of the readout face summed over
+	// kept and culled photons, and the validation counters
+	inline void AddPhotonKept(G4double reach) { fReachKept += reach; }
+	inline void AddPhotonCulled(G4double reach) { fPhotonsCulled++; fReachCulled += reach; }
+	inline void AddPhotonPredictedLost() { fPhotonsPredictedLost++; }
+	inline void AddPhotonMispredicted() { fPhotonsMispredicted++; }
+	inline void AddDetectedPhoton(G4int iy, G4int ix, G4double energy, G4double time, G4double weight)
+	{
+		fPhotonsDetected++;
+		fPixelMap.Fill(iy*fNPixel+ix, weight);
+		G4int bin = G4int((energy - SPECTRUM_EMIN)*fSpectrumScale);
+		if(bin >= 0 && bin < SPECTRUM_BINS)
+		{
+			fSpectrum[bin] += weight;
+			if(fMoments) fEventSpectrum[bin] += weight;
+		}
+
+		if(fFramePeriod > 0.)
+		{
+			G4long frame = G4long(time/fFramePeriod);
+			if(frame < fNFrames) fTimeMap.Fill((frame*fNPixel + iy)*fNPixel + ix, weight);
+			else fTimeOverflow += weight;
+		}
+	}
+
+	G4long GetSteps(G4int category) const { return fSteps[category]; }
+	G4long GetTotalSteps() const;
+	G4long GetPhotonsCreated() const { return fPhotonsCreated; }
+	G4long GetPhotonsCulled() const { return fPhotonsCulled; }
+	G4long GetPhotonsDetected() const { return fPhotonsDetected; }
+	G4long GetPhotonsPredictedLost() const { return fPhotonsPredictedLost; }
+	G4long GetPhotonsMispredicted() const { return fPhotonsMispredicted; }
+	G4double GetReachKept() const { return fReachKept; }
+	// Signal lost with the culled photons, 1 when only certain losses are culled
+	G4double GetFilterCorrection() const
+	{ return fReachKept > 0. ? (fReachKept + fReachCulled)/fReachKept : 1.; }
+
+	// Scales maps, spectrum and time map (filter correction before writing)
+	void ScaleSignal(G4double factor);
+
+	// Legacy text layouts: "i \t j \t value" with a blank line per row,
+	// and "E_low [eV] \t value" per spectrum bin; binary maps use the
+	// PixelMap layout in the storage of the map (dense or sparse)
+	void WriteMap(const G4String& fileName, G4bool binary = false) const;
+	void WriteSpectrum(const G4String& fileName) const;
+	// "events N", "grid ni nj", "total S S2", then "row i", "column j",
+	// "spectrum bin" and "pixel i j" (non-zero) lines with the sums over
+	// events of the per-event signal x, of x^2 and of x times the event
+	// total; nothing is written unless moments were recorded for every
+	// event of the run
+	G4bool WriteMoments(const G4String& fileName) const;
+	// Non-zero entries of the time-resolved map, "frame \t i \t j \t value";
+	// nothing is written when time-resolved scoring is off
+	void WriteTimeMap(const G4String& fileName, G4bool binary = false) const;
+	// Map, spectrum and time map (sparse) as entries <group>map, ... of a
+	// run container
+	void WriteContainer(RunFileWriter& out, const G4String& group) const;
+
+	const PixelMap& GetPixelMap() const { return fPixelMap; }
+
+	// Results of an interrupted job restored from a checkpoint,
+	// added to this run including their events; false, and nothing
+	// added, when the checkpoint grid differs from this run
+	G4bool Restore(const Run& previous);
+
+	// Counters, maps and spectrum in binary form (checkpoints)
+	G4bool WriteState(std::ostream& out) const;
+	G4bool ReadState(std::istream& in);
+
+	G4int GetThreadId() const { return fThreadId; }
+
+	// NULL unless /scint/profile/enable was set when the run started
+	SteppingProfiler* GetProfiler() const { return fProfiler; }
+
+	WorkerSummary GetSummary() const;
+	const std::vector<WorkerSummary>& GetWorkerSummaries() const { return fWorkers; }
+
+	static const char* GetCategoryName(G4int category);
+
+private:
+	G4bool Accumulate(const Run& other);
+	void RecordMoments(const G4Event* anEvent);
+
+	const G4ParticleDefinition* fGamma;
+	const G4ParticleDefinition* fElectron;
+	const G4ParticleDefinition* fPositron;
+	const G4ParticleDefinition* fOpticalPhoton;
+
+	G4long fSteps[kNCategories];
+	G4long fPhotonsCreated;
+	G4long fPhotonsCulled;
+	G4long fPhotonsDetected;
+	G4long fPhotonsPredictedLost;
+	G4long fPhotonsMispredicted;
+	G4double fReachKept, fReachCulled;
+
+	// nPixel x nPixel, row-major [RepY][RepX]
+	G4int fNPixel;
+	PixelMap fPixelMap;
+	std::vector<G4double> fSpectrum;
+	G4double fSpectrumScale;
+
+	// Sums over events of the squared per-event signal and of the signal
+	// times the event total (pixel, row, column, spectrum bin), recorded
+	// when /scint/output/moments is set; the per-event pixel signal comes
+	// from the hits of the event
+	G4bool fMoments;
+	G4int fHCID;
+	G4long fMomentEvents;
+	PixelMap fPixelMap2, fPixelMapT;
+	std::vector<G4double> fRow2, fColumn2, fSpectrum2;
+	std::vector<G4double> fRowT, fColumnT, fSpectrumT;
+	G4double fTotal2;
+	std::vector<G4double> fEventRow, fEventColumn, fEventSpectrum;
+
+	// nFrames x nPixel x nPixel, empty when time-resolved scoring is off
+	G4double fFramePeriod;
+	G4long fNFrames;
+	PixelMap fTimeMap;
+	G4double fTimeOverflow;
+
+	G4int fThreadId;
+	G4double fWallStart, fWallTime;
+	G4double fCpuStart, fCpuTime;
+
+	std::vector<WorkerSummary> fWorkers;
+
+	// Detected photons per event (monitoring uncertainty)
+	G4long fLastPhotonsDetected;
+	G4double fSignalSum, fSignalSum2;
+	G4int fMonitorMapPeriod;
+
+	// Worker checkpoints every fCheckpointEvents events or
+	// fCheckpointInterval seconds (0: off)
+	G4int fCheckpointEvents;
+	G4double fCheckpointInterval;
+	G4int fLastCheckpointEvent;
+	G4double fLastCheckpointTime;
+
+	SteppingProfiler* fProfiler;
+};
+
+#endif
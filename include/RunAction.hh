@@ -0,0 +1,83 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef RunAction_hh_
+#define RunAction_hh_
+
+#include "G4UserRunAction.hh"
+#include "globals.hh"
+
+#include <vector>
+#include <iosfwd>
+
+class G4Run;
+class Run;
+class PhaseSpaceWriter;
+class EventWriter;
+
+class RunAction: public G4UserRunAction
+{
+public:
+	RunAction();
+	virtual ~RunAction();
+
+	virtual G4Run* GenerateRun();
+	virtual void BeginOfRunAction(const G4Run*);
+	virtual void EndOfRunAction(const G4Run*);
+
+	// Worker-side phase-space writer, NULL when recording is disabled
+	PhaseSpaceWriter* GetPhaseSpaceWriter() const { return fPhspWriter; }
+	// Worker-side event dataset writer, NULL when disabled
+	EventWriter* GetEventWriter() const { return fEventWriter; }
+
+	// Run of this thread, valid between GenerateRun and the next run
+	Run* GetRun() const { return fRun; }
+
+private:
+	G4bool IsWorkerRole() const;
+	void PrintStatistics(const Run* aRun) const;
+	void WriteStatistics(const Run* aRun) const;
+	void FormatStatistics(const Run* aRun, std::ostream& out) const;
+	// Appends the results of the run as group run<k>/ of the run container
+	void WriteContainer(const Run* aRun, G4int nJobEvents) const;
+
+	Run* fRun;
+	PhaseSpaceWriter* fPhspWriter;
+	EventWriter* fEventWriter;
+
+	// Master-side timing of the whole run (s)
+	G4double fWallStart, fWallTime;
+	G4double fCpuStart, fCpuTime;
+
+	// Part files closed by the workers, merged by the master
+	static std::vector<G4String> fPhspParts;
+	static std::vector<G4String> fEventParts;
+};
+
+#endif
@@ -0,0 +1,154 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef RunFile_hh_
+#define RunFile_hh_
+
+// Self-describing container of the results of a run (no Geant4
+// dependency, shared with the tools; scint_dump lists and extracts it).
+//
+// A container holds named entries: text (JSON, tables) or n-dimensional
+// float64/int64 arrays, row-major, each with string attributes (units,
+// pitch, ...). The data of every entry is stored as an embedded BlockFile,
+// so any range of rows can be read without decoding the rest. A directory
+// in text form and a footer close the file:
+//   RunFileHeader | entry data... | directory | RunFileFooter
+// Opening an existing container for append adds the new entries and the
+// combined directory after the old ones, so a writer that dies leaves the
+// previous directory readable (the reader takes the last complete one).
+// An entry name may occur several times, the last one is current.
+
+#include "BlockFile.hh"
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define RUNFILE_MAGIC "SCRUN"
+#define RUNFILE_DIR_MAGIC "SCRUNDR"
+#define RUNFILE_VERSION 1
+
+enum RunFileType { kRunFileText, kRunFileFloat64, kRunFileInt64 };
+
+struct RunFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+};
+
+struct RunFileFooter
+{
+	uint64_t directoryOffset;
+	uint64_t directorySize;
+	char magic[8];
+};
+
+typedef std::vector<std::pair<std::string, std::string> > RunFileAttributes;
+
+struct RunFileEntry
+{
+	std::string name;            // '/' separates groups, no white space
+	RunFileType type;
+	std::vector<uint64_t> shape; // empty for text
+	uint64_t offset, size;       // embedded BlockFile
+	RunFileAttributes attributes;
+
+	uint64_t GetNumberOfElements() const;
+	// Elements per index of the first dimension
+	uint64_t GetRowLength() const;
+	// Empty when missing
+	std::string GetAttribute(const std::string& key) const;
+};
+
+const char* GetRunFileTypeName(RunFileType type);
+
+class RunFileWriter
+{
+public:
+	RunFileWriter();
+	~RunFileWriter();
+
+	// New container, or appended to when it exists and append is set
+	bool Open(const std::string& fileName, bool append, std::string& error);
+	// Writes the directory of all entries
+	bool Close(std::string& error);
+
+	void SetCompression(BlockCodec codec, size_t blockSize) { fCodec = codec; fBlockSize = blockSize; }
+
+	bool AddText(const std::string& name, const std::string& text,
+			const RunFileAttributes& attributes = RunFileAttributes());
+	bool AddArray(const std::string& name, const double* data, const std::vector<uint64_t>& shape,
+			const RunFileAttributes& attributes = RunFileAttributes());
+	bool AddArray(const std::string& name, const int64_t* data, const std::vector<uint64_t>& shape,
+			const RunFileAttributes& attributes = RunFileAttributes());
+
+	// Including the entries of an appended container
+	const std::vector<RunFileEntry>& GetEntries() const { return fEntries; }
+
+private:
+	bool Add(const std::string& name, RunFileType type, const char* data, size_t n,
+			const std::vector<uint64_t>& shape, const RunFileAttributes& attributes);
+
+	FILE* fFile;
+	uint64_t fOffset;
+	BlockCodec fCodec;
+	size_t fBlockSize;
+	std::vector<RunFileEntry> fEntries;
+};
+
+class RunFileReader
+{
+public:
+	bool Open(const std::string& fileName, std::string& error);
+
+	static bool IsRunFile(const std::string& fileName);
+
+	const std::vector<RunFileEntry>& GetEntries() const { return fEntries; }
+	// Last entry of that name, NULL when there is none
+	const RunFileEntry* Find(const std::string& name) const;
+
+	bool ReadText(const RunFileEntry& entry, std::string& text, std::string& error) const;
+	// Whole array, int64 entries converted
+	bool ReadArray(const RunFileEntry& entry, std::vector<double>& data, std::string& error, int nThreads = 1) const;
+	bool ReadArray(const RunFileEntry& entry, std::vector<int64_t>& data, std::string& error, int nThreads = 1) const;
+	// Rows [first, first+count) of the first dimension, only their blocks are decoded
+	bool ReadRows(const RunFileEntry& entry, uint64_t first, uint64_t count, std::vector<double>& data,
+			std::string& error) const;
+
+private:
+	bool ReadRaw(const RunFileEntry& entry, std::string& raw, std::string& error, int nThreads) const;
+
+	std::string fFileName;
+	std::vector<RunFileEntry> fEntries;
+};
+
+#endif
@@ -36,6 +36,9 @@
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "VariableContainer_wjcheon.hh"
+#include "PixelHit.hh"
+#include "SlabTransport.hh"
+#include "EventWriter.hh"
 
 
 #include <string.h>
@@ -44,11 +47,14 @@
 #include <sstream>
 #include <time.h>
 #include <stdio.h>
+#include <vector>
+#include <utility>
 
 using namespace std;
 
 class G4HCofThisEvent;
 class G4TouchableHistory;
+class Run;
 
 class SensitiveDetector: public G4VSensitiveDetector
 {
@@ -59,12 +65,53 @@ public:
 	void Initialize(G4HCofThisEvent*);
 	G4bool ProcessHits(G4Step* aStep, G4TouchableHistory*);
 	void EndOfEvent(G4HCofThisEvent*);
+
+	// Face readout: photons are scored when they leave the pixel at this z
+	void SetReadoutFaceZ(G4double z) { fReadoutFaceZ = z; }
+
+	// Single-volume layout: the sensitive volume is the whole panel and the
+	// pixel is computed from the position (lower corner and pitch, global)
+	void SetComputedGrid(G4double xMin, G4double yMin, G4double pitchX, G4double pitchY)
+	{ fComputedGrid = true; fGridX = xMin; fGridY = yMin; fInvPitchX = 1./pitchX; fInvPitchY = 1./pitchY; }
+
+	// Scores one optical photon in pixel (iy, ix): run map, spectrum and hits
+	void ScorePhoton(G4int iy, G4int ix, G4double energy, G4double time, G4double weight);
+
+	// Analytic transport: queues a new optical photon for the end of the
+	// event; false when the photon is not in the panel
+	G4bool AddAnalyticPhoton(const G4Track* track);
 private:
-	std::ofstream ofs;
-	std::ofstream ofs_hist;
-	G4double DEMatrix[REPLICA_NUM][REPLICA_NUM];
 	G4double Counter;
-	string filenameForSave;
+
+	// Run of this thread, refreshed at the start of every event;
+	// the pixel map and spectrum are accumulated there
+	Run* fRun;
+
+	// Per-event hits, one per fired pixel. fHitSlots maps a fired pixel to
+	// its hit in the collection (open addressing, pixel -1: free slot); it is
+	// sized to the pixels fired in an event, not to the grid, so that every
+	// thread does not hold nPixel^2 indices (4 MB for 1000 x 1000)
+	PixelHitsCollection* fHitsCollection;
+	G4int fHCID;
+	G4int fNPixel;
+	std::vector<std::pair<G4int, G4int> > fHitSlots;
+	std::vector<size_t> fUsedHitSlots;
+	size_t FindHitSlot(G4int pixel) const;
+
+	G4bool fFaceReadout;
+	G4int fResponseMode;
+	G4bool fFilterValidate;
+	G4double fReadoutFaceZ;
+
+	G4bool fComputedGrid;
+	G4double fGridX, fGridY, fInvPitchX, fInvPitchY;
+
+	// Optical photons of the current event (analytic transport)
+	SlabTransport fTransport;
+
+	// Event dataset of this thread (NULL: off), deposits and photons of the event
+	EventWriter* fEventWriter;
+	EventWriter::PixelValues fEventDeposits, fEventPhotons;
 };
 
 #endif
@@ -0,0 +1,321 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef SimulationConfig_hh_
+#define SimulationConfig_hh_
+
+#include "globals.hh"
+#include "G4SystemOfUnits.hh"
+#include "VariableContainer_wjcheon.hh"
+#include "BlockFile.hh"
+
+class SimulationMessenger;
+
+// Two-stage pipeline: full simulation, source + phantom only (stage 1),
+// or panel only driven by a stage-1 phase space (stage 2)
+enum PipelineStage { kFullStage, kPhantomStage, kPanelStage };
+
+// Pixel volumes of the panel: two levels of replicas (RepX, RepY), a replica
+// column with a nested parameterisation of its rows, or the panel as one
+// volume with the pixel computed from the position of the photon
+enum PixelLayout { kReplicaLayout, kNestedLayout, kSingleLayout };
+
+// Optical readout: every optical photon step in a pixel volume (legacy),
+// or photons reaching the -z face of the panel (photodiode side)
+enum ReadoutMode { kVolumeReadout, kFaceReadout };
+
+// Analytic optical photon filter (face readout): off, kill photons that
+// cannot reach the readout face, or only check the predictions
+enum OpticalFilterMode { kFilterOff, kFilterCull, kFilterValidate };
+
+// Optical photon transport in the panel (face readout): full Geant4
+// tracking, or the analytic slab model of SlabTransport
+enum OpticalTransport { kGeant4Transport, kAnalyticTransport };
+
+// Pixel tensors of the event dataset: the smaller of dense and sparse per
+// tensor, or always one of them
+enum EventEncoding { kEncodingAuto, kEncodingDense, kEncodingSparse };
+
+// Spectral response of the photodiode applied when a photon is scored:
+// none, photon weight times QE, or photon accepted with probability QE
+enum ResponseMode { kResponseOff, kResponseWeight, kResponseAccept };
+
+// Run-time options shared by the master and all worker threads.
+// Values are set from macros (/scint/...) on the master between runs
+// and are only read while the event loop is running.
+class SimulationConfig
+{
+public:
+	static SimulationConfig* Instance();
+	~SimulationConfig();
+
+	// Detector: pixels per side of the scintillator grid
+	void SetNumberOfPixels(G4int val) { fNPixel = val; }
+	G4int GetNumberOfPixels() const { return fNPixel; }
+
+	void SetReadout(ReadoutMode val) { fReadout = val; }
+	ReadoutMode GetReadout() const { return fReadout; }
+
+	void SetPixelLayout(PixelLayout val) { fPixelLayout = val; }
+	PixelLayout GetPixelLayout() const { return fPixelLayout; }
+	const char* GetPixelLayoutName() const;
+
+	// Voxelised phantom (PhantomFile) replacing the water box, empty: water box
+	void SetPhantomFile(const G4String& val) { fPhantomFile = val; }
+	const G4String& GetPhantomFile() const { return fPhantomFile; }
+
+	// Smart voxel quality of the parameterised pixels (G4LogicalVolume::SetSmartless)
+	void SetSmartless(G4double val) { fSmartless = val; }
+	G4double GetSmartless() const { return fSmartless; }
+
+	// Optical photons: deferred to the waiting stack, filtered at creation
+	void SetOpticalDeferEnabled(G4bool val) { fOpticalDefer = val; }
+	G4bool IsOpticalDeferEnabled() const { return fOpticalDefer; }
+
+	void SetOpticalTransport(OpticalTransport val) { fOpticalTransport = val; }
+	OpticalTransport GetOpticalTransport() const { return fOpticalTransport; }
+
+	void SetOpticalFilter(OpticalFilterMode val) { fOpticalFilter = val; }
+	OpticalFilterMode GetOpticalFilter() const { return fOpticalFilter; }
+
+	// Photons with a reach probability up to this value are filtered
+	// (0: certain losses only)
+	void SetOpticalFilterThreshold(G4double val) { fOpticalFilterThreshold = val; }
+	G4double GetOpticalFilterThreshold() const { return fOpticalFilterThreshold; }
+
+	// Scale the outputs by the signal expected from the filtered photons
+	void SetOpticalFilterCorrection(G4bool val) { fOpticalFilterCorrection = val; }
+	G4bool IsOpticalFilterCorrection() const { return fOpticalFilterCorrection; }
+
+	// Spectral response table ("x QE" per line, x in eV or nm)
+	void SetResponseMode(ResponseMode val) { fResponseMode = val; }
+	ResponseMode GetResponseMode() const { return fResponseMode; }
+
+	void SetResponseFile(const G4String& val) { fResponseFile = val; }
+	const G4String& GetResponseFile() const { return fResponseFile; }
+
+	void SetResponseWavelength(G4bool val) { fResponseWavelength = val; }
+	G4bool IsResponseWavelength() const { return fResponseWavelength; }
+
+	// Phase-space scoring plane
+	void SetPhaseSpaceEnabled(G4bool val) { fPhspEnabled = val; }
+	G4bool IsPhaseSpaceEnabled() const { return fPhspEnabled; }
+
+	void SetPhaseSpacePlaneZ(G4double val) { fPhspPlaneZ = val; }
+	G4double GetPhaseSpacePlaneZ() const { return fPhspPlaneZ; }
+
+	void SetPhaseSpaceFile(const G4String& val) { fPhspFile = val; }
+	const G4String& GetPhaseSpaceFile() const { return fPhspFile; }
+
+	void SetPhaseSpaceBufferSize(G4int val) { fPhspBufferSize = val; }
+	G4int GetPhaseSpaceBufferSize() const { return fPhspBufferSize; }
+
+	// Phase-space input replacing the GPS when not empty
+	void SetPhaseSpaceInput(const G4String& val) { fPhspInput = val; }
+	const G4String& GetPhaseSpaceInput() const { return fPhspInput; }
+
+	// Per-event dataset (primaries, deposit and photon maps, EventRecord.hh)
+	void SetEventOutputEnabled(G4bool val) { fEventOutput = val; }
+	G4bool IsEventOutputEnabled() const { return fEventOutput; }
+
+	void SetEventFile(const G4String& val) { fEventFile = val; }
+	const G4String& GetEventFile() const { return fEventFile; }
+
+	void SetEventEncoding(EventEncoding val) { fEventEncoding = val; }
+	EventEncoding GetEventEncoding() const { return fEventEncoding; }
+
+	// Bytes buffered per thread before writing
+	void SetEventBufferSize(size_t val) { fEventBufferSize = val; }
+	size_t GetEventBufferSize() const { return fEventBufferSize; }
+
+	// Base of the unique run directories (empty: current directory)
+	void SetOutputDirectory(const G4String& val) { fOutputDir = val; }
+	const G4String& GetOutputDirectory() const { return fOutputDir; }
+
+	// Merged outputs written by the master at end of run
+	void SetMapFile(const G4String& val) { fMapFile = val; }
+	const G4String& GetMapFile() const { return fMapFile; }
+
+	void SetSpectrumFile(const G4String& val) { fSpectrumFile = val; }
+	const G4String& GetSpectrumFile() const { return fSpectrumFile; }
+
+	// Per-event sums and sums of squares of the map, profiles, spectrum and
+	// total (event-level variances for scint_validate), empty to disable
+	void SetMomentsFile(const G4String& val) { fMomentsFile = val; }
+	const G4String& GetMomentsFile() const { return fMomentsFile; }
+
+	// Run container (RunFile) with all results of the run, empty to disable
+	void SetContainerFile(const G4String& val) { fContainerFile = val; }
+	const G4String& GetContainerFile() const { return fContainerFile; }
+
+	// Merged map and time map as binary PixelMap files instead of text
+	void SetBinaryOutput(G4bool val) { fBinaryOutput = val; }
+	G4bool IsBinaryOutput() const { return fBinaryOutput; }
+
+	// Outputs written by the background I/O thread, queue limit [MB]
+	void SetAsyncOutput(G4bool val) { fAsyncOutput = val; }
+	G4bool IsAsyncOutput() const { return fAsyncOutput; }
+
+	void SetAsyncQueueSize(G4double val) { fAsyncQueueSize = val; }
+	G4double GetAsyncQueueSize() const { return fAsyncQueueSize; }
+
+	// Compression of the outputs written through AsyncWriter, block size [bytes]
+	void SetCompression(BlockCodec val) { fCompression = val; }
+	BlockCodec GetCompression() const { return fCompression; }
+
+	void SetCompressionBlockSize(G4int val) { fCompressionBlockSize = val; }
+	G4int GetCompressionBlockSize() const { return fCompressionBlockSize; }
+
+	// Time-resolved map: frame period (0 disables) and number of frames
+	void SetFramePeriod(G4double val) { fFramePeriod = val; }
+	G4double GetFramePeriod() const { return fFramePeriod; }
+
+	void SetNumberOfFrames(G4int val) { fNFrames = val; }
+	G4int GetNumberOfFrames() const { return fNFrames; }
+
+	void SetTimeMapFile(const G4String& val) { fTimeMapFile = val; }
+	const G4String& GetTimeMapFile() const { return fTimeMapFile; }
+
+	// Checkpoints: every N events per worker and/or every T (0: off)
+	void SetCheckpointEvents(G4int val) { fCheckpointEvents = val; }
+	G4int GetCheckpointEvents() const { return fCheckpointEvents; }
+
+	void SetCheckpointInterval(G4double val) { fCheckpointInterval = val; }
+	G4double GetCheckpointInterval() const { return fCheckpointInterval; }
+
+	G4bool IsCheckpointEnabled() const { return fCheckpointEvents > 0 || fCheckpointInterval > 0.; }
+
+	void SetCheckpointDirectory(const G4String& val) { fCheckpointDir = val; }
+	const G4String& GetCheckpointDirectory() const { return fCheckpointDir; }
+
+	// Incremented on resume so worker files of the interrupted job are ignored
+	void SetCheckpointGeneration(G4int val) { fCheckpointGeneration = val; }
+	G4int GetCheckpointGeneration() const { return fCheckpointGeneration; }
+
+	// Monitoring socket (empty: off), downsampled map size and update period
+	void SetMonitorSocket(const G4String& val) { fMonitorSocket = val; }
+	const G4String& GetMonitorSocket() const { return fMonitorSocket; }
+
+	void SetMonitorMapSize(G4int val) { fMonitorMapSize = val; }
+	G4int GetMonitorMapSize() const { return fMonitorMapSize; }
+
+	void SetMonitorMapPeriod(G4int val) { fMonitorMapPeriod = val; }
+	G4int GetMonitorMapPeriod() const { return fMonitorMapPeriod; }
+
+	// End-of-run statistics (JSON), empty to disable
+	void SetStatisticsFile(const G4String& val) { fStatsFile = val; }
+	const G4String& GetStatisticsFile() const { return fStatsFile; }
+
+	// Stepping profiler
+	void SetProfilerEnabled(G4bool val) { fProfilerEnabled = val; }
+	G4bool IsProfilerEnabled() const { return fProfilerEnabled; }
+
+	void SetProfilerSamplePeriod(G4int val) { fProfilerSamplePeriod = val; }
+	G4int GetProfilerSamplePeriod() const { return fProfilerSamplePeriod; }
+
+	void SetProfilerMaxRows(G4int val) { fProfilerMaxRows = val; }
+	G4int GetProfilerMaxRows() const { return fProfilerMaxRows; }
+
+	// Pipeline
+	void SetPipelineStage(PipelineStage val) { fStage = val; }
+	PipelineStage GetPipelineStage() const { return fStage; }
+
+	void SetCacheDirectory(const G4String& val) { fCacheDir = val; }
+	const G4String& GetCacheDirectory() const { return fCacheDir; }
+
+	void SetSourceMacro(const G4String& val) { fSourceMacro = val; }
+	const G4String& GetSourceMacro() const { return fSourceMacro; }
+
+private:
+	SimulationConfig();
+
+	static SimulationConfig* fInstance;
+	SimulationMessenger* fMessenger;
+
+	G4int fNPixel;
+	ReadoutMode fReadout;
+	PixelLayout fPixelLayout;
+	G4double fSmartless;
+	G4String fPhantomFile;
+	G4bool fOpticalDefer;
+	OpticalTransport fOpticalTransport;
+	OpticalFilterMode fOpticalFilter;
+	G4double fOpticalFilterThreshold;
+	G4bool fOpticalFilterCorrection;
+
+	ResponseMode fResponseMode;
+	G4String fResponseFile;
+	G4bool fResponseWavelength;
+
+	G4bool fPhspEnabled;
+	G4double fPhspPlaneZ;
+	G4String fPhspFile;
+	G4int fPhspBufferSize;
+	G4String fPhspInput;
+
+	G4bool fEventOutput;
+	G4String fEventFile;
+	EventEncoding fEventEncoding;
+	size_t fEventBufferSize;
+
+	G4String fOutputDir;
+	G4String fMapFile;
+	G4String fSpectrumFile;
+	G4String fMomentsFile;
+	G4String fContainerFile;
+	G4bool fBinaryOutput;
+	G4String fStatsFile;
+	G4bool fAsyncOutput;
+	G4double fAsyncQueueSize;
+	BlockCodec fCompression;
+	G4int fCompressionBlockSize;
+
+	G4int fCheckpointEvents;
+	G4double fCheckpointInterval;
+	G4String fCheckpointDir;
+	G4int fCheckpointGeneration;
+
+	G4String fMonitorSocket;
+	G4int fMonitorMapSize;
+	G4int fMonitorMapPeriod;
+
+	G4double fFramePeriod;
+	G4int fNFrames;
+	G4String fTimeMapFile;
+
+	G4bool fProfilerEnabled;
+	G4int fProfilerSamplePeriod;
+	G4int fProfilerMaxRows;
+
+	PipelineStage fStage;
+	G4String fCacheDir;
+	G4String fSourceMacro;
+};
+
+#endif
@@ -0,0 +1,136 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef SimulationMessenger_hh_
+#define SimulationMessenger_hh_
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class SimulationConfig;
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithAString;
+class G4UIcmdWithADouble;
+class G4UIcmdWithADoubleAndUnit;
+
+// UI commands under /scint/ feeding SimulationConfig.
+// Commands are executed on the master only (not broadcast to workers).
+class SimulationMessenger: public G4UImessenger
+{
+public:
+	SimulationMessenger(SimulationConfig* config);
+	virtual ~SimulationMessenger();
+
+	virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+private:
+	// Key of the stage-1 result: source macro, phantom and scoring plane
+	G4String Stage1Key() const;
+	void PipelineBeamOn(G4int nEvents);
+
+	SimulationConfig* fConfig;
+
+	G4UIdirectory* fScintDir;
+
+	G4UIdirectory* fDetDir;
+	G4UIcmdWithAnInteger* fPixelsCmd;
+	G4UIcmdWithAString* fReadoutCmd;
+	G4UIcmdWithAString* fLayoutCmd;
+	G4UIcmdWithADouble* fSmartlessCmd;
+	G4UIcmdWithAString* fPhantomCmd;
+
+	G4UIdirectory* fOpticalDir;
+	G4UIcmdWithABool* fDeferCmd;
+	G4UIcmdWithAString* fTransportCmd;
+	G4UIcmdWithAString* fFilterCmd;
+	G4UIcmdWithADouble* fFilterThresholdCmd;
+	G4UIcmdWithABool* fFilterCorrectionCmd;
+
+	G4UIdirectory* fResponseDir;
+	G4UIcmdWithAString* fResponseModeCmd;
+	G4UIcmdWithAString* fResponseFileCmd;
+	G4UIcmdWithAString* fResponseUnitCmd;
+
+	G4UIdirectory* fPhspDir;
+	G4UIcmdWithABool* fPhspEnableCmd;
+	G4UIcmdWithADoubleAndUnit* fPhspPlaneZCmd;
+	G4UIcmdWithAString* fPhspFileCmd;
+	G4UIcmdWithAnInteger* fPhspBufferCmd;
+	G4UIcmdWithAString* fPhspInputCmd;
+
+	G4UIdirectory* fEventDir;
+	G4UIcmdWithABool* fEventEnableCmd;
+	G4UIcmdWithAString* fEventFileCmd;
+	G4UIcmdWithAString* fEventEncodingCmd;
+	G4UIcmdWithADouble* fEventBufferCmd;
+
+	G4UIdirectory* fOutputDir;
+	G4UIcmdWithAString* fOutputDirCmd;
+	G4UIcmdWithAString* fMapFileCmd;
+	G4UIcmdWithAString* fSpectrumFileCmd;
+	G4UIcmdWithAString* fMomentsFileCmd;
+	G4UIcmdWithAString* fContainerFileCmd;
+	G4UIcmdWithAString* fFormatCmd;
+	G4UIcmdWithAString* fStatsFileCmd;
+	G4UIcmdWithAString* fTimeMapFileCmd;
+	G4UIcmdWithABool* fAsyncCmd;
+	G4UIcmdWithADouble* fAsyncQueueCmd;
+	G4UIcmdWithAString* fCompressionCmd;
+	G4UIcmdWithAnInteger* fCompressionBlockCmd;
+
+	G4UIdirectory* fTimeDir;
+	G4UIcmdWithADoubleAndUnit* fFramePeriodCmd;
+	G4UIcmdWithAnInteger* fFramesCmd;
+
+	G4UIdirectory* fCheckpointDir;
+	G4UIcmdWithAnInteger* fCheckpointEventsCmd;
+	G4UIcmdWithADoubleAndUnit* fCheckpointIntervalCmd;
+	G4UIcmdWithAString* fCheckpointDirCmd;
+	G4UIcmdWithAnInteger* fResumeCmd;
+
+	G4UIdirectory* fMonitorDir;
+	G4UIcmdWithAString* fMonitorSocketCmd;
+	G4UIcmdWithAnInteger* fMonitorMapSizeCmd;
+	G4UIcmdWithAnInteger* fMonitorMapPeriodCmd;
+
+	G4UIdirectory* fProfileDir;
+	G4UIcmdWithABool* fProfileEnableCmd;
+	G4UIcmdWithAnInteger* fProfilePeriodCmd;
+	G4UIcmdWithAnInteger* fProfileRowsCmd;
+
+	G4UIdirectory* fPipelineDir;
+	G4UIcmdWithAString* fStageCmd;
+	G4UIcmdWithAString* fCacheDirCmd;
+	G4UIcmdWithAString* fSourceMacroCmd;
+	G4UIcmdWithAnInteger* fPipelineBeamOnCmd;
+};
+
+#endif
@@ -0,0 +1,98 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef SlabTransport_hh_
+#define SlabTransport_hh_
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <vector>
+
+class G4MaterialPropertyVector;
+
+// Analytic transport of optical photons to the readout face of the panel
+// (/scint/optical/transport analytic, face readout only).
+//
+// The panel is a homogeneous box without scattering, wrapped with a
+// specular reflector of reflectivity R(E) on every face but the readout
+// face, so a photon path is a straight line in the space unfolded at the
+// reflecting faces. The photons of one event are kept as a structure of
+// arrays and propagated in one branch-free loop: path length to the
+// readout face, number of reflections, exit pixel, arrival time and the
+// survival weight R^nReflections * exp(-L/ABSLENGTH).
+class SlabTransport
+{
+public:
+	SlabTransport();
+	~SlabTransport();
+
+	// Reads the panel, its material and the wrap from the detector construction
+	void Initialize(G4int nPixel);
+	G4bool IsInitialized() const { return fInitialized; }
+
+	// Adds a photon to the batch; false when it is outside the panel
+	G4bool Add(const G4ThreeVector& pos, const G4ThreeVector& dir, G4double energy, G4double time);
+
+	// Propagates the batch; results are valid until the next Clear()
+	void Propagate();
+
+	size_t GetSize() const { return fX.size(); }
+	G4int GetPixelY(size_t i) const { return fPixelY[i]; }
+	G4int GetPixelX(size_t i) const { return fPixelX[i]; }
+	G4double GetEnergy(size_t i) const { return fEnergy[i]; }
+	G4double GetArrivalTime(size_t i) const { return fArrival[i]; }
+	G4double GetWeight(size_t i) const { return fWeight[i]; }
+
+	void Clear();
+
+	// Capacity of the batch arrays
+	size_t GetMemoryBytes() const;
+
+private:
+	G4bool fInitialized;
+	G4int fNPixel;
+	G4double fMinX, fMinY, fMinZ, fMaxZ;
+	G4double fSizeX, fSizeY, fSizeZ;
+
+	const G4MaterialPropertyVector* fRIndex;
+	const G4MaterialPropertyVector* fAbsLength;
+	const G4MaterialPropertyVector* fReflectivity;
+
+	// Input, one entry per photon
+	std::vector<G4double> fX, fY, fZ, fDx, fDy, fDz;
+	std::vector<G4double> fEnergy, fTime;
+	std::vector<G4double> fInvAbsLength, fLogReflectivity, fInvVelocity;
+
+	// Output
+	std::vector<G4double> fArrival, fWeight;
+	std::vector<G4int> fPixelY, fPixelX;
+};
+
+#endif
@@ -0,0 +1,76 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef SpectralResponse_hh_
+#define SpectralResponse_hh_
+
+#include "globals.hh"
+
+#include <vector>
+
+// Spectral response of the photodiode (quantum efficiency) folded into
+// the scoring (/scint/response/).
+//
+// The table is read from a text file ("energy QE" or "wavelength QE"
+// per line, '#' comments) and resampled by the master at the start of
+// every run on a uniform grid spanning the scintillator emission grid
+// (RINDEX of the panel material), so the workers look up a photon with
+// one multiplication. Outside the measured range the response is 0.
+class SpectralResponse
+{
+public:
+	static SpectralResponse* Instance();
+
+	// Master, before the event loop; fatal when the file cannot be read
+	void Build(const G4String& fileName, G4bool wavelength);
+	G4bool IsBuilt() const { return !fTable.empty(); }
+	size_t GetMemoryBytes() const { return fTable.capacity()*sizeof(G4double); }
+
+	inline G4double Value(G4double energy) const
+	{
+		G4int bin = G4int((energy - fEmin)*fInvStep);
+		if(bin < 0) bin = 0;
+		else if(bin >= fNBins) bin = fNBins - 1;
+		return fTable[bin];
+	}
+
+	// Mean response over the emission grid (report)
+	G4double GetMean() const;
+
+private:
+	SpectralResponse();
+
+	static SpectralResponse fInstance;
+
+	G4int fNBins;
+	G4double fEmin, fInvStep;
+	std::vector<G4double> fTable;
+};
+
+#endif
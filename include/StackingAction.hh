@@ -0,0 +1,66 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef StackingAction_hh_
+#define StackingAction_hh_
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+#include "OpticalFilter.hh"
+
+class RunAction;
+class SensitiveDetector;
+class G4ParticleDefinition;
+
+// Optical photons are deferred to the waiting stack, so the charged
+// particles of an event are tracked first and the photons afterwards as
+// one batch. With face readout, photons that cannot reach the readout
+// face are killed at creation (/scint/optical/filter cull), and with the
+// analytic transport all photons in the panel are handed to the detector.
+class StackingAction: public G4UserStackingAction
+{
+public:
+	StackingAction(RunAction* runAction);
+	virtual ~StackingAction();
+
+	virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* aTrack);
+	virtual void PrepareNewEvent();
+
+	// Predictions of the current event (validation mode)
+	const OpticalFilter& GetOpticalFilter() const { return fFilter; }
+
+private:
+	RunAction* fRunAction;
+	OpticalFilter fFilter;
+	G4bool fFilterReady;
+	SensitiveDetector* fDetector;
+	const G4ParticleDefinition* fOpticalPhoton;
+};
+
+#endif
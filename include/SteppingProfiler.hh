@@ -0,0 +1,134 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef SteppingProfiler_hh_
+#define SteppingProfiler_hh_
+
+#include "globals.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4StepPoint.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include <map>
+#include <vector>
+#include <time.h>
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4VProcess;
+
+// Step counts and sampled time per (logical volume, particle, process).
+// Every step is counted; every samplePeriod-th step the wall time until the
+// next step is measured and attributed, scaled by the period, to that step.
+class SteppingProfiler
+{
+public:
+	struct Entry
+	{
+		Entry() : nSteps(0), nSamples(0), time(0.) {}
+		G4long nSteps;
+		G4long nSamples;
+		G4double time;   // s, estimated
+	};
+
+	SteppingProfiler(G4int samplePeriod);
+	~SteppingProfiler();
+
+	inline void Fill(const G4Step* aStep)
+	{
+		const G4StepPoint* pre = aStep->GetPreStepPoint();
+		const G4LogicalVolume* volume = pre->GetPhysicalVolume()->GetLogicalVolume();
+		const G4ParticleDefinition* particle = aStep->GetTrack()->GetParticleDefinition();
+		const G4VProcess* process = aStep->GetPostStepPoint()->GetProcessDefinedStep();
+
+		// Consecutive steps mostly share the same key
+		if(!fLast || volume != fLastKey.volume || particle != fLastKey.particle || process != fLastKey.process)
+		{
+			fLastKey.volume = volume;
+			fLastKey.particle = particle;
+			fLastKey.process = process;
+			fLast = &fLocal[fLastKey];
+		}
+		fLast->nSteps++;
+
+		if(fArmed)
+		{
+			fLast->time += (Now() - fT0)*fPeriod;
+			fLast->nSamples++;
+			fArmed = false;
+		}
+		if(--fCountdown == 0)
+		{
+			fCountdown = fPeriod;
+			fArmed = true;
+			fT0 = Now();
+		}
+	}
+
+	// Used by Run::Merge; entries are matched by name across threads
+	void Merge(const SteppingProfiler& other);
+	void Print(G4int maxRows) const;
+
+private:
+	struct Key
+	{
+		const G4LogicalVolume* volume;
+		const G4ParticleDefinition* particle;
+		const G4VProcess* process;
+		bool operator<(const Key& k) const
+		{
+			if(volume != k.volume) return volume < k.volume;
+			if(particle != k.particle) return particle < k.particle;
+			return process < k.process;
+		}
+	};
+
+	static inline G4double Now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + 1e-9*ts.tv_nsec;
+	}
+
+	void FoldInto(std::map<G4String, Entry>& named) const;
+
+	std::map<Key, Entry> fLocal;
+	std::map<G4String, Entry> fNamed;
+
+	Key fLastKey;
+	Entry* fLast;
+
+	G4int fPeriod;
+	G4int fCountdown;
+	G4bool fArmed;
+	G4double fT0;
+};
+
+#endif
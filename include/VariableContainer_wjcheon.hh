@@ -6,3 +6,8 @@
 
 #define REPLICA_NUM  100
 
+// Optical photon spectrum scored per run (covers the DRZ-High emission grid)
+#define SPECTRUM_BINS  230
+#define SPECTRUM_EMIN  (1.9*eV)
+#define SPECTRUM_EMAX  (4.2*eV)
+
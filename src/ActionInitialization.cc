@@ -30,6 +30,9 @@
 
 #include "ActionInitialization.hh"
 #include "PrimaryGeneratorAction.hh"
+#include "RunAction.hh"
+#include "SteppingAction.hh"
+#include "StackingAction.hh"
 
 ActionInitialization::ActionInitialization()
 :G4VUserActionInitialization()
@@ -44,10 +47,15 @@ ActionInitialization::~ActionInitialization()
 
 void ActionInitialization::BuildForMaster() const
 {
-
+	SetUserAction(new RunAction);
 }
 
 void ActionInitialization::Build() const
 {
 	SetUserAction(new PrimaryGeneratorAction);
+
+	RunAction* runAction = new RunAction;
+	SetUserAction(runAction);
+	SetUserAction(new SteppingAction(runAction));
+	SetUserAction(new StackingAction(runAction));
 }
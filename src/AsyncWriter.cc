@@ -0,0 +1,297 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "AsyncWriter.hh"
+
+#include <time.h>
+
+namespace
+{
+	G4double WallClock()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + 1e-9*ts.tv_nsec;
+	}
+}
+
+AsyncWriter AsyncWriter::fInstance;
+
+AsyncWriter* AsyncWriter::Instance()
+{
+	return &fInstance;
+}
+
+AsyncWriter::AsyncWriter()
+:fQueuedBytes(0), fMaxQueueBytes(0), fBusy(false), fStop(false), fRunning(false),
+ fCodec(kCodecStored), fBlockSize(1 << 20),
+ fBytesWritten(0.), fBytesStored(0.), fMaxQueued(0.), fProducerWait(0.), fWriteTime(0.), fBuffersWritten(0)
+{}
+
+AsyncWriter::~AsyncWriter()
+{
+	Stop();
+}
+
+void AsyncWriter::Start(G4double queueMB)
+{
+	Stop();
+
+	fMaxQueueBytes = size_t(queueMB*1024.*1024.);
+	fBytesWritten = fBytesStored = fMaxQueued = fProducerWait = fWriteTime = 0.;
+	fBuffersWritten = 0;
+	fStop = false;
+	fRunning = true;
+	fThread = std::thread(&AsyncWriter::Loop, this);
+}
+
+void AsyncWriter::SetCompression(BlockCodec codec, size_t blockSize)
+{
+	fCodec = codec;
+	fBlockSize = blockSize;
+}
+
+void AsyncWriter::Stop()
+{
+	if(fRunning)
+	{
+		// The I/O thread drains the queue before it exits
+		{
+			std::lock_guard<std::mutex> lock(fMutex);
+			fStop = true;
+		}
+		fNotEmpty.notify_all();
+		fThread.join();
+		fRunning = false;
+	}
+	Flush();
+}
+
+void AsyncWriter::Flush()
+{
+	if(fRunning)
+	{
+		std::unique_lock<std::mutex> lock(fMutex);
+		fDrained.wait(lock, [this]{ return fQueue.empty() && !fBusy; });
+	}
+	else
+	{
+		// Files left open by a writer that never called Close()
+		std::lock_guard<std::mutex> lock(fMutex);
+		CloseAll();
+	}
+
+	std::vector<std::string> errors;
+	{
+		std::lock_guard<std::mutex> lock(fErrorMutex);
+		errors.swap(fErrors);
+	}
+	for(size_t i=0;i<errors.size();i++)
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot write " << errors[i];
+		G4Exception("AsyncWriter::Flush()", "Aio001", JustWarning, ed);
+	}
+}
+
+void AsyncWriter::WriteFile(const G4String& fileName, std::string& data)
+{
+	Submit(kReplace, fileName, data);
+}
+
+void AsyncWriter::Append(const G4String& fileName, std::string& data)
+{
+	Submit(kAppend, fileName, data);
+}
+
+void AsyncWriter::Close(const G4String& fileName)
+{
+	std::string none;
+	Submit(kClose, fileName, none);
+}
+
+void AsyncWriter::Submit(Kind kind, const G4String& fileName, std::string& data)
+{
+	Request request;
+	request.kind = kind;
+	request.fileName = fileName;
+	request.data.swap(data);
+
+	if(!fRunning)
+	{
+		// Synchronous: callers may be several workers
+		std::lock_guard<std::mutex> lock(fMutex);
+		Execute(request);
+		return;
+	}
+
+	const size_t nBytes = request.data.size();
+	std::unique_lock<std::mutex> lock(fMutex);
+	// A buffer larger than the whole queue is accepted once the queue is empty
+	if(fQueuedBytes > 0 && fQueuedBytes + nBytes > fMaxQueueBytes)
+	{
+		const G4double start = WallClock();
+		fNotFull.wait(lock, [this, nBytes]{ return fQueuedBytes == 0 || fQueuedBytes + nBytes <= fMaxQueueBytes; });
+		fProducerWait += WallClock() - start;
+	}
+	fQueue.push_back(Request());
+	fQueue.back().kind = request.kind;
+	fQueue.back().fileName.swap(request.fileName);
+	fQueue.back().data.swap(request.data);
+	fQueuedBytes += nBytes;
+	if(fQueuedBytes > fMaxQueued) fMaxQueued = fQueuedBytes;
+	lock.unlock();
+	fNotEmpty.notify_one();
+}
+
+void AsyncWriter::Loop()
+{
+	std::unique_lock<std::mutex> lock(fMutex);
+	for(;;)
+	{
+		if(fQueue.empty())
+		{
+			fDrained.notify_all();
+			if(fStop) break;
+			fNotEmpty.wait(lock);
+			continue;
+		}
+
+		Request request;
+		request.kind = fQueue.front().kind;
+		request.fileName.swap(fQueue.front().fileName);
+		request.data.swap(fQueue.front().data);
+		fQueue.pop_front();
+		fBusy = true;
+		lock.unlock();
+
+		const size_t nBytes = request.data.size();
+		const G4double start = WallClock();
+		Execute(request);
+		const G4double elapsed = WallClock() - start;
+
+		lock.lock();
+		fWriteTime += elapsed;
+		fQueuedBytes -= nBytes;
+		fBusy = false;
+		fNotFull.notify_all();
+	}
+}
+
+void AsyncWriter::Execute(Request& request)
+{
+	std::map<std::string, OpenFile>::iterator it = fOpen.find(request.fileName);
+	const size_t nBytes = request.data.size();
+	G4bool ok = true;
+
+	// Compressed on this thread: the framed form replaces the data
+	std::string packed;
+	const std::string* out = &request.data;
+	if(fCodec != kCodecStored) out = &packed;
+
+	if(request.kind == kReplace)
+	{
+		if(fCodec != kCodecStored)
+		{
+			BlockWriter writer(fCodec, fBlockSize);
+			writer.Write(request.data.data(), nBytes, packed);
+			writer.Finish(packed);
+		}
+		const std::string tmpName = request.fileName + ".tmp";
+		FILE* file = fopen(tmpName.c_str(), "wb");
+		ok = file && fwrite(out->data(), 1, out->size(), file) == out->size();
+		ok = (file && fclose(file) == 0) && ok;
+		ok = ok && rename(tmpName.c_str(), request.fileName.c_str()) == 0;
+	}
+	else if(request.kind == kAppend)
+	{
+		if(it == fOpen.end())
+		{
+			OpenFile open = { fopen(request.fileName.c_str(), "wb"), 0 };
+			if(open.file)
+			{
+				if(fCodec != kCodecStored) open.writer = new BlockWriter(fCodec, fBlockSize);
+				it = fOpen.insert(std::make_pair(request.fileName, open)).first;
+			}
+		}
+		out = &request.data;
+		if(it != fOpen.end() && it->second.writer)
+		{
+			it->second.writer->Write(request.data.data(), nBytes, packed);
+			out = &packed;
+		}
+		ok = it != fOpen.end() && fwrite(out->data(), 1, out->size(), it->second.file) == out->size();
+	}
+	else if(it != fOpen.end())
+	{
+		ok = CloseFile(it->second);
+		fOpen.erase(it);
+	}
+
+	if(ok)
+	{
+		fBytesWritten += nBytes;
+		fBytesStored += out->size();
+		if(request.kind != kClose) fBuffersWritten++;
+	}
+	else
+	{
+		// Reported once per file by Flush()
+		std::lock_guard<std::mutex> lock(fErrorMutex);
+		if(fErrors.empty() || fErrors.back() != request.fileName) fErrors.push_back(request.fileName);
+	}
+}
+
+G4bool AsyncWriter::CloseFile(OpenFile& open)
+{
+	G4bool ok = true;
+	if(open.writer)
+	{
+		// Last block, block index and footer
+		std::string packed;
+		open.writer->Finish(packed);
+		ok = fwrite(packed.data(), 1, packed.size(), open.file) == packed.size();
+		fBytesStored += packed.size();
+		delete open.writer;
+	}
+	return (fclose(open.file) == 0) && ok;
+}
+
+void AsyncWriter::CloseAll()
+{
+	for(std::map<std::string, OpenFile>::iterator it=fOpen.begin();it!=fOpen.end();++it)
+	{
+		if(!CloseFile(it->second))
+		{
+			std::lock_guard<std::mutex> lock(fErrorMutex);
+			fErrors.push_back(it->first);
+		}
+	}
+	fOpen.clear();
+}
@@ -0,0 +1,582 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "BlockFile.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef SCINT_USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SCINT_USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+	uint32_t Adler32(const char* data, size_t n)
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+		uint32_t a = 1, b = 0;
+		while(n > 0)
+		{
+			// Largest run without overflow of b before the modulo
+			size_t run = std::min(n, size_t(5552));
+			n -= run;
+			while(run--)
+			{
+				a += *p++;
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	inline uint32_t Load32(const char* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline void PutLength(size_t n, std::string& out)
+	{
+		for(;n >= 255;n -= 255) out.push_back(char(255));
+		out.push_back(char(n));
+	}
+
+	// Built-in codec: LZ77 with a 64 kB window. Sequences of
+	//   token (literal length << 4 | match length - 4), [length bytes],
+	//   literals, offset (2 bytes LE), [length bytes]
+	// where a nibble of 15 continues with bytes of 255 up to the last one;
+	// the final sequence has literals only.
+	const int kHashBits = 14;
+	const size_t kMinMatch = 4;
+
+	void EmitSequence(const char* literals, size_t nLiterals, size_t offset, size_t matchLength, std::string& out)
+	{
+		const size_t extra = matchLength ? matchLength - kMinMatch : 0;
+		out.push_back(char((std::min(nLiterals, size_t(15)) << 4) | std::min(extra, size_t(15))));
+		if(nLiterals >= 15) PutLength(nLiterals - 15, out);
+		out.append(literals, nLiterals);
+		if(matchLength == 0) return;
+		out.push_back(char(offset & 0xff));
+		out.push_back(char(offset >> 8));
+		if(extra >= 15) PutLength(extra - 15, out);
+	}
+
+	void LzCompress(const char* src, size_t n, std::string& out)
+	{
+		std::vector<uint32_t> table(size_t(1) << kHashBits, 0xffffffffu);
+		size_t anchor = 0, i = 0;
+		while(i + kMinMatch <= n)
+		{
+			const uint32_t sequence = Load32(src + i);
+			const uint32_t h = (sequence*2654435761u) >> (32 - kHashBits);
+			const uint32_t ref = table[h];
+			table[h] = uint32_t(i);
+			if(ref == 0xffffffffu || i - ref > 65535 || Load32(src + ref) != sequence)
+			{
+				// Skip faster through data that does not compress
+				i += 1 + ((i - anchor) >> 6);
+				continue;
+			}
+
+			size_t length = kMinMatch;
+			while(i + length < n && src[ref + length] == src[i + length]) length++;
+			EmitSequence(src + anchor, i - anchor, i - ref, length, out);
+			i += length;
+			anchor = i;
+		}
+		EmitSequence(src + anchor, n - anchor, 0, 0, out);
+	}
+
+	bool GetLength(const unsigned char*& p, const unsigned char* end, size_t& n)
+	{
+		for(;;)
+		{
+			if(p >= end) return false;
+			const unsigned char b = *p++;
+			n += b;
+			if(b != 255) return true;
+		}
+	}
+
+	bool LzDecompress(const char* src, size_t n, char* dst, size_t rawSize)
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+		const unsigned char* end = p + n;
+		size_t op = 0;
+		while(p < end)
+		{
+			const unsigned char token = *p++;
+			size_t nLiterals = token >> 4;
+			if(nLiterals == 15 && !GetLength(p, end, nLiterals)) return false;
+			if(nLiterals > size_t(end - p) || nLiterals > rawSize - op) return false;
+			memcpy(dst + op, p, nLiterals);
+			p += nLiterals;
+			op += nLiterals;
+			if(p == end) break;
+
+			if(end - p < 2) return false;
+			const size_t offset = p[0] | (size_t(p[1]) << 8);
+			p += 2;
+			size_t length = token & 15;
+			if(length == 15 && !GetLength(p, end, length)) return false;
+			length += kMinMatch;
+			if(offset == 0 || offset > op || length > rawSize - op) return false;
+			// Byte by byte: the match may overlap its own output
+			const char* from = dst + op - offset;
+			for(size_t k=0;k<length;k++) dst[op + k] = from[k];
+			op += length;
+		}
+		return op == rawSize;
+	}
+
+	// Packed form of one block; false when the codec cannot be used
+	bool Compress(BlockCodec codec, const char* data, size_t n, std::string& packed)
+	{
+		packed.clear();
+		switch(codec)
+		{
+		case kCodecBuiltin:
+			LzCompress(data, n, packed);
+			return true;
+		#ifdef SCINT_USE_ZLIB
+		case kCodecZlib:
+		{
+			// Fastest level: the outputs are written by a single I/O thread
+			uLongf size = compressBound(uLong(n));
+			packed.resize(size);
+			if(compress2(reinterpret_cast<Bytef*>(&packed[0]), &size,
+					reinterpret_cast<const Bytef*>(data), uLong(n), 1) != Z_OK) return false;
+			packed.resize(size);
+			return true;
+		}
+		#endif
+		#ifdef SCINT_USE_ZSTD
+		case kCodecZstd:
+		{
+			size_t size = ZSTD_compressBound(n);
+			packed.resize(size);
+			size = ZSTD_compress(&packed[0], size, data, n, 1);
+			if(ZSTD_isError(size)) return false;
+			packed.resize(size);
+			return true;
+		}
+		#endif
+		default:
+			return false;
+		}
+	}
+
+	bool Decompress(uint32_t codec, const char* packed, size_t n, char* data, size_t rawSize)
+	{
+		switch(codec)
+		{
+		case kCodecStored:
+			if(n != rawSize) return false;
+			memcpy(data, packed, n);
+			return true;
+		case kCodecBuiltin:
+			return LzDecompress(packed, n, data, rawSize);
+		#ifdef SCINT_USE_ZLIB
+		case kCodecZlib:
+		{
+			uLongf size = uLongf(rawSize);
+			return uncompress(reinterpret_cast<Bytef*>(data), &size,
+					reinterpret_cast<const Bytef*>(packed), uLong(n)) == Z_OK && size == rawSize;
+		}
+		#endif
+		#ifdef SCINT_USE_ZSTD
+		case kCodecZstd:
+			return ZSTD_decompress(data, rawSize, packed, n) == rawSize;
+		#endif
+		default:
+			return false;
+		}
+	}
+
+	bool ReadAt(int fd, uint64_t offset, char* data, size_t n)
+	{
+		while(n > 0)
+		{
+			ssize_t got = pread(fd, data, n, off_t(offset));
+			if(got <= 0) return false;
+			data += got;
+			offset += got;
+			n -= got;
+		}
+		return true;
+	}
+}
+
+bool IsBlockCodecAvailable(BlockCodec codec)
+{
+	switch(codec)
+	{
+	case kCodecStored:
+	case kCodecBuiltin:
+		return true;
+	#ifdef SCINT_USE_ZLIB
+	case kCodecZlib:
+		return true;
+	#endif
+	#ifdef SCINT_USE_ZSTD
+	case kCodecZstd:
+		return true;
+	#endif
+	default:
+		return false;
+	}
+}
+
+const char* GetBlockCodecName(BlockCodec codec)
+{
+	switch(codec)
+	{
+	case kCodecStored: return "none";
+	case kCodecBuiltin: return "builtin";
+	case kCodecZlib: return "zlib";
+	case kCodecZstd: return "zstd";
+	}
+	return "unknown";
+}
+
+bool ParseBlockCodec(const std::string& name, BlockCodec& codec)
+{
+	if(name == "stored")
+	{
+		codec = kCodecStored;
+		return true;
+	}
+	for(int c=kCodecStored;c<=kCodecZstd;c++)
+	{
+		if(name == GetBlockCodecName(BlockCodec(c)))
+		{
+			codec = BlockCodec(c);
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string GetBlockCodecNames()
+{
+	std::string names;
+	for(int c=kCodecStored;c<=kCodecZstd;c++)
+	{
+		if(!IsBlockCodecAvailable(BlockCodec(c))) continue;
+		if(!names.empty()) names += ", ";
+		names += GetBlockCodecName(BlockCodec(c));
+	}
+	return names;
+}
+
+BlockWriter::BlockWriter(BlockCodec codec, size_t blockSize)
+:fCodec(codec), fBlockSize(std::max(std::min(blockSize, size_t(1) << 30), size_t(4096))),
+ fOffset(0), fRawSize(0)
+{}
+
+void BlockWriter::Begin(std::string& out)
+{
+	BlockFileHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, BLOCKFILE_MAGIC, sizeof(header.magic));
+	header.version = BLOCKFILE_VERSION;
+	header.codec = fCodec;
+	header.blockSize = fBlockSize;
+	out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	fOffset = sizeof(header);
+}
+
+void BlockWriter::WriteBlock(const char* data, size_t n, std::string& out)
+{
+	BlockHeader block;
+	block.rawSize = uint32_t(n);
+	block.checksum = Adler32(data, n);
+	const bool packed = Compress(fCodec, data, n, fPacked) && fPacked.size() < n;
+	block.codec = packed ? fCodec : kCodecStored;
+	block.packedSize = uint32_t(packed ? fPacked.size() : n);
+
+	BlockIndexEntry entry = { fOffset, fRawSize };
+	fIndex.push_back(entry);
+	out.append(reinterpret_cast<const char*>(&block), sizeof(block));
+	out.append(packed ? fPacked.data() : data, block.packedSize);
+	fOffset += sizeof(block) + block.packedSize;
+	fRawSize += n;
+}
+
+void BlockWriter::Write(const char* data, size_t n, std::string& out)
+{
+	if(fOffset == 0) Begin(out);
+
+	// Complete the pending block first, then whole blocks straight from data
+	if(!fPending.empty())
+	{
+		const size_t take = std::min(n, fBlockSize - fPending.size());
+		fPending.append(data, take);
+		data += take;
+		n -= take;
+		if(fPending.size() < fBlockSize) return;
+		WriteBlock(fPending.data(), fPending.size(), out);
+		fPending.clear();
+	}
+	for(;n >= fBlockSize;data += fBlockSize, n -= fBlockSize) WriteBlock(data, fBlockSize, out);
+	fPending.append(data, n);
+}
+
+void BlockWriter::Finish(std::string& out)
+{
+	if(fOffset == 0) Begin(out);
+	if(!fPending.empty()) WriteBlock(fPending.data(), fPending.size(), out);
+	fPending.clear();
+
+	BlockFileFooter footer;
+	memset(&footer, 0, sizeof(footer));
+	footer.indexOffset = fOffset;
+	footer.nBlocks = fIndex.size();
+	footer.rawSize = fRawSize;
+	strncpy(footer.magic, BLOCKFILE_INDEX_MAGIC, sizeof(footer.magic));
+	if(!fIndex.empty())
+		out.append(reinterpret_cast<const char*>(&fIndex[0]), fIndex.size()*sizeof(BlockIndexEntry));
+	out.append(reinterpret_cast<const char*>(&footer), sizeof(footer));
+	fOffset += fIndex.size()*sizeof(BlockIndexEntry) + sizeof(footer);
+}
+
+BlockReader::BlockReader()
+:fFd(-1), fCompressed(false), fBase(0), fSize(0), fStoredSize(0), fTruncated(0), fCached(size_t(-1))
+{
+	memset(&fHeader, 0, sizeof(fHeader));
+}
+
+BlockReader::~BlockReader()
+{
+	Close();
+}
+
+void BlockReader::Close()
+{
+	if(fFd >= 0) close(fFd);
+	fFd = -1;
+	fCompressed = false;
+	fBase = fSize = fStoredSize = fTruncated = 0;
+	memset(&fHeader, 0, sizeof(fHeader));
+	fIndex.clear();
+	fCached = size_t(-1);
+}
+
+bool BlockReader::Open(const std::string& fileName, std::string& error)
+{
+	return Open(fileName, 0, uint64_t(-1), error);
+}
+
+bool BlockReader::Open(const std::string& fileName, uint64_t offset, uint64_t size, std::string& error)
+{
+	Close();
+	fFileName = fileName;
+	fFd = open(fileName.c_str(), O_RDONLY);
+	struct stat st;
+	if(fFd < 0 || fstat(fFd, &st) != 0 || offset > uint64_t(st.st_size))
+	{
+		error = "cannot open " + fileName;
+		Close();
+		return false;
+	}
+
+	fBase = offset;
+	fStoredSize = std::min(size, uint64_t(st.st_size) - offset);
+	fCompressed = fStoredSize >= sizeof(fHeader) && Fetch(0, reinterpret_cast<char*>(&fHeader), sizeof(fHeader))
+			&& strncmp(fHeader.magic, BLOCKFILE_MAGIC, sizeof(fHeader.magic)) == 0;
+	if(!fCompressed)
+	{
+		memset(&fHeader, 0, sizeof(fHeader));
+		fSize = fStoredSize;
+		return true;
+	}
+	if(fHeader.version != BLOCKFILE_VERSION || !ReadIndex(fStoredSize))
+	{
+		error = fileName + ": corrupt block index";
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool BlockReader::Fetch(uint64_t offset, char* data, size_t n) const
+{
+	return ReadAt(fFd, fBase + offset, data, n);
+}
+
+bool BlockReader::ReadIndex(uint64_t fileSize)
+{
+	BlockFileFooter footer;
+	if(fileSize >= sizeof(BlockFileHeader) + sizeof(footer)
+			&& Fetch(fileSize - sizeof(footer), reinterpret_cast<char*>(&footer), sizeof(footer))
+			&& strncmp(footer.magic, BLOCKFILE_INDEX_MAGIC, sizeof(footer.magic)) == 0
+			&& footer.indexOffset + footer.nBlocks*sizeof(BlockIndexEntry) + sizeof(footer) == fileSize)
+	{
+		fIndex.resize(footer.nBlocks);
+		fSize = footer.rawSize;
+		return footer.nBlocks == 0
+				|| Fetch(footer.indexOffset, reinterpret_cast<char*>(&fIndex[0]), footer.nBlocks*sizeof(BlockIndexEntry));
+	}
+
+	// No footer: walk the complete blocks
+	uint64_t offset = sizeof(BlockFileHeader);
+	fSize = 0;
+	BlockHeader block;
+	while(offset + sizeof(block) <= fileSize && Fetch(offset, reinterpret_cast<char*>(&block), sizeof(block))
+			&& offset + sizeof(block) + block.packedSize <= fileSize)
+	{
+		BlockIndexEntry entry = { offset, fSize };
+		fIndex.push_back(entry);
+		offset += sizeof(block) + block.packedSize;
+		fSize += block.rawSize;
+	}
+	fTruncated = fileSize - offset;
+	return true;
+}
+
+size_t BlockReader::GetRawBlockSize(size_t k) const
+{
+	return (k + 1 < fIndex.size() ? fIndex[k+1].rawOffset : fSize) - fIndex[k].rawOffset;
+}
+
+bool BlockReader::DecodeBlock(size_t k, char* data, std::string& packed, std::string& error) const
+{
+	BlockHeader block;
+	if(!Fetch(fIndex[k].offset, reinterpret_cast<char*>(&block), sizeof(block))
+			|| block.rawSize != GetRawBlockSize(k))
+	{
+		error = fFileName + ": truncated block";
+		return false;
+	}
+	packed.resize(block.packedSize);
+	if((block.packedSize > 0 && !Fetch(fIndex[k].offset + sizeof(block), &packed[0], block.packedSize))
+			|| !Decompress(block.codec, packed.data(), block.packedSize, data, block.rawSize)
+			|| Adler32(data, block.rawSize) != block.checksum)
+	{
+		error = fFileName + ": " + (IsBlockCodecAvailable(BlockCodec(block.codec))
+				? "corrupt block" : std::string("codec not built in: ") + GetBlockCodecName(BlockCodec(block.codec)));
+		return false;
+	}
+	return true;
+}
+
+bool BlockReader::Read(uint64_t offset, char* data, size_t n, std::string& error)
+{
+	if(fFd < 0 || offset + n > fSize)
+	{
+		error = fFileName + ": read beyond the end";
+		return false;
+	}
+	if(!fCompressed)
+	{
+		if(Fetch(offset, data, n)) return true;
+		error = "cannot read " + fFileName;
+		return false;
+	}
+
+	// Last block starting at or before offset
+	size_t k = std::upper_bound(fIndex.begin(), fIndex.end(), offset,
+			[](uint64_t value, const BlockIndexEntry& entry){ return value < entry.rawOffset; }) - fIndex.begin() - 1;
+	while(n > 0)
+	{
+		const uint64_t blockEnd = fIndex[k].rawOffset + GetRawBlockSize(k);
+		if(fCached != k)
+		{
+			fCache.resize(GetRawBlockSize(k));
+			fCached = size_t(-1);
+			if(!DecodeBlock(k, &fCache[0], fPacked, error)) return false;
+			fCached = k;
+		}
+		const size_t begin = offset - fIndex[k].rawOffset;
+		const size_t take = std::min(size_t(blockEnd - offset), n);
+		memcpy(data, fCache.data() + begin, take);
+		data += take;
+		offset += take;
+		n -= take;
+		k++;
+	}
+	return true;
+}
+
+bool BlockReader::ReadAll(std::string& data, std::string& error, int nThreads)
+{
+	if(fTruncated > 0)
+	{
+		std::ostringstream message;
+		message << fFileName << ": truncated, " << fTruncated << " bytes of a partial block after "
+				<< fIndex.size() << " complete blocks";
+		error = message.str();
+		return false;
+	}
+	data.resize(fSize);
+	if(fSize == 0) return fFd >= 0;
+	if(!fCompressed) return Read(0, &data[0], fSize, error);
+
+	// Blocks are independent, each thread takes the next one
+	const int n = std::max(1, std::min(nThreads, int(fIndex.size())));
+	std::atomic<size_t> next(0);
+	std::atomic<bool> ok(true);
+	std::vector<std::string> errors(n);
+	auto decode = [&](int t)
+	{
+		std::string packed;
+		for(size_t k=next++;k<fIndex.size() && ok;k=next++)
+		{
+			if(!DecodeBlock(k, &data[fIndex[k].rawOffset], packed, errors[t])) ok = false;
+		}
+	};
+	std::vector<std::thread> threads;
+	for(int t=1;t<n;t++) threads.push_back(std::thread(decode, t));
+	decode(0);
+	for(size_t t=0;t<threads.size();t++) threads[t].join();
+	for(int t=0;t<n && !ok;t++)
+	{
+		if(!errors[t].empty()) error = errors[t];
+	}
+	return ok;
+}
+
+bool BlockReader::ReadFile(const std::string& fileName, std::string& data, std::string& error, int nThreads)
+{
+	BlockReader reader;
+	return reader.Open(fileName, error) && reader.ReadAll(data, error, nThreads);
+}
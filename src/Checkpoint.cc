@@ -0,0 +1,261 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "Checkpoint.hh"
+#include "Run.hh"
+#include "SimulationConfig.hh"
+#include "AsyncWriter.hh"
+
+#include "Randomize.hh"
+
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace
+{
+	G4bool WriteEngine(std::ostream& out)
+	{
+		std::ostringstream state;
+		G4Random::getTheEngine()->put(state);
+		const std::string str = state.str();
+		uint64_t n = str.size();
+		out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+		out.write(str.data(), n);
+		return bool(out);
+	}
+
+	G4bool ReadEngine(std::istream& in, std::string& state)
+	{
+		uint64_t n = 0;
+		if(!in.read(reinterpret_cast<char*>(&n), sizeof(n)) || n > (1 << 24)) return false;
+		state.resize(n);
+		return n == 0 || bool(in.read(&state[0], n));
+	}
+
+	// Serialized here, written as <file>.tmp then renamed over <file> by
+	// the I/O thread (write errors are reported by AsyncWriter)
+	G4bool WriteFile(const G4String& fileName, const CheckpointHeader& header, const Run& run)
+	{
+		std::ostringstream out(std::ios::binary);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		G4bool ok = out && run.WriteState(out) && WriteEngine(out);
+		if(ok)
+		{
+			std::string data = out.str();
+			AsyncWriter::Instance()->WriteFile(fileName, data);
+		}
+		else
+		{
+			G4ExceptionDescription ed;
+			ed << "Cannot write checkpoint " << fileName;
+			G4Exception("Checkpoint::WriteFile()", "Ckpt001", JustWarning, ed);
+		}
+		return ok;
+	}
+
+	// Plain or block-compressed (/scint/output/compression)
+	G4bool ReadFile(const G4String& fileName, CheckpointHeader& header, Run& run, std::string& engine)
+	{
+		std::string data, error;
+		if(!BlockReader::ReadFile(fileName, data, error)) return false;
+		std::istringstream in(data);
+		return in.read(reinterpret_cast<char*>(&header), sizeof(header))
+				&& strncmp(header.magic, CKPT_MAGIC, sizeof(header.magic)) == 0
+				&& header.version == CKPT_VERSION
+				&& run.ReadState(in) && ReadEngine(in, engine);
+	}
+
+	CheckpointHeader MakeHeader(G4int generation, G4int threadId, G4long nTotal)
+	{
+		CheckpointHeader header;
+		memset(&header, 0, sizeof(header));
+		strncpy(header.magic, CKPT_MAGIC, sizeof(header.magic));
+		header.version = CKPT_VERSION;
+		header.generation = generation;
+		header.threadId = threadId;
+		header.nTotal = nTotal;
+		return header;
+	}
+}
+
+Run* Checkpoint::fResumed = 0;
+
+G4String Checkpoint::WorkerFile(G4int generation, G4int threadId)
+{
+	std::ostringstream name;
+	name << SimulationConfig::Instance()->GetCheckpointDirectory() << "/worker" << threadId
+			<< "_g" << generation << ".ckpt";
+	return name.str();
+}
+
+G4String Checkpoint::BaseFile()
+{
+	return SimulationConfig::Instance()->GetCheckpointDirectory() + "/base.ckpt";
+}
+
+void Checkpoint::RemoveWorkerFiles()
+{
+	const G4String& dirName = SimulationConfig::Instance()->GetCheckpointDirectory();
+	DIR* dir = opendir(dirName.c_str());
+	if(!dir) return;
+	while(struct dirent* entry = readdir(dir))
+	{
+		G4String name = entry->d_name;
+		if(name.compare(0, 6, "worker") == 0) remove((dirName + "/" + name).c_str());
+	}
+	closedir(dir);
+}
+
+void Checkpoint::WriteWorker(const Run& run)
+{
+	const G4int generation = SimulationConfig::Instance()->GetCheckpointGeneration();
+	WriteFile(WorkerFile(generation, run.GetThreadId()),
+			MakeHeader(generation, run.GetThreadId(), 0), run);
+}
+
+void Checkpoint::BeginRun(const Run& run)
+{
+	SimulationConfig* config = SimulationConfig::Instance();
+	mkdir(config->GetCheckpointDirectory().c_str(), 0755);
+
+	// Base: results of earlier jobs, and the engine before the seeds of this run are drawn
+	Run empty;
+	const Run& base = fResumed ? *fResumed : empty;
+	const G4long nTotal = base.GetNumberOfEvent() + run.GetNumberOfEventToBeProcessed();
+	if(WriteFile(BaseFile(), MakeHeader(config->GetCheckpointGeneration(), -1, nTotal), base))
+		RemoveWorkerFiles();
+}
+
+void Checkpoint::EndRun()
+{
+	// Job complete: final outputs supersede the checkpoint
+	RemoveWorkerFiles();
+	remove(BaseFile().c_str());
+}
+
+G4long Checkpoint::Resume(G4long nTotal)
+{
+	SimulationConfig* config = SimulationConfig::Instance();
+
+	Run* state = new Run();
+	CheckpointHeader header;
+	std::string baseEngine;
+	if(!ReadFile(BaseFile(), header, *state, baseEngine))
+	{
+		G4ExceptionDescription ed;
+		ed << "No valid checkpoint " << BaseFile() << " to resume from";
+		G4Exception("Checkpoint::Resume()", "Ckpt002", JustWarning, ed);
+		delete state;
+		return -1;
+	}
+	const G4int generation = header.generation;
+	if(nTotal <= 0) nTotal = header.nTotal;
+
+	// Worker files of the same generation hold the events run since the base
+	std::string sequentialEngine;
+	DIR* dir = opendir(config->GetCheckpointDirectory().c_str());
+	while(dir)
+	{
+		struct dirent* entry = readdir(dir);
+		if(!entry) break;
+		G4String name = entry->d_name;
+		std::ostringstream suffix;
+		suffix << "_g" << generation << ".ckpt";
+		if(name.compare(0, 6, "worker") != 0 || name.size() < suffix.str().size()
+				|| name.compare(name.size() - suffix.str().size(), G4String::npos, suffix.str()) != 0)
+			continue;
+
+		Run worker;
+		CheckpointHeader workerHeader;
+		std::string engine;
+		if(!ReadFile(config->GetCheckpointDirectory() + "/" + name, workerHeader, worker, engine)
+				|| workerHeader.generation != header.generation)
+		{
+			G4ExceptionDescription ed;
+			ed << "Skipping unreadable checkpoint " << name;
+			G4Exception("Checkpoint::Resume()", "Ckpt003", JustWarning, ed);
+			continue;
+		}
+		if(!state->Restore(worker))
+		{
+			G4ExceptionDescription ed;
+			ed << "Skipping checkpoint " << name << ": pixel grid differs";
+			G4Exception("Checkpoint::Resume()", "Ckpt003", JustWarning, ed);
+			continue;
+		}
+		if(workerHeader.threadId < 0) sequentialEngine = engine;
+	}
+	if(dir) closedir(dir);
+
+	// Sequential run: the engine of the event loop continues exactly.
+	// MT: the checkpointed events are not a prefix of the master seed
+	// sequence (workers take events in chunks and checkpoint on their own
+	// schedule), so replaying it could repeat some seeds and skip others.
+	// The master is reseeded from the base engine and the generation
+	// instead: a statistically independent continuation, not a replay.
+	if(!sequentialEngine.empty())
+	{
+		std::istringstream in(sequentialEngine);
+		G4Random::getTheEngine()->get(in);
+	}
+	else
+	{
+		std::istringstream in(baseEngine);
+		G4Random::getTheEngine()->get(in);
+		// The first numbers of the base engine seeded the interrupted job;
+		// mixed with the generation they give a different master stream
+		long seeds[3];
+		seeds[0] = (long(G4UniformRand()*2147483562.) + 40014L*(generation + 1))%2147483562L + 1;
+		seeds[1] = (long(G4UniformRand()*2147483398.) + 40692L*(generation + 1))%2147483398L + 1;
+		seeds[2] = 0;
+		G4Random::setTheSeeds(seeds);
+	}
+
+	delete fResumed;
+	fResumed = state;
+	config->SetCheckpointGeneration(generation + 1);
+
+	const G4long nDone = state->GetNumberOfEvent();
+	G4cout << "Checkpoint: " << nDone << " events restored from " << config->GetCheckpointDirectory()
+			<< ", " << (nTotal > nDone ? nTotal - nDone : 0) << " to go" << G4endl;
+	return nTotal > nDone ? nTotal - nDone : 0;
+}
+
+void Checkpoint::RestoreInto(Run* run)
+{
+	if(!fResumed) return;
+	if(!run->Restore(*fResumed))
+		G4Exception("Checkpoint::RestoreInto()", "Ckpt004", JustWarning,
+				"Checkpoint pixel grid differs from the detector, nothing restored");
+	delete fResumed;
+	fResumed = 0;
+}
@@ -36,6 +36,10 @@
 
 #include "G4PVPlacement.hh"
 #include "G4PVReplica.hh"
+#include "G4PVParameterised.hh"
+#include "PixelParameterisation.hh"
+#include "G4PhantomParameterisation.hh"
+#include "PhantomFile.hh"
 
 #include "G4VisAttributes.hh"
 
@@ -52,6 +56,10 @@
 
 //Variable Container
 #include "VariableContainer_wjcheon.hh"
+#include "SimulationConfig.hh"
+
+#include <sstream>
+#include <cmath>
 
 
 
@@ -63,10 +71,14 @@ DetectorConstruction::DetectorConstruction()
 	fN = fO = NULL;
 	fLXe = fAir = fDRZ_high = NULL;
 	fLXe_mt = fAir_mt = fDRZ_high_mt = NULL;
-	pv_World = pv_Scint = NULL;
-	lv_Scint = NULL;
+	pv_World = pv_Scint = pv_RepY = NULL;
+	fWrap = NULL;
+	lv_Scint = lv_Pixel = NULL;
 	WorldSzX = WorldSzY = WorldSzZ = 0.0;
 	ScintSzX = ScintSzY = ScintSzZ =0.0;
+	fVoxelN[0] = fVoxelN[1] = fVoxelN[2] = 0;
+	fVoxelSize[0] = fVoxelSize[1] = fVoxelSize[2] = 0.0;
+	fPhantomHash = 0;
 
 }
 
@@ -95,20 +107,57 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	pv_Scint = new G4PVPlacement(0, G4ThreeVector(0.0, 0.0, -0.5*(ScintSzZ)), lv_Scint, "Scint", lv_World, false, 10);
 
 
-	G4VSolid *sol_RepX = new G4Box("RepX",(ScintSzX/REPLICA_NUM)*0.5,ScintSzY*0.5,ScintSzZ*0.5);
-	G4LogicalVolume *lv_RepX = new G4LogicalVolume(sol_RepX,fDRZ_high,"RepX");
-	G4VPhysicalVolume *pv_RepX = new G4PVReplica("RepX",lv_RepX,lv_Scint,kXAxis,REPLICA_NUM,(ScintSzX/REPLICA_NUM));
-
-	G4VSolid *sol_RepY = new G4Box("RepY",(ScintSzX/REPLICA_NUM)*0.5,(ScintSzY/REPLICA_NUM)*0.5,ScintSzZ*0.5);
-	G4LogicalVolume *lv_RepY = new G4LogicalVolume(sol_RepY,fDRZ_high,"RepY");
-	G4VPhysicalVolume *pv_RepY = new G4PVReplica("RepY",lv_RepY,lv_RepX,kYAxis,REPLICA_NUM,(ScintSzY/REPLICA_NUM));
-
-	//SolidWater Phantom
-	G4VSolid *sol_WaterBox = new G4Box("WaterBox",WaterBoxX*0.5,WaterBoxY*0.5,WaterBoxZ*0.5);
-	G4Material* WATER = G4NistManager::Instance()->FindOrBuildMaterial("G4_WATER");
-	G4LogicalVolume *lv_WaterBox = new G4LogicalVolume(sol_WaterBox,WATER,"WaterBox");
-	G4VPhysicalVolume *pv_WaterBox = new G4PVPlacement(0, G4ThreeVector(0.0, 0.0, 0.5*(WaterBoxZ)), lv_WaterBox, "WaterBox",
-			lv_World, false, 300);
+	// Pixel grid (REPLICA_NUM unless /scint/det/pixels is given)
+	const G4int nPixel = SimulationConfig::Instance()->GetNumberOfPixels();
+	const PixelLayout layout = SimulationConfig::Instance()->GetPixelLayout();
+
+	// Volume readout scores every photon step in a pixel volume; without
+	// pixel volumes the steps (and the map) would differ from the other layouts
+	if(layout == kSingleLayout && SimulationConfig::Instance()->GetReadout() == kVolumeReadout)
+	{
+		G4Exception("DetectorConstruction::Construct()", "Geom004", JustWarning,
+				"The single pixel layout needs face readout: /scint/det/readout face is set");
+		SimulationConfig::Instance()->SetReadout(kFaceReadout);
+	}
+
+	// Pixels are RepY (copy = row) in RepX (copy = column) in both volume
+	// layouts, so touchables give the same indices; the single layout has
+	// no pixel volumes and the panel itself is sensitive
+	G4LogicalVolume *lv_RepX = NULL, *lv_RepY = NULL;
+	lv_Pixel = lv_Scint;
+	if(layout != kSingleLayout)
+	{
+		G4VSolid *sol_RepX = new G4Box("RepX",(ScintSzX/nPixel)*0.5,ScintSzY*0.5,ScintSzZ*0.5);
+		lv_RepX = new G4LogicalVolume(sol_RepX,fDRZ_high,"RepX");
+		new G4PVReplica("RepX",lv_RepX,lv_Scint,kXAxis,nPixel,(ScintSzX/nPixel));
+
+		G4VSolid *sol_RepY = new G4Box("RepY",(ScintSzX/nPixel)*0.5,(ScintSzY/nPixel)*0.5,ScintSzZ*0.5);
+		lv_RepY = new G4LogicalVolume(sol_RepY,fDRZ_high,"RepY");
+		if(layout == kNestedLayout)
+		{
+			// Voxelised along y; smartless sets the number of voxels per pixel
+			pv_RepY = new G4PVParameterised("RepY",lv_RepY,lv_RepX,kYAxis,nPixel,
+					new PixelParameterisation(fDRZ_high,nPixel,ScintSzY/nPixel));
+			lv_RepX->SetSmartless(SimulationConfig::Instance()->GetSmartless());
+		}
+		else pv_RepY = new G4PVReplica("RepY",lv_RepY,lv_RepX,kYAxis,nPixel,(ScintSzY/nPixel));
+		lv_Pixel = lv_RepY;
+	}
+
+	//SolidWater Phantom, or the voxelised phantom of /scint/det/phantom
+	//(not built for the panel stage of the pipeline)
+	G4LogicalVolume *lv_WaterBox = NULL;
+	if(SimulationConfig::Instance()->GetPipelineStage() != kPanelStage
+			&& !SimulationConfig::Instance()->GetPhantomFile().empty())
+		ConstructVoxelPhantom(lv_World);
+	else if(SimulationConfig::Instance()->GetPipelineStage() != kPanelStage)
+	{
+		G4VSolid *sol_WaterBox = new G4Box("WaterBox",WaterBoxX*0.5,WaterBoxY*0.5,WaterBoxZ*0.5);
+		G4Material* WATER = G4NistManager::Instance()->FindOrBuildMaterial("G4_WATER");
+		lv_WaterBox = new G4LogicalVolume(sol_WaterBox,WATER,"WaterBox");
+		new G4PVPlacement(0, G4ThreeVector(0.0, 0.0, 0.5*(WaterBoxZ)), lv_WaterBox, "WaterBox",
+				lv_World, false, 300);
+	}
 
 
 
@@ -121,15 +170,21 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 	va_Scint->SetForceWireframe(true);
 	lv_Scint->SetVisAttributes(va_Scint);
 
-	G4VisAttributes* va_WaterBox = new G4VisAttributes(G4Colour(0.0,0.0,1.0));
-	va_WaterBox->SetForceSolid(true);
-	lv_WaterBox->SetVisAttributes(va_WaterBox);
+	if(lv_WaterBox)
+	{
+		G4VisAttributes* va_WaterBox = new G4VisAttributes(G4Colour(0.0,0.0,1.0));
+		va_WaterBox->SetForceSolid(true);
+		lv_WaterBox->SetVisAttributes(va_WaterBox);
+	}
 
 
-	G4VisAttributes* va_Rep = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0,0.3));
-	va_Rep->SetForceWireframe(true);
-	lv_RepX->SetVisAttributes(va_Rep);
-	lv_RepY->SetVisAttributes(va_Rep);
+	if(lv_RepX)
+	{
+		G4VisAttributes* va_Rep = new G4VisAttributes(G4Colour(1.0, 1.0, 1.0,0.3));
+		va_Rep->SetForceWireframe(true);
+		lv_RepX->SetVisAttributes(va_Rep);
+		lv_RepY->SetVisAttributes(va_Rep);
+	}
 
 
 
@@ -141,7 +196,15 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 void DetectorConstruction::ConstructSDandField()
 {
 	// Set sensitive detector on "Geom"
-	SetSensitiveDetector("RepY", new SensitiveDetector("detector"));
+	SensitiveDetector* sd = new SensitiveDetector("detector");
+	sd->SetReadoutFaceZ(GetReadoutFaceZ());
+	if(lv_Pixel == lv_Scint)
+	{
+		const G4int nPixel = SimulationConfig::Instance()->GetNumberOfPixels();
+		const G4ThreeVector centre = GetScintCentre();
+		sd->SetComputedGrid(centre.x() - 0.5*ScintSzX, centre.y() - 0.5*ScintSzY, ScintSzX/nPixel, ScintSzY/nPixel);
+	}
+	SetSensitiveDetector(lv_Pixel, sd);
 }
 
 
@@ -252,9 +315,16 @@ void DetectorConstruction::SetSurfaceProperty(){
 	WrapProperty->AddProperty("REFLECTIVITY",pp,reflectivity,num);
 	WrapProperty->AddProperty("EFFICIENCY",pp,efficiency,num);
 	Scint2World->SetMaterialPropertiesTable(WrapProperty);
+	fWrap = Scint2World;
 
 	new G4LogicalSkinSurface("MirrorSurface",lv_Scint,Scint2World);
 
+	// Photons leave the panel from the pixel replicas, whose boundary with
+	// the world does not see the skin of lv_Scint; face readout needs the
+	// wrap there so that only the readout face collects light
+	if(SimulationConfig::Instance()->GetReadout() == kFaceReadout && pv_RepY)
+		new G4LogicalBorderSurface("Pixel2World", pv_RepY, pv_World, Scint2World);
+
 
 }
 
@@ -274,3 +344,105 @@ void DetectorConstruction::SetDimension(){
 	WaterBoxZ = 20.0*cm;
 
 }
+
+void DetectorConstruction::ConstructVoxelPhantom(G4LogicalVolume* lv_World)
+{
+	const G4String& fileName = SimulationConfig::Instance()->GetPhantomFile();
+	PhantomData phantom;
+	std::string error;
+	if(!phantom.Read(fileName, error))
+		G4Exception("DetectorConstruction::ConstructVoxelPhantom", "Geom001", FatalException, error.c_str());
+
+	// One G4Material per (material, density) of the file
+	fVoxelMaterials.clear();
+	for(size_t m=0;m<phantom.materials.size();m++)
+	{
+		const PhantomMaterial& entry = phantom.materials[m];
+		G4Material* base = G4NistManager::Instance()->FindOrBuildMaterial(entry.name);
+		if(!base) base = G4Material::GetMaterial(entry.name, false);
+		if(!base)
+		{
+			G4ExceptionDescription msg;
+			msg << fileName << ": unknown material " << entry.name;
+			G4Exception("DetectorConstruction::ConstructVoxelPhantom", "Geom002", FatalException, msg);
+		}
+		G4Material* material = base;
+		if(entry.density > 0. && std::fabs(entry.density*g/cm3 - base->GetDensity()) > 1e-6*g/cm3)
+		{
+			std::ostringstream name;
+			name << entry.name << "_" << entry.density;
+			material = G4Material::GetMaterial(name.str(), false);
+			if(!material) material = new G4Material(name.str(), entry.density*g/cm3, base);
+		}
+		fVoxelMaterials.push_back(material);
+	}
+
+	for(G4int k=0;k<3;k++)
+	{
+		fVoxelN[k] = phantom.n[k];
+		fVoxelSize[k] = phantom.voxel[k]*mm;
+	}
+	fPhantomHash = phantom.GetHash();
+	const G4double halfX = 0.5*fVoxelN[0]*fVoxelSize[0];
+	const G4double halfY = 0.5*fVoxelN[1]*fVoxelSize[1];
+	const G4double halfZ = 0.5*fVoxelN[2]*fVoxelSize[2];
+	if(halfX > 0.5*WorldSzX || halfY > 0.5*WorldSzY || 2.*halfZ > 0.5*WorldSzZ)
+		G4Exception("DetectorConstruction::ConstructVoxelPhantom", "Geom003", FatalException,
+				"the voxel phantom does not fit in the world");
+
+	// Shared by all threads, the parameterisation only keeps the pointer
+	fVoxelIndex.assign(phantom.material.begin(), phantom.material.end());
+
+	// Front face at z = 0 as the water box
+	G4VSolid* sol_Container = new G4Box("PhantomContainer", halfX, halfY, halfZ);
+	G4LogicalVolume* lv_Container = new G4LogicalVolume(sol_Container, fVoxelMaterials[0], "PhantomContainer");
+	G4VPhysicalVolume* pv_Container = new G4PVPlacement(0, G4ThreeVector(0.0, 0.0, halfZ), lv_Container,
+			"PhantomContainer", lv_World, false, 300);
+
+	G4PhantomParameterisation* param = new G4PhantomParameterisation();
+	param->SetVoxelDimensions(0.5*fVoxelSize[0], 0.5*fVoxelSize[1], 0.5*fVoxelSize[2]);
+	param->SetNoVoxel(fVoxelN[0], fVoxelN[1], fVoxelN[2]);
+	param->SetMaterials(fVoxelMaterials);
+	param->SetMaterialIndices(&fVoxelIndex[0]);
+	param->BuildContainerSolid(pv_Container);
+	param->CheckVoxelsFillContainer(halfX, halfY, halfZ);
+	// Regular navigation steps over the boundaries between voxels of the
+	// same material, so the cost follows the material changes along a
+	// track rather than the number of voxels
+	param->SetSkipEqualMaterials(true);
+
+	G4VSolid* sol_Voxel = new G4Box("Voxel", 0.5*fVoxelSize[0], 0.5*fVoxelSize[1], 0.5*fVoxelSize[2]);
+	G4LogicalVolume* lv_Voxel = new G4LogicalVolume(sol_Voxel, fVoxelMaterials[0], "Voxel");
+	lv_Voxel->SetVisAttributes(new G4VisAttributes(false));
+	G4PVParameterised* pv_Voxel = new G4PVParameterised("Voxel", lv_Voxel, lv_Container, kUndefined,
+			fVoxelN[0]*fVoxelN[1]*fVoxelN[2], param);
+	pv_Voxel->SetRegularStructureId(1);
+
+	G4VisAttributes* va_Container = new G4VisAttributes(G4Colour(0.0,0.0,1.0));
+	va_Container->SetForceWireframe(true);
+	lv_Container->SetVisAttributes(va_Container);
+
+	G4cout << "Voxel phantom " << fileName << ": " << fVoxelN[0] << " x " << fVoxelN[1] << " x " << fVoxelN[2]
+			<< " voxels, " << fVoxelMaterials.size() << " materials" << G4endl;
+}
+
+G4String DetectorConstruction::GetPhantomDescription() const
+{
+	std::ostringstream desc;
+	if(!fVoxelMaterials.empty())
+	{
+		desc << "VoxelPhantom " << SimulationConfig::Instance()->GetPhantomFile() << " " << fVoxelN[0] << " "
+				<< fVoxelN[1] << " " << fVoxelN[2] << " voxels of " << fVoxelSize[0]/mm << " " << fVoxelSize[1]/mm
+				<< " " << fVoxelSize[2]/mm << " mm, hash " << std::hex << fPhantomHash << std::dec;
+		return desc.str();
+	}
+	return GetWaterBoxDescription();
+}
+
+G4String DetectorConstruction::GetWaterBoxDescription() const
+{
+	std::ostringstream desc;
+	desc << "WaterBox G4_WATER " << WaterBoxX/mm << " " << WaterBoxY/mm << " " << WaterBoxZ/mm
+			<< " mm at z " << 0.5*WaterBoxZ/mm << " mm";
+	return desc.str();
+}
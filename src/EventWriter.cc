@@ -0,0 +1,334 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "EventWriter.hh"
+#include "AsyncWriter.hh"
+#include "MemoryReport.hh"
+#include "BlockFile.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	G4bool PixelLess(const std::pair<G4int, G4float>& a, const std::pair<G4int, G4float>& b)
+	{
+		return a.first < b.first;
+	}
+
+	// Sorts by pixel and sums repeated pixels
+	void Reduce(EventWriter::PixelValues& values)
+	{
+		std::sort(values.begin(), values.end(), PixelLess);
+		size_t n = 0;
+		for(size_t i=0;i<values.size();i++)
+		{
+			if(n > 0 && values[n-1].first == values[i].first) values[n-1].second += values[i].second;
+			else values[n++] = values[i];
+		}
+		values.resize(n);
+	}
+}
+
+EventWriter::EventWriter(const G4String& fileName, G4int nPixel, EventEncoding encoding, size_t bufferBytes)
+:fFileName(fileName), fBufferBytes(bufferBytes > 0 ? bufferBytes : 1), fNPixel(nPixel), fEncoding(encoding),
+ fDataSize(0), fNEvents(0), fAsync(AsyncWriter::Instance()->IsRunning()), fOpen(true)
+{
+	fData.reserve(fBufferBytes);
+	// Part files opened by the I/O thread with the first buffer
+	if(fAsync) return;
+	fIndexOut.open((fFileName + ".index").c_str(), std::ios::binary | std::ios::trunc);
+	fDataOut.open((fFileName + ".data").c_str(), std::ios::binary | std::ios::trunc);
+	if(!fIndexOut || !fDataOut)
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot open event part files " << fFileName << ".index/.data";
+		G4Exception("EventWriter::EventWriter()", "Evt001", FatalException, ed);
+	}
+}
+
+EventWriter::~EventWriter()
+{
+	Close();
+	MemoryReport::SetThreadUsage(MemoryReport::kEventBuffer, 0);
+}
+
+void EventWriter::Write(const G4Event* event, PixelValues& edep, PixelValues& photons)
+{
+	EventEntry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.eventID = event->GetEventID();
+
+	for(G4int i=0;i<event->GetNumberOfPrimaryVertex();i++)
+	{
+		const G4PrimaryVertex* vertex = event->GetPrimaryVertex(i);
+		for(G4int j=0;j<vertex->GetNumberOfParticle();j++)
+		{
+			const G4PrimaryParticle* primary = vertex->GetPrimary(j);
+			if(entry.nPrimaries == 0)
+			{
+				const G4ThreeVector pos = vertex->GetPosition();
+				const G4ThreeVector& dir = primary->GetMomentumDirection();
+				entry.pdg = primary->GetPDGcode();
+				entry.x = pos.x()/mm;
+				entry.y = pos.y()/mm;
+				entry.z = pos.z()/mm;
+				entry.dirX = dir.x();
+				entry.dirY = dir.y();
+				entry.dirZ = dir.z();
+				entry.weight = primary->GetWeight();
+			}
+			entry.kinE += primary->GetKineticEnergy()/MeV;
+			entry.nPrimaries++;
+		}
+	}
+
+	AddTensor(edep, entry.edepCount, entry.edepEncoding, entry.edepOffset, entry.edep);
+	AddTensor(photons, entry.photonCount, entry.photonEncoding, entry.photonOffset, entry.photons);
+	fIndex.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+	fNEvents++;
+
+	if(fData.size() + fIndex.size() >= fBufferBytes) Flush();
+}
+
+void EventWriter::AddTensor(PixelValues& values, uint32_t& count, uint32_t& encoding, uint64_t& offset, float& total)
+{
+	Reduce(values);
+	total = 0.f;
+	for(size_t i=0;i<values.size();i++) total += values[i].second;
+
+	// Sparse (index + value) unless that is larger than the dense map
+	const size_t nPixels = size_t(fNPixel)*fNPixel;
+	G4bool sparse = (fEncoding == kEncodingSparse)
+			|| (fEncoding == kEncodingAuto && 2*values.size() < nPixels);
+	offset = fDataSize;
+	if(sparse)
+	{
+		encoding = kTensorSparse;
+		count = values.size();
+		for(size_t i=0;i<values.size();i++)
+		{
+			const uint32_t pixel = values[i].first;
+			fData.append(reinterpret_cast<const char*>(&pixel), sizeof(pixel));
+		}
+		for(size_t i=0;i<values.size();i++)
+			fData.append(reinterpret_cast<const char*>(&values[i].second), sizeof(float));
+		fDataSize += values.size()*(sizeof(uint32_t) + sizeof(float));
+	}
+	else
+	{
+		encoding = kTensorDense;
+		count = nPixels;
+		fDense.assign(nPixels, 0.f);
+		for(size_t i=0;i<values.size();i++) fDense[values[i].first] = values[i].second;
+		fData.append(reinterpret_cast<const char*>(&fDense[0]), nPixels*sizeof(float));
+		fDataSize += nPixels*sizeof(float);
+	}
+}
+
+void EventWriter::Flush()
+{
+	// Data before index: an entry never points past the data on disk
+	Append(fFileName + ".data", fDataOut, fData);
+	Append(fFileName + ".index", fIndexOut, fIndex);
+}
+
+void EventWriter::Append(const G4String& fileName, std::ofstream& out, std::string& data)
+{
+	if(data.empty()) return;
+	if(fAsync)
+	{
+		AsyncWriter::Instance()->Append(fileName, data);
+		data.reserve(fBufferBytes);
+	}
+	else
+	{
+		out.write(data.data(), data.size());
+		data.clear();
+	}
+}
+
+void EventWriter::Close()
+{
+	if(!fOpen) return;
+
+	Flush();
+	if(fAsync)
+	{
+		// Creates the part files even when nothing was recorded
+		std::string none;
+		AsyncWriter::Instance()->Append(fFileName + ".data", none);
+		AsyncWriter::Instance()->Append(fFileName + ".index", none);
+		AsyncWriter::Instance()->Close(fFileName + ".data");
+		AsyncWriter::Instance()->Close(fFileName + ".index");
+	}
+	else
+	{
+		fDataOut.close();
+		fIndexOut.close();
+	}
+	fOpen = false;
+}
+
+G4bool EventWriter::Merge(const std::vector<G4String>& parts, const G4String& output,
+		G4int nPixel, G4double pitchX, G4double pitchY)
+{
+	G4String tmpName = output + ".tmp";
+	std::ofstream out(tmpName.c_str(), std::ios::binary | std::ios::trunc);
+	if(!out)
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot open event file " << tmpName;
+		G4Exception("EventWriter::Merge()", "Evt002", JustWarning, ed);
+		return false;
+	}
+
+	// Parts may be block-compressed; sizes are known before anything is written.
+	// Parts that cannot be opened are kept on disk and make the merge fail
+	std::vector<BlockReader*> index, data;
+	std::vector<G4String> merged;
+	G4bool ok = true;
+	uint64_t nEvents = 0, dataSize = 0;
+	for(size_t i=0;i<parts.size();i++)
+	{
+		BlockReader* in = new BlockReader();
+		BlockReader* din = new BlockReader();
+		std::string error;
+		if(!in->Open(parts[i] + ".index", error) || !din->Open(parts[i] + ".data", error))
+		{
+			G4ExceptionDescription ed;
+			ed << "Event part not merged, kept: " << error;
+			G4Exception("EventWriter::Merge()", "Evt004", JustWarning, ed);
+			delete in;
+			delete din;
+			ok = false;
+			continue;
+		}
+		index.push_back(in);
+		data.push_back(din);
+		merged.push_back(parts[i]);
+		nEvents += in->GetSize()/sizeof(EventEntry);
+		dataSize += din->GetSize();
+	}
+
+	EventFileHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, EVENT_MAGIC, sizeof(header.magic));
+	header.version = EVENT_VERSION;
+	header.entrySize = sizeof(EventEntry);
+	header.nEvents = nEvents;
+	header.nPixelX = header.nPixelY = nPixel;
+	header.pitchX = pitchX/mm;
+	header.pitchY = pitchY/mm;
+	header.dataOffset = sizeof(header) + nEvents*sizeof(EventEntry);
+	header.dataSize = dataSize;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// Entry table, tensor offsets moved past the data of the previous parts
+	std::vector<EventEntry> entries(16384);
+	std::vector<G4bool> clean(index.size(), true);
+	uint64_t base = 0;
+	for(size_t i=0;i<index.size();i++)
+	{
+		const uint64_t n = index[i]->GetSize()/sizeof(EventEntry);
+		std::string error;
+		for(uint64_t first=0;first<n;first+=entries.size())
+		{
+			const size_t m = std::min(uint64_t(entries.size()), n - first);
+			if(!index[i]->Read(first*sizeof(EventEntry), reinterpret_cast<char*>(&entries[0]), m*sizeof(EventEntry), error))
+			{
+				// Keeps the event count consistent with the header
+				memset(&entries[0], 0, m*sizeof(EventEntry));
+				G4ExceptionDescription ed;
+				ed << "Corrupt event index, zeroed in the output and kept: " << error;
+				G4Exception("EventWriter::Merge()", "Evt003", JustWarning, ed);
+				clean[i] = false;
+				ok = false;
+			}
+			for(size_t k=0;k<m;k++)
+			{
+				entries[k].edepOffset += base;
+				entries[k].photonOffset += base;
+			}
+			out.write(reinterpret_cast<const char*>(&entries[0]), m*sizeof(EventEntry));
+		}
+		base += data[i]->GetSize();
+	}
+
+	std::vector<char> chunk(1 << 20);
+	for(size_t i=0;i<data.size();i++)
+	{
+		const uint64_t size = data[i]->GetSize();
+		std::string error;
+		for(uint64_t offset=0;offset<size;offset+=chunk.size())
+		{
+			const size_t n = std::min(uint64_t(chunk.size()), size - offset);
+			if(!data[i]->Read(offset, &chunk[0], n, error))
+			{
+				memset(&chunk[0], 0, n);
+				G4ExceptionDescription ed;
+				ed << "Corrupt event data, zeroed in the output and kept: " << error;
+				G4Exception("EventWriter::Merge()", "Evt003", JustWarning, ed);
+				clean[i] = false;
+				ok = false;
+			}
+			out.write(&chunk[0], n);
+		}
+		delete index[i];
+		delete data[i];
+	}
+
+	out.close();
+	if(!out || rename(tmpName.c_str(), output.c_str()) != 0)
+	{
+		// Nothing removed: the parts are all there is
+		G4ExceptionDescription ed;
+		ed << "Cannot write event file " << output << ", parts kept";
+		G4Exception("EventWriter::Merge()", "Evt002", JustWarning, ed);
+		remove(tmpName.c_str());
+		return false;
+	}
+	// Only parts copied without error are removed
+	for(size_t i=0;i<merged.size();i++)
+	{
+		if(!clean[i]) continue;
+		remove((merged[i] + ".index").c_str());
+		remove((merged[i] + ".data").c_str());
+	}
+
+	G4cout << "Event dataset: " << nEvents << " events, " << (header.dataOffset + dataSize)/1048576.
+			<< " MB written to " << output << G4endl;
+	return ok;
+}
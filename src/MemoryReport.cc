@@ -0,0 +1,85 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "MemoryReport.hh"
+
+#include "G4Threading.hh"
+
+#include <cstdio>
+#include <unistd.h>
+#include <sys/resource.h>
+
+namespace
+{
+	G4ThreadLocal size_t threadUsage[MemoryReport::kNComponents] = { 0 };
+}
+
+void MemoryReport::SetThreadUsage(Component component, size_t bytes)
+{
+	threadUsage[component] = bytes;
+}
+
+size_t MemoryReport::GetThreadUsage(G4int component)
+{
+	return threadUsage[component];
+}
+
+const char* MemoryReport::GetComponentName(G4int component)
+{
+	switch(component)
+	{
+	case kPixelMaps: return "pixel maps";
+	case kHitIndex: return "hit index";
+	case kHits: return "hits";
+	case kPhaseSpaceBuffer: return "phase-space buffer";
+	case kEventBuffer: return "event buffer";
+	case kOpticalBatch: return "optical batch";
+	default: return "?";
+	}
+}
+
+size_t MemoryReport::GetResidentSize()
+{
+	// Second field of statm: resident pages
+	long pages = 0, resident = 0;
+	FILE* in = fopen("/proc/self/statm", "r");
+	if(in)
+	{
+		if(fscanf(in, "%ld %ld", &pages, &resident) != 2) resident = 0;
+		fclose(in);
+	}
+	return size_t(resident)*size_t(sysconf(_SC_PAGESIZE));
+}
+
+size_t MemoryReport::GetPeakResidentSize()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return size_t(usage.ru_maxrss)*1024;
+}
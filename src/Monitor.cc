@@ -0,0 +1,240 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "Monitor.hh"
+#include "PixelMap.hh"
+
+#include <sstream>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace
+{
+	G4double WallClock()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + 1e-9*ts.tv_nsec;
+	}
+}
+
+Monitor Monitor::fInstance;
+
+Monitor* Monitor::Instance()
+{
+	return &fInstance;
+}
+
+Monitor::Monitor()
+:fRunning(false), fSocket(-1), fSlots(0), fNSlots(0), fNEventsToProcess(0), fNPixel(0), fMapSize(0), fStartTime(0.)
+{
+
+}
+
+Monitor::~Monitor()
+{
+	Stop();
+}
+
+void Monitor::Start(const G4String& socketPath, G4int nSlots, G4long nEventsToProcess, G4int nPixel, G4int mapSize)
+{
+	Stop();
+
+	fSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+	unlink(socketPath.c_str());
+	if(fSocket < 0 || bind(fSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fSocket, 4) < 0)
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot listen on " << socketPath << ", monitoring disabled";
+		G4Exception("Monitor::Start()", "Mon001", JustWarning, ed);
+		if(fSocket >= 0) close(fSocket);
+		fSocket = -1;
+		return;
+	}
+	fSocketPath = socketPath;
+
+	// Workers are not running: the slots can be reallocated
+	fNSlots = nSlots > 0 ? nSlots : 1;
+	fNEventsToProcess = nEventsToProcess;
+	fNPixel = nPixel;
+	fMapSize = mapSize < nPixel ? mapSize : nPixel;
+	fSlots = new Slot[fNSlots];
+	for(G4int i=0;i<fNSlots;i++)
+	{
+		fSlots[i].nEvents.store(0);
+		fSlots[i].sum.store(0.);
+		fSlots[i].sum2.store(0.);
+		fSlots[i].map = new std::atomic<double>[fMapSize*fMapSize];
+		for(G4int k=0;k<fMapSize*fMapSize;k++) fSlots[i].map[k].store(0.);
+	}
+	fStartTime = WallClock();
+
+	fRunning.store(true);
+	fThread = std::thread(&Monitor::Serve, this);
+}
+
+void Monitor::Stop()
+{
+	if(!fThread.joinable()) return;
+
+	fRunning.store(false);
+	fThread.join();
+	close(fSocket);
+	fSocket = -1;
+	unlink(fSocketPath.c_str());
+
+	for(G4int i=0;i<fNSlots;i++) delete[] fSlots[i].map;
+	delete[] fSlots;
+	fSlots = 0;
+	fNSlots = 0;
+}
+
+void Monitor::Publish(G4int threadId, G4long nEvents, G4double sum, G4double sum2)
+{
+	Slot& slot = fSlots[threadId > 0 ? threadId % fNSlots : 0];
+	slot.nEvents.store(nEvents, std::memory_order_relaxed);
+	slot.sum.store(sum, std::memory_order_relaxed);
+	slot.sum2.store(sum2, std::memory_order_relaxed);
+}
+
+void Monitor::PublishMap(G4int threadId, const PixelMap& map)
+{
+	std::vector<double> coarse;
+	map.Downsample(fMapSize, fMapSize, coarse);
+
+	Slot& slot = fSlots[threadId > 0 ? threadId % fNSlots : 0];
+	for(size_t k=0;k<coarse.size();k++) slot.map[k].store(coarse[k], std::memory_order_relaxed);
+}
+
+void Monitor::Serve()
+{
+	while(fRunning.load())
+	{
+		// Short timeout so Stop() is not delayed
+		struct pollfd pfd;
+		pfd.fd = fSocket;
+		pfd.events = POLLIN;
+		if(poll(&pfd, 1, 200) <= 0) continue;
+
+		int client = accept(fSocket, 0, 0);
+		if(client < 0) continue;
+
+		char request[64];
+		std::string command;
+		pfd.fd = client;
+		if(poll(&pfd, 1, 1000) > 0)
+		{
+			ssize_t n = read(client, request, sizeof(request) - 1);
+			if(n > 0)
+			{
+				request[n] = 0;
+				command = request;
+				command = command.substr(0, command.find_first_of("\r\n"));
+			}
+		}
+
+		std::string reply;
+		if(command == "map") reply = Map();
+		else if(command == "status" || command.empty()) reply = Status();
+		else reply = "error unknown command \"" + command + "\" (status, map)\n";
+
+		const char* data = reply.data();
+		size_t left = reply.size();
+		while(left > 0)
+		{
+			ssize_t n = write(client, data, left);
+			if(n <= 0) break;
+			data += n;
+			left -= n;
+		}
+		close(client);
+	}
+}
+
+std::string Monitor::Status() const
+{
+	G4long nEvents = 0;
+	G4double sum = 0., sum2 = 0.;
+	for(G4int i=0;i<fNSlots;i++)
+	{
+		nEvents += fSlots[i].nEvents.load(std::memory_order_relaxed);
+		sum += fSlots[i].sum.load(std::memory_order_relaxed);
+		sum2 += fSlots[i].sum2.load(std::memory_order_relaxed);
+	}
+
+	const G4double elapsed = WallClock() - fStartTime;
+	const G4double rate = elapsed > 0. ? nEvents/elapsed : 0.;
+	const G4double eta = rate > 0. ? (fNEventsToProcess - nEvents)/rate : -1.;
+
+	// Relative uncertainty of the mean detected signal per event
+	G4double relError = -1.;
+	if(nEvents > 1 && sum > 0.)
+	{
+		G4double mean = sum/nEvents;
+		G4double var = (sum2/nEvents - mean*mean)*nEvents/(nEvents - 1);
+		relError = std::sqrt(var > 0. ? var/nEvents : 0.)/mean;
+	}
+
+	std::ostringstream out;
+	out << "events " << nEvents << "\n"
+		<< "target " << fNEventsToProcess << "\n"
+		<< "elapsed_s " << elapsed << "\n"
+		<< "events_per_s " << rate << "\n"
+		<< "eta_s " << eta << "\n"
+		<< "photons_detected " << sum << "\n"
+		<< "rel_uncertainty " << relError << "\n"
+		<< "threads " << fNSlots << "\n";
+	return out.str();
+}
+
+std::string Monitor::Map() const
+{
+	std::vector<double> merged(fMapSize*fMapSize, 0.);
+	for(G4int i=0;i<fNSlots;i++)
+		for(G4int k=0;k<fMapSize*fMapSize;k++) merged[k] += fSlots[i].map[k].load(std::memory_order_relaxed);
+
+	std::ostringstream out;
+	out << "map " << fMapSize << " " << fMapSize << "\n";
+	for(G4int i=0;i<fMapSize;i++)
+	{
+		for(G4int j=0;j<fMapSize;j++) out << (j ? "\t" : "") << merged[i*fMapSize + j];
+		out << "\n";
+	}
+	return out.str();
+}
@@ -0,0 +1,92 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "OpticalFilter.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4OpticalSurface.hh"
+#include "G4MaterialPropertiesTable.hh"
+
+#include <cmath>
+#include <cfloat>
+
+OpticalFilter::OpticalFilter()
+:fActive(false), fReflectivity(0), fAbsLength(0)
+{
+
+}
+
+OpticalFilter::~OpticalFilter()
+{
+
+}
+
+void OpticalFilter::Initialize()
+{
+	const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+			G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+	const G4ThreeVector half(0.5*detector->GetScintSizeX(), 0.5*detector->GetScintSizeY(),
+			0.5*detector->GetScintSizeZ());
+	fMin = detector->GetScintCentre() - half;
+	fMax = detector->GetScintCentre() + half;
+
+	const G4OpticalSurface* wrap = detector->GetWrapSurface();
+	G4MaterialPropertiesTable* wrapTable = wrap ? wrap->GetMaterialPropertiesTable() : 0;
+	G4MaterialPropertiesTable* scintTable = detector->GetScintMaterial()->GetMaterialPropertiesTable();
+
+	fReflectivity = wrapTable ? wrapTable->GetProperty("REFLECTIVITY") : 0;
+	fAbsLength = scintTable ? scintTable->GetProperty("ABSLENGTH") : 0;
+
+	// Only an opaque wrap gives a predictable fate at the other faces
+	fActive = wrap && wrap->GetType() == dielectric_metal && fReflectivity;
+	if(!fActive)
+	{
+		G4ExceptionDescription ed;
+		ed << "Wrap is not a dielectric_metal surface with REFLECTIVITY, optical filter disabled";
+		G4Exception("OpticalFilter::Initialize()", "Opt001", JustWarning, ed);
+	}
+}
+
+G4double OpticalFilter::ReachProbability(const G4ThreeVector& pos, const G4ThreeVector& dir,
+		G4double energy, G4bool& directExit) const
+{
+	// Distance to the first face along each axis
+	const G4double inf = DBL_MAX;
+	G4double tx = dir.x() > 0. ? (fMax.x() - pos.x())/dir.x() : (dir.x() < 0. ? (fMin.x() - pos.x())/dir.x() : inf);
+	G4double ty = dir.y() > 0. ? (fMax.y() - pos.y())/dir.y() : (dir.y() < 0. ? (fMin.y() - pos.y())/dir.y() : inf);
+	G4double tz = dir.z() < 0. ? (fMin.z() - pos.z())/dir.z() : inf;
+
+	directExit = (tz <= tx && tz <= ty);
+	if(directExit)
+		return fAbsLength ? std::exp(-tz/fAbsLength->Value(energy)) : 1.;
+
+	return fReflectivity->Value(energy);
+}
@@ -0,0 +1,226 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "OutputManager.hh"
+#include "SimulationConfig.hh"
+
+#include "G4AutoLock.hh"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace
+{
+	G4Mutex outputMutex = G4MUTEX_INITIALIZER;
+
+	G4String TimeStamp(const char* format)
+	{
+		char buffer[64];
+		time_t now = time(0);
+		struct tm t;
+		localtime_r(&now, &t);
+		strftime(buffer, sizeof(buffer), format, &t);
+		return buffer;
+	}
+
+	// Batch systems export the job id under different names
+	G4String JobId()
+	{
+		const char* names[] = { "SLURM_JOB_ID", "PBS_JOBID", "LSB_JOBID", "JOB_ID" };
+		for(size_t i=0;i<sizeof(names)/sizeof(names[0]);i++)
+		{
+			const char* id = getenv(names[i]);
+			if(id && *id) return id;
+		}
+		return "local";
+	}
+
+	// Characters safe in a file name
+	G4String Sanitize(const G4String& s)
+	{
+		G4String out = s;
+		for(size_t i=0;i<out.size();i++)
+		{
+			char c = out[i];
+			if(!isalnum(c) && c != '-' && c != '.') out[i] = '-';
+		}
+		return out;
+	}
+
+	G4bool MakeDirectories(const G4String& path)
+	{
+		for(size_t pos=path.find('/', 1);;pos=path.find('/', pos + 1))
+		{
+			G4String dir = path.substr(0, pos);
+			if(mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+			if(pos == std::string::npos) return true;
+		}
+	}
+
+	G4String JsonString(const G4String& s)
+	{
+		std::ostringstream out;
+		out << '"';
+		for(size_t i=0;i<s.size();i++)
+		{
+			if(s[i] == '"' || s[i] == '\\') out << '\\';
+			out << s[i];
+		}
+		out << '"';
+		return out.str();
+	}
+}
+
+OutputManager OutputManager::fInstance;
+
+OutputManager* OutputManager::Instance()
+{
+	return &fInstance;
+}
+
+OutputManager::OutputManager()
+:fRunID(0), fSeed(0)
+{
+
+}
+
+void OutputManager::BeginRun(G4int runID, long seed)
+{
+	fRunID = runID;
+	fSeed = seed;
+	fJobId = JobId();
+	char host[256] = "unknown";
+	gethostname(host, sizeof(host) - 1);
+	fHost = host;
+	fStartTime = TimeStamp("%Y-%m-%dT%H:%M:%S");
+	fFiles.clear();
+	fRunDir = "";
+
+	const G4String& base = SimulationConfig::Instance()->GetOutputDirectory();
+	if(base.empty()) return;
+
+	std::ostringstream name;
+	name << base << "/run_" << TimeStamp("%Y%m%d-%H%M%S") << "_" << Sanitize(fJobId) << "_" << Sanitize(fHost)
+			<< "_p" << getpid() << "_r" << runID << "_s" << seed;
+
+	// mkdir is atomic: a name taken by a concurrent job gets a suffix
+	if(!MakeDirectories(base))
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot create the output directory " << base;
+		G4Exception("OutputManager::BeginRun()", "Out001", FatalException, ed);
+		return;
+	}
+	G4String dir = name.str();
+	for(G4int n=1;mkdir(dir.c_str(), 0755) != 0;n++)
+	{
+		if(errno != EEXIST || n > 1000)
+		{
+			G4ExceptionDescription ed;
+			ed << "Cannot create the run directory " << dir;
+			G4Exception("OutputManager::BeginRun()", "Out001", FatalException, ed);
+			return;
+		}
+		std::ostringstream next;
+		next << name.str() << "_" << n;
+		dir = next.str();
+	}
+	fRunDir = dir;
+	G4cout << "Run outputs in " << fRunDir << G4endl;
+}
+
+G4String OutputManager::Path(const G4String& name) const
+{
+	if(fRunDir.empty() || name.find('/') != std::string::npos) return name;
+	return fRunDir + "/" + name;
+}
+
+void OutputManager::Register(const G4String& path, const G4String& description, G4int thread)
+{
+	Entry entry;
+	entry.path = path;
+	entry.description = description;
+	entry.thread = thread;
+
+	G4AutoLock lock(&outputMutex);
+	fFiles.push_back(entry);
+}
+
+void OutputManager::EndRun(G4int nEvents)
+{
+	SimulationConfig* config = SimulationConfig::Instance();
+	const G4String manifest = Path("manifest.json");
+	std::ofstream out(manifest.c_str());
+
+	out << "{\n";
+	out << "  \"run_directory\": " << JsonString(fRunDir.empty() ? G4String(".") : fRunDir) << ",\n";
+	out << "  \"run_id\": " << fRunID << ",\n";
+	out << "  \"job_id\": " << JsonString(fJobId) << ",\n";
+	out << "  \"host\": " << JsonString(fHost) << ",\n";
+	out << "  \"pid\": " << getpid() << ",\n";
+	out << "  \"seed\": " << fSeed << ",\n";
+	out << "  \"start_time\": " << JsonString(fStartTime) << ",\n";
+	out << "  \"end_time\": " << JsonString(TimeStamp("%Y-%m-%dT%H:%M:%S")) << ",\n";
+	out << "  \"events\": " << nEvents << ",\n";
+	out << "  \"pixels\": " << config->GetNumberOfPixels() << ",\n";
+	out << "  \"readout\": \"" << (config->GetReadout() == kFaceReadout ? "face" : "volume") << "\",\n";
+	out << "  \"files\": [";
+
+	G4AutoLock lock(&outputMutex);
+	for(size_t i=0;i<fFiles.size();i++)
+	{
+		// Paths relative to the run directory when inside it
+		const Entry& e = fFiles[i];
+		G4String path = e.path;
+		if(!fRunDir.empty() && path.compare(0, fRunDir.size() + 1, fRunDir + "/") == 0)
+			path = path.substr(fRunDir.size() + 1);
+		struct stat st;
+		const long long bytes = stat(e.path.c_str(), &st) == 0 ? (long long)st.st_size : -1;
+
+		out << (i ? "," : "") << "\n    {\"path\": " << JsonString(path)
+				<< ", \"description\": " << JsonString(e.description)
+				<< ", \"thread\": " << e.thread << ", \"bytes\": " << bytes << "}";
+	}
+	out << (fFiles.empty() ? "]\n" : "\n  ]\n");
+	out << "}\n";
+	out.close();
+	if(out.fail())
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot write " << manifest;
+		G4Exception("OutputManager::EndRun()", "Out002", JustWarning, ed);
+	}
+}
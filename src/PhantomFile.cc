@@ -0,0 +1,155 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "PhantomFile.hh"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	uint64_t Fnv1a(const std::string& data)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for(size_t k=0;k<data.size();k++) hash = (hash ^ (unsigned char)data[k])*1099511628211ULL;
+		return hash;
+	}
+}
+
+PhantomData::PhantomData()
+:fHash(0)
+{
+	n[0] = n[1] = n[2] = 0;
+	voxel[0] = voxel[1] = voxel[2] = 0.;
+}
+
+void PhantomData::Serialise(std::string& data) const
+{
+	PhantomFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PHANTOMFILE_MAGIC, sizeof(PHANTOMFILE_MAGIC));
+	header.version = PHANTOMFILE_VERSION;
+	header.nMaterials = uint32_t(materials.size());
+	for(int k=0;k<3;k++)
+	{
+		header.n[k] = n[k];
+		header.voxel[k] = voxel[k];
+	}
+	data.assign((const char*)&header, sizeof(header));
+	for(size_t m=0;m<materials.size();m++)
+	{
+		uint32_t length = uint32_t(materials[m].name.size());
+		data.append((const char*)&length, sizeof(length));
+		data.append(materials[m].name);
+		data.append((const char*)&materials[m].density, sizeof(double));
+	}
+	if(!material.empty()) data.append((const char*)&material[0], material.size()*sizeof(uint16_t));
+}
+
+bool PhantomData::Write(const std::string& fileName, std::string& error, BlockCodec codec, size_t blockSize) const
+{
+	std::string data;
+	Serialise(data);
+	if(codec != kCodecStored)
+	{
+		std::string packed;
+		BlockWriter writer(codec, blockSize);
+		writer.Write(data.data(), data.size(), packed);
+		writer.Finish(packed);
+		data.swap(packed);
+	}
+	FILE* out = fopen(fileName.c_str(), "wb");
+	bool ok = out && fwrite(data.data(), 1, data.size(), out) == data.size();
+	if(out) ok = fclose(out) == 0 && ok;
+	if(!ok) error = "cannot write " + fileName;
+	return ok;
+}
+
+bool PhantomData::Read(const std::string& fileName, std::string& error)
+{
+	std::string data;
+	if(!BlockReader::ReadFile(fileName, data, error)) return false;
+
+	PhantomFileHeader header;
+	if(data.size() < sizeof(header)
+			|| memcmp(data.data(), PHANTOMFILE_MAGIC, sizeof(PHANTOMFILE_MAGIC)) != 0)
+	{
+		error = fileName + ": not a phantom file";
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if(header.version != PHANTOMFILE_VERSION)
+	{
+		error = fileName + ": unsupported phantom file version";
+		return false;
+	}
+
+	size_t pos = sizeof(header);
+	materials.resize(header.nMaterials);
+	for(size_t m=0;m<materials.size();m++)
+	{
+		uint32_t length;
+		if(pos + sizeof(length) > data.size()) break;
+		memcpy(&length, data.data() + pos, sizeof(length));
+		pos += sizeof(length);
+		if(pos + length + sizeof(double) > data.size())
+		{
+			pos = data.size() + 1;
+			break;
+		}
+		materials[m].name.assign(data, pos, length);
+		memcpy(&materials[m].density, data.data() + pos + length, sizeof(double));
+		pos += length + sizeof(double);
+	}
+
+	for(int k=0;k<3;k++)
+	{
+		n[k] = header.n[k];
+		voxel[k] = header.voxel[k];
+	}
+	const uint64_t nVoxels = GetNumberOfVoxels();
+	if(pos > data.size() || nVoxels == 0 || (data.size() - pos)/sizeof(uint16_t) != nVoxels
+			|| voxel[0] <= 0. || voxel[1] <= 0. || voxel[2] <= 0.)
+	{
+		error = fileName + ": truncated or inconsistent phantom file";
+		return false;
+	}
+	material.resize(nVoxels);
+	memcpy(&material[0], data.data() + pos, nVoxels*sizeof(uint16_t));
+	for(uint64_t v=0;v<nVoxels;v++)
+	{
+		if(material[v] >= materials.size())
+		{
+			error = fileName + ": voxel material index out of range";
+			return false;
+		}
+	}
+	fHash = Fnv1a(data);
+	return true;
+}
@@ -0,0 +1,166 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "PhaseSpaceSource.hh"
+#include "BlockFile.hh"
+
+#include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4ParticleTable.hh"
+#include "G4IonTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4AutoLock.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace { G4Mutex sourceMutex = G4MUTEX_INITIALIZER; }
+
+std::map<G4String, PhaseSpaceSource*> PhaseSpaceSource::fSources;
+
+const PhaseSpaceSource* PhaseSpaceSource::GetSource(const G4String& fileName)
+{
+	G4AutoLock lock(&sourceMutex);
+
+	std::map<G4String, PhaseSpaceSource*>::iterator it = fSources.find(fileName);
+	if(it != fSources.end()) return it->second;
+
+	PhaseSpaceSource* source = new PhaseSpaceSource(fileName);
+	fSources[fileName] = source;
+	return source;
+}
+
+size_t PhaseSpaceSource::GetSharedMemoryBytes()
+{
+	G4AutoLock lock(&sourceMutex);
+	size_t bytes = 0;
+	for(std::map<G4String, PhaseSpaceSource*>::const_iterator it=fSources.begin();it!=fSources.end();++it)
+		bytes += it->second->fRecords.capacity()*sizeof(PhaseSpaceRecord)
+				+ it->second->fGroupBegin.capacity()*sizeof(size_t)
+				+ it->second->fEventGroup.capacity()*sizeof(it->second->fEventGroup[0]);
+	return bytes;
+}
+
+PhaseSpaceSource::PhaseSpaceSource(const G4String& fileName)
+:fWrapped(false)
+{
+	// Plain or block-compressed; records are decoded straight into place
+	BlockReader in;
+	std::string error;
+	if(!in.Open(fileName, error) || in.GetSize() < sizeof(fHeader)
+			|| !in.Read(0, reinterpret_cast<char*>(&fHeader), sizeof(fHeader), error)
+			|| strncmp(fHeader.magic, PHSP_MAGIC, sizeof(fHeader.magic)) != 0
+			|| fHeader.recordSize != sizeof(PhaseSpaceRecord))
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot read phase space " << fileName;
+		G4Exception("PhaseSpaceSource::PhaseSpaceSource()", "PhSp101", FatalException, ed);
+		return;
+	}
+
+	const G4bool complete = in.GetSize() >= sizeof(fHeader) + fHeader.nRecords*sizeof(PhaseSpaceRecord);
+	if(complete) fRecords.resize(fHeader.nRecords);
+	if(!complete || (fHeader.nRecords > 0 && !in.Read(sizeof(fHeader), reinterpret_cast<char*>(&fRecords[0]),
+			fHeader.nRecords*sizeof(PhaseSpaceRecord), error)))
+	{
+		G4ExceptionDescription ed;
+		ed << "Phase space " << fileName << " is truncated";
+		G4Exception("PhaseSpaceSource::PhaseSpaceSource()", "PhSp102", FatalException, ed);
+		return;
+	}
+
+	// Records of one stored event are contiguous; the parts of the workers
+	// are concatenated, so the source events are not in order
+	for(size_t i=0;i<fRecords.size();i++)
+	{
+		if(i == 0 || fRecords[i].eventID != fRecords[i-1].eventID)
+		{
+			fEventGroup.push_back(std::make_pair(G4int(fRecords[i].eventID), fGroupBegin.size()));
+			fGroupBegin.push_back(i);
+		}
+	}
+	fGroupBegin.push_back(fRecords.size());
+	std::sort(fEventGroup.begin(), fEventGroup.end());
+
+	if(fRecords.empty())
+	{
+		G4ExceptionDescription ed;
+		ed << "Phase space " << fileName << " contains no records";
+		G4Exception("PhaseSpaceSource::PhaseSpaceSource()", "PhSp103", FatalException, ed);
+		return;
+	}
+
+	G4cout << "Phase space " << fileName << ": " << fRecords.size() << " records, "
+			<< GetNumberOfStoredEvents() << " stored events from " << fHeader.nPrimaries
+			<< " primaries (one event = one primary, " << fHeader.nPrimaries - GetNumberOfStoredEvents()
+			<< " events without records stay empty)" << G4endl;
+}
+
+void PhaseSpaceSource::GeneratePrimaryVertices(G4Event* anEvent) const
+{
+	G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
+
+	G4long source = anEvent->GetEventID();
+	if(fHeader.nPrimaries > 0 && source >= G4long(fHeader.nPrimaries))
+	{
+		source %= G4long(fHeader.nPrimaries);
+		G4AutoLock lock(&sourceMutex);
+		if(!fWrapped)
+		{
+			fWrapped = true;
+			G4ExceptionDescription ed;
+			ed << "More events than the " << fHeader.nPrimaries << " primaries of the phase space:"
+					<< " its primaries are replayed again and the results are not independent";
+			G4Exception("PhaseSpaceSource::GeneratePrimaryVertices()", "PhSp104", JustWarning, ed);
+		}
+	}
+
+	std::vector<std::pair<G4int, size_t> >::const_iterator it = std::lower_bound(fEventGroup.begin(),
+			fEventGroup.end(), std::make_pair(G4int(source), size_t(0)));
+	if(it == fEventGroup.end() || it->first != source) return;
+
+	const size_t group = it->second;
+	for(size_t i=fGroupBegin[group];i<fGroupBegin[group+1];i++)
+	{
+		const PhaseSpaceRecord& rec = fRecords[i];
+
+		G4ParticleDefinition* def = particleTable->FindParticle(rec.pdg);
+		if(!def) def = G4IonTable::GetIonTable()->GetIon(rec.pdg);
+		if(!def) continue;
+
+		G4PrimaryVertex* vertex = new G4PrimaryVertex(G4ThreeVector(rec.x*mm, rec.y*mm, rec.z*mm), 0.);
+		G4PrimaryParticle* particle = new G4PrimaryParticle(def);
+		particle->SetMomentumDirection(G4ThreeVector(rec.dirX, rec.dirY, rec.dirZ));
+		particle->SetKineticEnergy(rec.kinE*MeV);
+		particle->SetWeight(rec.weight);
+		vertex->SetPrimary(particle);
+		anEvent->AddPrimaryVertex(vertex);
+	}
+}
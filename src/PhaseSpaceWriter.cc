@@ -0,0 +1,202 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "PhaseSpaceWriter.hh"
+#include "AsyncWriter.hh"
+#include "MemoryReport.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+PhaseSpaceWriter::PhaseSpaceWriter(const G4String& fileName, G4int bufferSize)
+:fFileName(fileName), fCapacity(bufferSize > 0 ? bufferSize : 1), fNRecords(0),
+ fAsync(AsyncWriter::Instance()->IsRunning()), fOpen(true)
+{
+	fBuffer.reserve(fCapacity);
+	MemoryReport::SetThreadUsage(MemoryReport::kPhaseSpaceBuffer, fBuffer.capacity()*sizeof(PhaseSpaceRecord));
+	// Part file opened by the I/O thread with the first buffer
+	if(fAsync) return;
+	fOut.open(fFileName.c_str(), std::ios::binary | std::ios::trunc);
+	if(!fOut)
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot open phase-space part file " << fFileName;
+		G4Exception("PhaseSpaceWriter::PhaseSpaceWriter()", "PhSp001", FatalException, ed);
+	}
+}
+
+PhaseSpaceWriter::~PhaseSpaceWriter()
+{
+	Close();
+	MemoryReport::SetThreadUsage(MemoryReport::kPhaseSpaceBuffer, 0);
+}
+
+void PhaseSpaceWriter::Flush()
+{
+	if(fBuffer.empty()) return;
+
+	const char* records = reinterpret_cast<const char*>(&fBuffer[0]);
+	const size_t nBytes = fBuffer.size()*sizeof(PhaseSpaceRecord);
+	if(fAsync)
+	{
+		std::string data(records, nBytes);
+		AsyncWriter::Instance()->Append(fFileName, data);
+	}
+	else fOut.write(records, nBytes);
+	fNRecords += fBuffer.size();
+	fBuffer.clear();
+}
+
+void PhaseSpaceWriter::Close()
+{
+	if(!fOpen) return;
+
+	Flush();
+	if(fAsync)
+	{
+		// Creates the part file even when nothing was recorded
+		std::string none;
+		AsyncWriter::Instance()->Append(fFileName, none);
+		AsyncWriter::Instance()->Close(fFileName);
+	}
+	else fOut.close();
+	fOpen = false;
+}
+
+G4bool PhaseSpaceWriter::Merge(const std::vector<G4String>& parts, const G4String& output,
+		G4double planeZ, G4long nPrimaries, BlockCodec codec, size_t blockSize)
+{
+	// Written under a temporary name so an interrupted merge never leaves
+	// a truncated file that looks valid (stage-1 results are cached)
+	G4String tmpName = output + ".tmp";
+	std::ofstream out(tmpName.c_str(), std::ios::binary | std::ios::trunc);
+	if(!out)
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot open phase-space file " << tmpName;
+		G4Exception("PhaseSpaceWriter::Merge()", "PhSp002", JustWarning, ed);
+		return false;
+	}
+
+	// Parts may be block-compressed; the record count is known from their
+	// uncompressed sizes before anything is written. Parts that cannot be
+	// opened are kept on disk and make the merge fail
+	std::vector<BlockReader*> readers;
+	std::vector<G4String> merged;
+	G4bool ok = true;
+	uint64_t nBytes = 0;
+	for(size_t i=0;i<parts.size();i++)
+	{
+		BlockReader* in = new BlockReader();
+		std::string error;
+		if(!in->Open(parts[i], error))
+		{
+			G4ExceptionDescription ed;
+			ed << "Phase-space part not merged, kept: " << error;
+			G4Exception("PhaseSpaceWriter::Merge()", "PhSp004", JustWarning, ed);
+			delete in;
+			ok = false;
+			continue;
+		}
+		readers.push_back(in);
+		merged.push_back(parts[i]);
+		nBytes += in->GetSize() - in->GetSize()%sizeof(PhaseSpaceRecord);
+	}
+
+	PhaseSpaceHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, PHSP_MAGIC, sizeof(header.magic));
+	header.version = PHSP_VERSION;
+	header.recordSize = sizeof(PhaseSpaceRecord);
+	header.nPrimaries = nPrimaries;
+	header.planeZ = planeZ;
+	header.nRecords = nBytes/sizeof(PhaseSpaceRecord);
+
+	BlockWriter writer(codec, blockSize);
+	std::string packed;
+	std::vector<char> chunk(1 << 20);
+	Append(out, codec != kCodecStored ? &writer : 0, reinterpret_cast<const char*>(&header), sizeof(header), packed);
+	// Only parts copied without error are removed
+	std::vector<G4bool> clean(readers.size(), true);
+	for(size_t i=0;i<readers.size();i++)
+	{
+		const uint64_t size = readers[i]->GetSize() - readers[i]->GetSize()%sizeof(PhaseSpaceRecord);
+		std::string error;
+		for(uint64_t offset=0;offset<size;offset+=chunk.size())
+		{
+			const size_t n = std::min(uint64_t(chunk.size()), size - offset);
+			if(!readers[i]->Read(offset, &chunk[0], n, error))
+			{
+				// Keeps the record count consistent with the header
+				memset(&chunk[0], 0, n);
+				G4ExceptionDescription ed;
+				ed << "Corrupt phase-space part, zeroed in the output and kept: " << error;
+				G4Exception("PhaseSpaceWriter::Merge()", "PhSp003", JustWarning, ed);
+				clean[i] = false;
+				ok = false;
+			}
+			Append(out, codec != kCodecStored ? &writer : 0, &chunk[0], n, packed);
+		}
+		delete readers[i];
+	}
+	if(codec != kCodecStored)
+	{
+		writer.Finish(packed);
+		out.write(packed.data(), packed.size());
+	}
+	out.close();
+	if(!out || rename(tmpName.c_str(), output.c_str()) != 0)
+	{
+		// Nothing removed: the parts are all there is
+		G4ExceptionDescription ed;
+		ed << "Cannot write phase-space file " << output << ", parts kept";
+		G4Exception("PhaseSpaceWriter::Merge()", "PhSp002", JustWarning, ed);
+		remove(tmpName.c_str());
+		return false;
+	}
+	for(size_t i=0;i<merged.size();i++)
+		if(clean[i]) remove(merged[i].c_str());
+
+	G4cout << "Phase space: " << header.nRecords << " records from " << nPrimaries
+			<< " primaries written to " << output << G4endl;
+	return ok;
+}
+
+void PhaseSpaceWriter::Append(std::ofstream& out, BlockWriter* writer, const char* data, size_t n, std::string& packed)
+{
+	if(!writer)
+	{
+		out.write(data, n);
+		return;
+	}
+	packed.clear();
+	writer->Write(data, n, packed);
+	out.write(packed.data(), packed.size());
+}
@@ -44,6 +44,7 @@
 
 //
 #include "G4SystemOfUnits.hh"
+#include "SimulationConfig.hh"
 
 PhysicsList::PhysicsList()
 :G4VModularPhysicsList()
@@ -68,19 +69,16 @@ PhysicsList::PhysicsList()
 	RegisterPhysics(new G4NeutronTrackingCut());
 
 	// Optical Physics
-	G4OpticalPhysics* opticalPhysics = new G4OpticalPhysics();
-	RegisterPhysics( opticalPhysics );
+	fOpticalPhysics = new G4OpticalPhysics();
+	RegisterPhysics( fOpticalPhysics );
 
-	opticalPhysics->SetWLSTimeProfile("delta");
+	fOpticalPhysics->SetWLSTimeProfile("delta");
 
-	opticalPhysics->SetScintillationYieldFactor(1.0);
-	opticalPhysics->SetScintillationExcitationRatio(0.0);
+	fOpticalPhysics->SetScintillationYieldFactor(1.0);
+	fOpticalPhysics->SetScintillationExcitationRatio(0.0);
 
-	opticalPhysics->SetMaxNumPhotonsPerStep(1000);
-	opticalPhysics->SetMaxBetaChangePerStep(10.0);
-
-	opticalPhysics->SetTrackSecondariesFirst(kCerenkov,true);
-	opticalPhysics->SetTrackSecondariesFirst(kScintillation,true);
+	fOpticalPhysics->SetMaxNumPhotonsPerStep(1000);
+	fOpticalPhysics->SetMaxBetaChangePerStep(10.0);
 }
 
 PhysicsList::~PhysicsList()
@@ -88,6 +86,18 @@ PhysicsList::~PhysicsList()
 
 }
 
+void PhysicsList::ConstructProcess()
+{
+	// Photons are tracked right after the step that created them, unless
+	// StackingAction defers them until the charged particles are done
+	// (/scint/optical/defer is PreInit only, so the two cannot disagree)
+	const G4bool interleave = !SimulationConfig::Instance()->IsOpticalDeferEnabled();
+	fOpticalPhysics->SetTrackSecondariesFirst(kCerenkov,interleave);
+	fOpticalPhysics->SetTrackSecondariesFirst(kScintillation,interleave);
+
+	G4VModularPhysicsList::ConstructProcess();
+}
+
 void PhysicsList::SetCuts()
 {
 	//G4VUserPhysicsList::SetCuts();
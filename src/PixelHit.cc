@@ -0,0 +1,51 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "PixelHit.hh"
+
+#include "G4SystemOfUnits.hh"
+
+G4ThreadLocal G4Allocator<PixelHit>* PixelHitAllocator = 0;
+
+PixelHit::PixelHit(G4int pixel)
+:G4VHit(), fPixel(pixel), fNPhotons(0), fTime(0.), fEnergy(0.), fWeight(0.)
+{
+
+}
+
+PixelHit::~PixelHit()
+{
+
+}
+
+void PixelHit::Print()
+{
+	G4cout << " pixel " << fPixel << " : " << fNPhotons << " photons, weight " << fWeight
+			<< ", energy " << fEnergy/eV << " eV, first at " << fTime/ns << " ns" << G4endl;
+}
@@ -0,0 +1,245 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "PixelMap.hh"
+#include "BlockFile.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	// Heap cost of one hash map entry (node + bucket), against 8 bytes per dense cell
+	const int64_t kSparseEntryBytes = 40;
+}
+
+PixelMap::PixelMap(int64_t ni, int64_t nj, int64_t nFrames)
+:fNi(ni), fNj(nj), fNFrames(nFrames), fNCells(ni*nj*nFrames), fPitchX(0.), fPitchY(0.), fDense(false)
+{
+	fSwitchSize = fNCells*int64_t(sizeof(double))/kSparseEntryBytes;
+}
+
+void PixelMap::ToDense()
+{
+	fValue.assign(fNCells, 0.);
+	std::unordered_map<int64_t, double>::const_iterator it;
+	for(it=fSparse.begin();it!=fSparse.end();++it) fValue[it->first] = it->second;
+	std::unordered_map<int64_t, double>().swap(fSparse);
+	fDense = true;
+}
+
+bool PixelMap::Add(const PixelMap& other)
+{
+	if(!SameGrid(other)) return false;
+	if(other.fDense)
+	{
+		if(!fDense) ToDense();
+		for(int64_t k=0;k<fNCells;k++) fValue[k] += other.fValue[k];
+		return true;
+	}
+	std::unordered_map<int64_t, double>::const_iterator it;
+	for(it=other.fSparse.begin();it!=other.fSparse.end();++it) Fill(it->first, it->second);
+	return true;
+}
+
+void PixelMap::Scale(double factor)
+{
+	for(size_t k=0;k<fValue.size();k++) fValue[k] *= factor;
+	std::unordered_map<int64_t, double>::iterator it;
+	for(it=fSparse.begin();it!=fSparse.end();++it) it->second *= factor;
+}
+
+double PixelMap::Get(int64_t cell) const
+{
+	if(fDense) return fValue[cell];
+	std::unordered_map<int64_t, double>::const_iterator it = fSparse.find(cell);
+	return it == fSparse.end() ? 0. : it->second;
+}
+
+void PixelMap::GetEntries(std::vector<std::pair<int64_t, double> >& entries) const
+{
+	entries.clear();
+	if(fDense)
+	{
+		for(int64_t k=0;k<fNCells;k++)
+			if(fValue[k] != 0.) entries.push_back(std::make_pair(k, fValue[k]));
+		return;
+	}
+	entries.assign(fSparse.begin(), fSparse.end());
+	std::sort(entries.begin(), entries.end());
+}
+
+void PixelMap::Downsample(int64_t ci, int64_t cj, std::vector<double>& coarse) const
+{
+	coarse.assign(ci*cj, 0.);
+	if(fNi == 0 || fNj == 0) return;
+
+	const int64_t nFrame = fNi*fNj;
+	if(fDense)
+	{
+		for(int64_t k=0;k<fNCells;k++)
+		{
+			if(fValue[k] == 0.) continue;
+			int64_t cell = k%nFrame;
+			coarse[(cell/fNj)*ci/fNi*cj + (cell%fNj)*cj/fNj] += fValue[k];
+		}
+		return;
+	}
+	std::unordered_map<int64_t, double>::const_iterator it;
+	for(it=fSparse.begin();it!=fSparse.end();++it)
+	{
+		int64_t cell = it->first%nFrame;
+		coarse[(cell/fNj)*ci/fNi*cj + (cell%fNj)*cj/fNj] += it->second;
+	}
+}
+
+double PixelMap::GetOccupancy() const
+{
+	if(fNCells == 0) return 0.;
+	if(!fDense) return double(fSparse.size())/fNCells;
+	int64_t n = 0;
+	for(int64_t k=0;k<fNCells;k++) if(fValue[k] != 0.) n++;
+	return double(n)/fNCells;
+}
+
+size_t PixelMap::GetMemoryBytes() const
+{
+	return fDense ? fValue.capacity()*sizeof(double) : fSparse.size()*kSparseEntryBytes;
+}
+
+bool PixelMap::WriteBinary(const std::string& fileName) const
+{
+	std::ofstream out(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	return out && Write(out);
+}
+
+bool PixelMap::ReadBinary(const std::string& fileName, std::string& error)
+{
+	// Plain or block-compressed
+	std::string data;
+	if(!BlockReader::ReadFile(fileName, data, error)) return false;
+	std::istringstream in(data);
+	if(!Read(in, error))
+	{
+		error = fileName + ": " + error;
+		return false;
+	}
+	return true;
+}
+
+bool PixelMap::Write(std::ostream& out) const
+{
+	std::vector<std::pair<int64_t, double> > entries;
+	if(!fDense) GetEntries(entries);
+
+	PixelMapHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, PIXELMAP_MAGIC, sizeof(header.magic));
+	header.version = PIXELMAP_VERSION;
+	header.sparse = fDense ? 0 : 1;
+	header.nFrames = fNFrames;
+	header.ni = fNi;
+	header.nj = fNj;
+	header.nEntries = fDense ? fNCells : entries.size();
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	PixelMapGeometry geometry;
+	geometry.pitchX = fPitchX;
+	geometry.pitchY = fPitchY;
+	out.write(reinterpret_cast<const char*>(&geometry), sizeof(geometry));
+
+	if(fDense)
+	{
+		if(fNCells > 0) out.write(reinterpret_cast<const char*>(&fValue[0]), fNCells*sizeof(double));
+	}
+	else
+	{
+		for(size_t k=0;k<entries.size();k++)
+		{
+			uint64_t cell = entries[k].first;
+			out.write(reinterpret_cast<const char*>(&cell), sizeof(cell));
+			out.write(reinterpret_cast<const char*>(&entries[k].second), sizeof(double));
+		}
+	}
+	return bool(out);
+}
+
+bool PixelMap::Read(std::istream& in, std::string& error)
+{
+	PixelMapHeader header;
+	if(!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| strncmp(header.magic, PIXELMAP_MAGIC, sizeof(header.magic)) != 0)
+	{
+		error = "not a binary pixel map";
+		return false;
+	}
+	// Version 1 maps have no geometry
+	PixelMapGeometry geometry = { 0., 0. };
+	if(header.version < 1 || header.version > PIXELMAP_VERSION
+			|| (header.version >= 2 && !in.read(reinterpret_cast<char*>(&geometry), sizeof(geometry))))
+	{
+		error = "unsupported pixel map version";
+		return false;
+	}
+
+	*this = PixelMap(header.ni, header.nj, header.nFrames);
+	SetPitch(geometry.pitchX, geometry.pitchY);
+	if(!header.sparse)
+	{
+		fValue.assign(fNCells, 0.);
+		fDense = true;
+		if(fNCells > 0) in.read(reinterpret_cast<char*>(&fValue[0]), fNCells*sizeof(double));
+	}
+	else
+	{
+		for(uint64_t k=0;k<header.nEntries && in;k++)
+		{
+			uint64_t cell;
+			double value;
+			in.read(reinterpret_cast<char*>(&cell), sizeof(cell));
+			in.read(reinterpret_cast<char*>(&value), sizeof(value));
+			if(!in) break;
+			if(cell >= uint64_t(fNCells))
+			{
+				error = "pixel map cell out of range";
+				return false;
+			}
+			Fill(cell, value);
+		}
+	}
+	if(!in)
+	{
+		error = "truncated pixel map";
+		return false;
+	}
+	return true;
+}
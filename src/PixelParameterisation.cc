@@ -0,0 +1,63 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "PixelParameterisation.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4ThreeVector.hh"
+
+PixelParameterisation::PixelParameterisation(G4Material* material, G4int nPixel, G4double pitch)
+:G4VNestedParameterisation(), fMaterials(1, material), fNPixel(nPixel), fPitch(pitch)
+{
+}
+
+PixelParameterisation::~PixelParameterisation()
+{
+}
+
+void PixelParameterisation::ComputeTransformation(const G4int copyNo, G4VPhysicalVolume* physVol) const
+{
+	// Same centres as the RepY replicas
+	physVol->SetTranslation(G4ThreeVector(0., (copyNo - 0.5*(fNPixel - 1))*fPitch, 0.));
+}
+
+G4Material* PixelParameterisation::ComputeMaterial(G4VPhysicalVolume*, const G4int, const G4VTouchable*)
+{
+	return fMaterials[0];
+}
+
+G4int PixelParameterisation::GetNumberOfMaterials() const
+{
+	return G4int(fMaterials.size());
+}
+
+G4Material* PixelParameterisation::GetMaterial(G4int idx) const
+{
+	return fMaterials[idx];
+}
@@ -31,9 +31,11 @@
 #include "G4RunManager.hh"
 #include "G4Event.hh"
 #include "G4GeneralParticleSource.hh"
+#include "PhaseSpaceSource.hh"
+#include "SimulationConfig.hh"
 
 PrimaryGeneratorAction::PrimaryGeneratorAction()
-: G4VUserPrimaryGeneratorAction()
+: G4VUserPrimaryGeneratorAction(), fPhspSource(0)
 {
 
 	fPrimary = new G4GeneralParticleSource();
@@ -47,10 +49,20 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
+	const G4String& input = SimulationConfig::Instance()->GetPhaseSpaceInput();
 
+	if(input.empty())
+	{
+		fPrimary->GeneratePrimaryVertex(anEvent);
+		return;
+	}
 
-	fPrimary->GeneratePrimaryVertex(anEvent);
-
+	if(!fPhspSource || input != fPhspSourceFile)
+	{
+		fPhspSource = PhaseSpaceSource::GetSource(input);
+		fPhspSourceFile = input;
+	}
+	fPhspSource->GeneratePrimaryVertices(anEvent);
 
 }
 
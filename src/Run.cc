@@ -0,0 +1,542 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "Run.hh"
+#include "SteppingProfiler.hh"
+#include "SimulationConfig.hh"
+#include "Checkpoint.hh"
+#include "Monitor.hh"
+#include "DetectorConstruction.hh"
+#include "AsyncWriter.hh"
+#include "RunFile.hh"
+#include "PixelHit.hh"
+
+#include "G4Event.hh"
+#include "G4Gamma.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Threading.hh"
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "G4HCofThisEvent.hh"
+
+#include <time.h>
+#include <sstream>
+#include <string>
+
+namespace
+{
+	G4double Clock(clockid_t id)
+	{
+		struct timespec ts;
+		clock_gettime(id, &ts);
+		return ts.tv_sec + 1e-9*ts.tv_nsec;
+	}
+}
+
+Run::Run()
+:G4Run()
+{
+	fGamma = G4Gamma::Definition();
+	fElectron = G4Electron::Definition();
+	fPositron = G4Positron::Definition();
+	fOpticalPhoton = G4OpticalPhoton::Definition();
+
+	for(G4int i=0;i<kNCategories;i++) fSteps[i] = 0;
+	fPhotonsCreated = fPhotonsCulled = fPhotonsDetected = 0;
+	fPhotonsPredictedLost = fPhotonsMispredicted = 0;
+	fReachKept = fReachCulled = 0.;
+
+	// Runs are created at the start of the run on their own thread
+	fThreadId = G4Threading::G4GetThreadId();
+	fWallStart = Clock(CLOCK_MONOTONIC);
+	fCpuStart = Clock(CLOCK_THREAD_CPUTIME_ID);
+	fWallTime = fCpuTime = 0.;
+
+	SimulationConfig* config = SimulationConfig::Instance();
+	fNPixel = config->GetNumberOfPixels();
+	fPixelMap = PixelMap(fNPixel, fNPixel);
+	const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+			G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+	const G4double pitchX = detector->GetScintSizeX()/fNPixel/mm;
+	const G4double pitchY = detector->GetScintSizeY()/fNPixel/mm;
+	fPixelMap.SetPitch(pitchX, pitchY);
+	fSpectrum.assign(SPECTRUM_BINS, 0.);
+	fSpectrumScale = SPECTRUM_BINS/(SPECTRUM_EMAX - SPECTRUM_EMIN);
+
+	fMoments = !config->GetMomentsFile().empty();
+	fHCID = -1;
+	fMomentEvents = 0;
+	fPixelMap2 = PixelMap(fNPixel, fNPixel);
+	fPixelMapT = PixelMap(fNPixel, fNPixel);
+	fRow2.assign(fNPixel, 0.);
+	fColumn2.assign(fNPixel, 0.);
+	fSpectrum2.assign(SPECTRUM_BINS, 0.);
+	fRowT.assign(fNPixel, 0.);
+	fColumnT.assign(fNPixel, 0.);
+	fSpectrumT.assign(SPECTRUM_BINS, 0.);
+	fTotal2 = 0.;
+	if(fMoments)
+	{
+		fEventRow.assign(fNPixel, 0.);
+		fEventColumn.assign(fNPixel, 0.);
+		fEventSpectrum.assign(SPECTRUM_BINS, 0.);
+	}
+
+	fFramePeriod = config->GetFramePeriod();
+	fNFrames = config->GetNumberOfFrames();
+	fTimeOverflow = 0.;
+	if(fFramePeriod > 0.)
+	{
+		fTimeMap = PixelMap(fNPixel, fNPixel, fNFrames);
+		fTimeMap.SetPitch(pitchX, pitchY);
+	}
+
+	fProfiler = config->IsProfilerEnabled() ? new SteppingProfiler(config->GetProfilerSamplePeriod()) : 0;
+
+	fLastPhotonsDetected = 0;
+	fSignalSum = fSignalSum2 = 0.;
+	fMonitorMapPeriod = config->GetMonitorMapPeriod();
+
+	fCheckpointEvents = config->GetCheckpointEvents();
+	fCheckpointInterval = config->GetCheckpointInterval()/s;
+	fLastCheckpointEvent = 0;
+	fLastCheckpointTime = 0.;
+}
+
+Run::~Run()
+{
+	delete fProfiler;
+}
+
+void Run::RecordEvent(const G4Event* anEvent)
+{
+	// Worker runs are merged before the end-of-run action,
+	// so the elapsed time is kept up to date event by event
+	fWallTime = Clock(CLOCK_MONOTONIC) - fWallStart;
+	fCpuTime = Clock(CLOCK_THREAD_CPUTIME_ID) - fCpuStart;
+
+	G4Run::RecordEvent(anEvent);
+	if(fMoments) RecordMoments(anEvent);
+
+	G4double signal = fPhotonsDetected - fLastPhotonsDetected;
+	fLastPhotonsDetected = fPhotonsDetected;
+	fSignalSum += signal;
+	fSignalSum2 += signal*signal;
+
+	Monitor* monitor = Monitor::Instance();
+	if(monitor->IsRunning())
+	{
+		monitor->Publish(fThreadId, numberOfEvent, fSignalSum, fSignalSum2);
+		if(numberOfEvent%fMonitorMapPeriod == 0) monitor->PublishMap(fThreadId, fPixelMap);
+	}
+
+	if((fCheckpointEvents > 0 && numberOfEvent - fLastCheckpointEvent >= fCheckpointEvents)
+			|| (fCheckpointInterval > 0. && fWallTime - fLastCheckpointTime >= fCheckpointInterval))
+	{
+		Checkpoint::WriteWorker(*this);
+		fLastCheckpointEvent = numberOfEvent;
+		fLastCheckpointTime = fWallTime;
+	}
+}
+
+void Run::RecordMoments(const G4Event* anEvent)
+{
+	// One hit per fired pixel holds the signal of the pixel in this event
+	if(fHCID < 0) fHCID = G4SDManager::GetSDMpointer()->GetCollectionID("detector/PixelHits");
+	G4HCofThisEvent* hce = anEvent->GetHCofThisEvent();
+	const PixelHitsCollection* hits = (hce && fHCID >= 0) ? static_cast<const PixelHitsCollection*>(hce->GetHC(fHCID)) : 0;
+
+	const size_t nHits = hits ? hits->entries() : 0;
+	G4double total = 0.;
+	for(size_t k=0;k<nHits;k++)
+	{
+		const G4int pixel = (*hits)[k]->GetPixel();
+		const G4double weight = (*hits)[k]->GetWeight();
+		fPixelMap2.Fill(pixel, weight*weight);
+		fEventRow[pixel/fNPixel] += weight;
+		fEventColumn[pixel%fNPixel] += weight;
+		total += weight;
+	}
+	// Products with the total give the variance of the shape (fractions of
+	// the total), free of the event-to-event yield fluctuation
+	for(size_t k=0;k<nHits;k++) fPixelMapT.Fill((*hits)[k]->GetPixel(), (*hits)[k]->GetWeight()*total);
+	fTotal2 += total*total;
+	for(G4int i=0;i<fNPixel;i++)
+	{
+		fRow2[i] += fEventRow[i]*fEventRow[i];
+		fColumn2[i] += fEventColumn[i]*fEventColumn[i];
+		fRowT[i] += fEventRow[i]*total;
+		fColumnT[i] += fEventColumn[i]*total;
+		fEventRow[i] = fEventColumn[i] = 0.;
+	}
+	for(G4int i=0;i<SPECTRUM_BINS;i++)
+	{
+		fSpectrum2[i] += fEventSpectrum[i]*fEventSpectrum[i];
+		fSpectrumT[i] += fEventSpectrum[i]*total;
+		fEventSpectrum[i] = 0.;
+	}
+	fMomentEvents++;
+}
+
+void Run::Merge(const G4Run* aRun)
+{
+	const Run* localRun = static_cast<const Run*>(aRun);
+
+	if(!Accumulate(*localRun))
+		G4Exception("Run::Merge()", "Run001", FatalException, "Worker pixel map grid differs from the master");
+	fWorkers.push_back(localRun->GetSummary());
+	if(fProfiler && localRun->fProfiler) fProfiler->Merge(*localRun->fProfiler);
+
+	G4Run::Merge(aRun);
+}
+
+G4bool Run::Accumulate(const Run& other)
+{
+	if(!fPixelMap.SameGrid(other.fPixelMap) || !fTimeMap.SameGrid(other.fTimeMap)
+			|| !fPixelMap2.SameGrid(other.fPixelMap2) || !fPixelMapT.SameGrid(other.fPixelMapT)) return false;
+	for(G4int i=0;i<kNCategories;i++) fSteps[i] += other.fSteps[i];
+	fPhotonsCreated += other.fPhotonsCreated;
+	fPhotonsCulled += other.fPhotonsCulled;
+	fPhotonsDetected += other.fPhotonsDetected;
+	fPhotonsPredictedLost += other.fPhotonsPredictedLost;
+	fPhotonsMispredicted += other.fPhotonsMispredicted;
+	fReachKept += other.fReachKept;
+	fReachCulled += other.fReachCulled;
+
+	fPixelMap.Add(other.fPixelMap);
+	for(size_t i=0;i<fSpectrum.size();i++) fSpectrum[i] += other.fSpectrum[i];
+
+	fTimeMap.Add(other.fTimeMap);
+	fTimeOverflow += other.fTimeOverflow;
+
+	fMomentEvents += other.fMomentEvents;
+	fPixelMap2.Add(other.fPixelMap2);
+	fPixelMapT.Add(other.fPixelMapT);
+	for(G4int i=0;i<fNPixel;i++)
+	{
+		fRow2[i] += other.fRow2[i];
+		fColumn2[i] += other.fColumn2[i];
+		fRowT[i] += other.fRowT[i];
+		fColumnT[i] += other.fColumnT[i];
+	}
+	for(size_t i=0;i<fSpectrum2.size();i++)
+	{
+		fSpectrum2[i] += other.fSpectrum2[i];
+		fSpectrumT[i] += other.fSpectrumT[i];
+	}
+	fTotal2 += other.fTotal2;
+	return true;
+}
+
+void Run::ScaleSignal(G4double factor)
+{
+	fPixelMap.Scale(factor);
+	for(size_t i=0;i<fSpectrum.size();i++) fSpectrum[i] *= factor;
+	fTimeMap.Scale(factor);
+	fTimeOverflow *= factor;
+
+	// Squares scale with the square of the factor
+	const G4double factor2 = factor*factor;
+	fPixelMap2.Scale(factor2);
+	fPixelMapT.Scale(factor2);
+	for(G4int i=0;i<fNPixel;i++)
+	{
+		fRow2[i] *= factor2;
+		fColumn2[i] *= factor2;
+		fRowT[i] *= factor2;
+		fColumnT[i] *= factor2;
+	}
+	for(size_t i=0;i<fSpectrum2.size();i++)
+	{
+		fSpectrum2[i] *= factor2;
+		fSpectrumT[i] *= factor2;
+	}
+	fTotal2 *= factor2;
+}
+
+G4bool Run::Restore(const Run& previous)
+{
+	if(!Accumulate(previous)) return false;
+	numberOfEvent += previous.numberOfEvent;
+	return true;
+}
+
+G4bool Run::WriteState(std::ostream& out) const
+{
+	int64_t nEvents = numberOfEvent;
+	out.write(reinterpret_cast<const char*>(&nEvents), sizeof(nEvents));
+	out.write(reinterpret_cast<const char*>(fSteps), sizeof(fSteps));
+	out.write(reinterpret_cast<const char*>(&fPhotonsCreated), sizeof(fPhotonsCreated));
+	out.write(reinterpret_cast<const char*>(&fPhotonsCulled), sizeof(fPhotonsCulled));
+	out.write(reinterpret_cast<const char*>(&fPhotonsDetected), sizeof(fPhotonsDetected));
+	out.write(reinterpret_cast<const char*>(&fPhotonsPredictedLost), sizeof(fPhotonsPredictedLost));
+	out.write(reinterpret_cast<const char*>(&fPhotonsMispredicted), sizeof(fPhotonsMispredicted));
+	out.write(reinterpret_cast<const char*>(&fReachKept), sizeof(fReachKept));
+	out.write(reinterpret_cast<const char*>(&fReachCulled), sizeof(fReachCulled));
+	out.write(reinterpret_cast<const char*>(&fSpectrum[0]), fSpectrum.size()*sizeof(G4double));
+	out.write(reinterpret_cast<const char*>(&fTimeOverflow), sizeof(fTimeOverflow));
+	int64_t nMomentEvents = fMomentEvents;
+	out.write(reinterpret_cast<const char*>(&nMomentEvents), sizeof(nMomentEvents));
+	out.write(reinterpret_cast<const char*>(&fTotal2), sizeof(fTotal2));
+	out.write(reinterpret_cast<const char*>(&fRow2[0]), fRow2.size()*sizeof(G4double));
+	out.write(reinterpret_cast<const char*>(&fColumn2[0]), fColumn2.size()*sizeof(G4double));
+	out.write(reinterpret_cast<const char*>(&fSpectrum2[0]), fSpectrum2.size()*sizeof(G4double));
+	out.write(reinterpret_cast<const char*>(&fRowT[0]), fRowT.size()*sizeof(G4double));
+	out.write(reinterpret_cast<const char*>(&fColumnT[0]), fColumnT.size()*sizeof(G4double));
+	out.write(reinterpret_cast<const char*>(&fSpectrumT[0]), fSpectrumT.size()*sizeof(G4double));
+	return fPixelMap.Write(out) && fTimeMap.Write(out) && fPixelMap2.Write(out) && fPixelMapT.Write(out);
+}
+
+G4bool Run::ReadState(std::istream& in)
+{
+	int64_t nEvents = 0;
+	in.read(reinterpret_cast<char*>(&nEvents), sizeof(nEvents));
+	in.read(reinterpret_cast<char*>(fSteps), sizeof(fSteps));
+	in.read(reinterpret_cast<char*>(&fPhotonsCreated), sizeof(fPhotonsCreated));
+	in.read(reinterpret_cast<char*>(&fPhotonsCulled), sizeof(fPhotonsCulled));
+	in.read(reinterpret_cast<char*>(&fPhotonsDetected), sizeof(fPhotonsDetected));
+	in.read(reinterpret_cast<char*>(&fPhotonsPredictedLost), sizeof(fPhotonsPredictedLost));
+	in.read(reinterpret_cast<char*>(&fPhotonsMispredicted), sizeof(fPhotonsMispredicted));
+	in.read(reinterpret_cast<char*>(&fReachKept), sizeof(fReachKept));
+	in.read(reinterpret_cast<char*>(&fReachCulled), sizeof(fReachCulled));
+	in.read(reinterpret_cast<char*>(&fSpectrum[0]), fSpectrum.size()*sizeof(G4double));
+	in.read(reinterpret_cast<char*>(&fTimeOverflow), sizeof(fTimeOverflow));
+	int64_t nMomentEvents = 0;
+	in.read(reinterpret_cast<char*>(&nMomentEvents), sizeof(nMomentEvents));
+	in.read(reinterpret_cast<char*>(&fTotal2), sizeof(fTotal2));
+	in.read(reinterpret_cast<char*>(&fRow2[0]), fRow2.size()*sizeof(G4double));
+	in.read(reinterpret_cast<char*>(&fColumn2[0]), fColumn2.size()*sizeof(G4double));
+	in.read(reinterpret_cast<char*>(&fSpectrum2[0]), fSpectrum2.size()*sizeof(G4double));
+	in.read(reinterpret_cast<char*>(&fRowT[0]), fRowT.size()*sizeof(G4double));
+	in.read(reinterpret_cast<char*>(&fColumnT[0]), fColumnT.size()*sizeof(G4double));
+	in.read(reinterpret_cast<char*>(&fSpectrumT[0]), fSpectrumT.size()*sizeof(G4double));
+	numberOfEvent = nEvents;
+	fMomentEvents = nMomentEvents;
+
+	// Grid and frames must match the current configuration
+	std::string error;
+	PixelMap map, timeMap, map2, mapT;
+	if(!in || !map.Read(in, error) || !timeMap.Read(in, error) || !map2.Read(in, error) || !mapT.Read(in, error)
+			|| map.GetNCells() != fPixelMap.GetNCells() || timeMap.GetNCells() != fTimeMap.GetNCells()
+			|| map2.GetNCells() != fPixelMap2.GetNCells() || mapT.GetNCells() != fPixelMapT.GetNCells())
+		return false;
+	fPixelMap = map;
+	fTimeMap = timeMap;
+	fPixelMap2 = map2;
+	fPixelMapT = mapT;
+	return true;
+}
+
+G4long Run::GetTotalSteps() const
+{
+	G4long total = 0;
+	for(G4int i=0;i<kNCategories;i++) total += fSteps[i];
+	return total;
+}
+
+Run::WorkerSummary Run::GetSummary() const
+{
+	WorkerSummary summary;
+	summary.threadId = fThreadId;
+	summary.nEvents = numberOfEvent;
+	summary.wallTime = fWallTime;
+	summary.cpuTime = fCpuTime;
+	summary.nSteps = GetTotalSteps();
+	summary.nPhotonsCreated = fPhotonsCreated;
+	summary.nPhotonsDetected = fPhotonsDetected;
+	// Called on the worker thread (Merge), its other components are current
+	for(G4int c=0;c<MemoryReport::kNComponents;c++) summary.memory[c] = MemoryReport::GetThreadUsage(c);
+	summary.memory[MemoryReport::kPixelMaps] = fPixelMap.GetMemoryBytes() + fTimeMap.GetMemoryBytes()
+			+ fPixelMap2.GetMemoryBytes() + fPixelMapT.GetMemoryBytes()
+			+ (fSpectrum.capacity() + fSpectrum2.capacity() + fSpectrumT.capacity() + fEventSpectrum.capacity()
+			+ fRow2.capacity() + fColumn2.capacity() + fRowT.capacity() + fColumnT.capacity()
+			+ fEventRow.capacity() + fEventColumn.capacity())*sizeof(G4double);
+	return summary;
+}
+
+const char* Run::GetCategoryName(G4int category)
+{
+	static const char* names[kNCategories] = { "gamma", "e-", "e+", "opticalphoton", "other" };
+	return names[category];
+}
+
+void Run::WriteMap(const G4String& fileName, G4bool binary) const
+{
+	// Formatted here, written by the I/O thread
+	std::ostringstream ofs;
+	if(binary) fPixelMap.Write(ofs);
+	else
+	{
+		for(G4int i=0;i<fNPixel;i++){
+			for(G4int j=0;j<fNPixel;j++){
+				ofs<< i << "\t"<<j<<"\t"<<fPixelMap.Get(i*fNPixel+j)<<"\n";
+			}
+			ofs<<"\n";
+		}
+	}
+	std::string data = ofs.str();
+	AsyncWriter::Instance()->WriteFile(fileName, data);
+}
+
+void Run::WriteSpectrum(const G4String& fileName) const
+{
+	std::ostringstream ofs;
+	for(G4int i=0;i<SPECTRUM_BINS;i++){
+		ofs<< (SPECTRUM_EMIN + i/fSpectrumScale)/eV << "\t" << fSpectrum[i] << "\n";
+	}
+	std::string data = ofs.str();
+	AsyncWriter::Instance()->WriteFile(fileName, data);
+}
+
+G4bool Run::WriteMoments(const G4String& fileName) const
+{
+	// Events restored without moments would bias the variances
+	if(fMomentEvents != numberOfEvent)
+	{
+		G4ExceptionDescription ed;
+		ed << "Event moments cover " << fMomentEvents << " of " << numberOfEvent << " events, "
+				<< fileName << " not written";
+		G4Exception("Run::WriteMoments()", "Out006", JustWarning, ed);
+		return false;
+	}
+
+	std::vector<std::pair<int64_t, double> > entries;
+	fPixelMap.GetEntries(entries);
+	std::vector<G4double> rows(fNPixel, 0.), columns(fNPixel, 0.);
+	G4double total = 0.;
+	for(size_t k=0;k<entries.size();k++)
+	{
+		rows[entries[k].first/fNPixel] += entries[k].second;
+		columns[entries[k].first%fNPixel] += entries[k].second;
+		total += entries[k].second;
+	}
+
+	// Full precision: variances are differences of these sums
+	std::ostringstream ofs;
+	ofs.precision(17);
+	ofs<< "# sums over events of the per-event signal and of its square\n";
+	ofs<< "events " << numberOfEvent << "\n";
+	ofs<< "grid " << fNPixel << " " << fNPixel << "\n";
+	ofs<< "total\t" << total << "\t" << fTotal2 << "\n";
+	for(G4int i=0;i<fNPixel;i++)
+		ofs<< "row\t" << i << "\t" << rows[i] << "\t" << fRow2[i] << "\t" << fRowT[i] << "\n";
+	for(G4int j=0;j<fNPixel;j++)
+		ofs<< "column\t" << j << "\t" << columns[j] << "\t" << fColumn2[j] << "\t" << fColumnT[j] << "\n";
+	for(G4int k=0;k<SPECTRUM_BINS;k++)
+		ofs<< "spectrum\t" << k << "\t" << fSpectrum[k] << "\t" << fSpectrum2[k] << "\t" << fSpectrumT[k] << "\n";
+	for(size_t k=0;k<entries.size();k++)
+	{
+		ofs<< "pixel\t" << entries[k].first/fNPixel << "\t" << entries[k].first%fNPixel << "\t" << entries[k].second
+				<< "\t" << fPixelMap2.Get(entries[k].first) << "\t" << fPixelMapT.Get(entries[k].first) << "\n";
+	}
+	std::string data = ofs.str();
+	AsyncWriter::Instance()->WriteFile(fileName, data);
+	return true;
+}
+
+void Run::WriteTimeMap(const G4String& fileName, G4bool binary) const
+{
+	if(fFramePeriod <= 0.) return;
+	std::ostringstream ofs;
+	if(binary)
+	{
+		fTimeMap.Write(ofs);
+		std::string data = ofs.str();
+		AsyncWriter::Instance()->WriteFile(fileName, data);
+		return;
+	}
+
+	// Sorted by frame, then row-major pixel
+	std::vector<std::pair<int64_t, double> > entries;
+	fTimeMap.GetEntries(entries);
+
+	const G4long nPixel2 = G4long(fNPixel)*fNPixel;
+	ofs<< "# frame period [ms] " << fFramePeriod/ms << ", frames " << fNFrames
+			<< ", pixels " << fNPixel << ", overflow " << fTimeOverflow << "\n";
+	for(size_t k=0;k<entries.size();k++){
+		G4long frame = entries[k].first/nPixel2;
+		G4long pixel = entries[k].first%nPixel2;
+		ofs<< frame << "\t" << pixel/fNPixel << "\t" << pixel%fNPixel << "\t" << entries[k].second << "\n";
+	}
+	std::string data = ofs.str();
+	AsyncWriter::Instance()->WriteFile(fileName, data);
+}
+
+void Run::WriteContainer(RunFileWriter& out, const G4String& group) const
+{
+	std::ostringstream pitchX, pitchY;
+	pitchX << fPixelMap.GetPitchX();
+	pitchY << fPixelMap.GetPitchY();
+	RunFileAttributes mapAttributes;
+	mapAttributes.push_back(std::make_pair("pitch_x_mm", pitchX.str()));
+	mapAttributes.push_back(std::make_pair("pitch_y_mm", pitchY.str()));
+	mapAttributes.push_back(std::make_pair("layout", "[i][j], i along y, j along x"));
+
+	std::vector<double> map;
+	fPixelMap.Downsample(fNPixel, fNPixel, map);
+	std::vector<uint64_t> shape(2, fNPixel);
+	out.AddArray(group + "map", &map[0], shape, mapAttributes);
+
+	std::ostringstream eMin, width;
+	eMin << SPECTRUM_EMIN/eV;
+	width << 1./fSpectrumScale/eV;
+	RunFileAttributes spectrumAttributes;
+	spectrumAttributes.push_back(std::make_pair("e_min_eV", eMin.str()));
+	spectrumAttributes.push_back(std::make_pair("bin_width_eV", width.str()));
+	out.AddArray(group + "spectrum", &fSpectrum[0], std::vector<uint64_t>(1, fSpectrum.size()), spectrumAttributes);
+
+	if(fFramePeriod <= 0.) return;
+
+	// Sparse: cell = (frame*nPixel + i)*nPixel + j of every non-zero entry
+	std::vector<std::pair<int64_t, double> > entries;
+	fTimeMap.GetEntries(entries);
+	std::vector<int64_t> cells(entries.size());
+	std::vector<double> values(entries.size());
+	for(size_t k=0;k<entries.size();k++)
+	{
+		cells[k] = entries[k].first;
+		values[k] = entries[k].second;
+	}
+	std::ostringstream period, frames, pixels, overflow;
+	period << fFramePeriod/ms;
+	frames << fNFrames;
+	pixels << fNPixel;
+	overflow << fTimeOverflow;
+	RunFileAttributes timeAttributes;
+	timeAttributes.push_back(std::make_pair("frame_period_ms", period.str()));
+	timeAttributes.push_back(std::make_pair("frames", frames.str()));
+	timeAttributes.push_back(std::make_pair("pixels", pixels.str()));
+	timeAttributes.push_back(std::make_pair("overflow", overflow.str()));
+	timeAttributes.push_back(std::make_pair("cell", "(frame*pixels + i)*pixels + j"));
+	const std::vector<uint64_t> n(1, entries.size());
+	out.AddArray(group + "time_map/cells", cells.empty() ? 0 : &cells[0], n, timeAttributes);
+	out.AddArray(group + "time_map/values", values.empty() ? 0 : &values[0], n, timeAttributes);
+}
@@ -0,0 +1,567 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "RunAction.hh"
+#include "Run.hh"
+#include "SteppingProfiler.hh"
+#include "PhaseSpaceWriter.hh"
+#include "EventWriter.hh"
+#include "SimulationConfig.hh"
+#include "Checkpoint.hh"
+#include "Monitor.hh"
+#include "SpectralResponse.hh"
+#include "OutputManager.hh"
+#include "AsyncWriter.hh"
+#include "RunFile.hh"
+#include "DetectorConstruction.hh"
+#include "PhaseSpaceSource.hh"
+#include "MemoryReport.hh"
+
+#include "G4Run.hh"
+#include "G4Threading.hh"
+#include "G4AutoLock.hh"
+#include "G4MTRunManager.hh"
+#include "G4Material.hh"
+#include "Randomize.hh"
+
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+namespace
+{
+	// Part files of the phase space and the event dataset
+	G4Mutex partMutex = G4MUTEX_INITIALIZER;
+
+	G4double WallClock()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + 1e-9*ts.tv_nsec;
+	}
+
+	// CPU time of the whole process (all threads)
+	G4double ProcessCpu()
+	{
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_utime.tv_sec + 1e-6*usage.ru_utime.tv_usec
+				+ usage.ru_stime.tv_sec + 1e-6*usage.ru_stime.tv_usec;
+	}
+
+	G4double Rate(G4double n, G4double t) { return t > 0. ? n/t : 0.; }
+
+	G4double MB(size_t bytes) { return bytes/1048576.; }
+
+	// Read-only data held once for all threads
+	size_t SharedDataBytes()
+	{
+		const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+				G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+		return (detector ? detector->GetVoxelMemoryBytes() : 0)
+				+ PhaseSpaceSource::GetSharedMemoryBytes()
+				+ SpectralResponse::Instance()->GetMemoryBytes();
+	}
+
+	// Taken during static initialization, i.e. at process start
+	const G4double processStart = WallClock();
+	G4double startupTime = -1.;
+	// Resident set and shared data at the first run, before the workers start
+	size_t startupRSS = 0;
+	size_t startupShared = 0;
+
+	// Process growth since startup not explained by shared data, per worker
+	size_t WorkerEstimate(size_t nWorkers)
+	{
+		const size_t rss = MemoryReport::GetResidentSize();
+		const size_t shared = SharedDataBytes();
+		const size_t base = startupRSS + (shared > startupShared ? shared - startupShared : 0);
+		return (nWorkers && rss > base) ? (rss - base)/nWorkers : 0;
+	}
+}
+
+std::vector<G4String> RunAction::fPhspParts;
+std::vector<G4String> RunAction::fEventParts;
+
+RunAction::RunAction()
+:G4UserRunAction(), fRun(0), fPhspWriter(0), fEventWriter(0)
+{
+	fWallStart = fWallTime = fCpuStart = fCpuTime = 0.;
+
+}
+
+RunAction::~RunAction()
+{
+	delete fPhspWriter;
+	delete fEventWriter;
+}
+
+G4bool RunAction::IsWorkerRole() const
+{
+	// In sequential mode the single RunAction plays both roles
+	#ifdef G4MULTITHREADED
+	return !IsMaster();
+	#else
+	return true;
+	#endif
+}
+
+G4Run* RunAction::GenerateRun()
+{
+	fRun = new Run();
+	return fRun;
+}
+
+void RunAction::BeginOfRunAction(const G4Run*)
+{
+	SimulationConfig* config = SimulationConfig::Instance();
+
+	if(IsMaster())
+	{
+		fWallStart = WallClock();
+		fCpuStart = ProcessCpu();
+		// Process start to the first run: initialization and physics tables
+		if(startupTime < 0.)
+		{
+			startupTime = fWallStart - processStart;
+			startupRSS = MemoryReport::GetResidentSize();
+			startupShared = SharedDataBytes();
+			G4cout << "Memory at startup: " << MB(startupRSS) << " MB resident, "
+					<< MB(startupShared) << " MB shared read-only data" << G4endl;
+		}
+
+		OutputManager::Instance()->BeginRun(fRun->GetRunID(), G4Random::getTheSeed());
+
+		// Photons of the analytic transport never reach the detector as
+		// tracks, so a validation would count no mispredictions
+		if(config->GetOpticalFilter() == kFilterValidate && config->GetOpticalTransport() == kAnalyticTransport
+				&& config->GetReadout() == kFaceReadout)
+		{
+			G4Exception("RunAction::BeginOfRunAction()", "Opt003", JustWarning,
+					"Filter validation requires /scint/optical/transport geant4; filter switched off");
+			config->SetOpticalFilter(kFilterOff);
+		}
+
+		G4AutoLock lock(&partMutex);
+		fPhspParts.clear();
+		fEventParts.clear();
+		lock.unlock();
+
+		// Workers only look the table up once their event loop has started
+		if(config->GetResponseMode() != kResponseOff)
+			SpectralResponse::Instance()->Build(config->GetResponseFile(), config->IsResponseWavelength());
+
+		AsyncWriter::Instance()->SetCompression(config->GetCompression(), config->GetCompressionBlockSize());
+		// Started after the base checkpoint, which must be on disk before
+		// the worker files of the previous job are removed
+		if(config->IsCheckpointEnabled()) Checkpoint::BeginRun(*fRun);
+		if(config->IsAsyncOutput()) AsyncWriter::Instance()->Start(config->GetAsyncQueueSize());
+
+		if(!config->GetMonitorSocket().empty())
+		{
+			G4int nThreads = 1;
+			#ifdef G4MULTITHREADED
+			nThreads = G4MTRunManager::GetMasterRunManager()->GetNumberOfThreads();
+			#endif
+			Monitor::Instance()->Start(config->GetMonitorSocket(), nThreads,
+					fRun->GetNumberOfEventToBeProcessed(), config->GetNumberOfPixels(), config->GetMonitorMapSize());
+		}
+	}
+
+	if(IsWorkerRole() && config->IsPhaseSpaceEnabled())
+	{
+		std::ostringstream name;
+		name << config->GetPhaseSpaceFile() << ".part" << G4Threading::G4GetThreadId();
+		fPhspWriter = new PhaseSpaceWriter(OutputManager::Instance()->Path(name.str()),
+				config->GetPhaseSpaceBufferSize());
+	}
+
+	if(IsWorkerRole() && config->IsEventOutputEnabled())
+	{
+		std::ostringstream name;
+		name << config->GetEventFile() << ".part" << G4Threading::G4GetThreadId();
+		fEventWriter = new EventWriter(OutputManager::Instance()->Path(name.str()), config->GetNumberOfPixels(),
+				config->GetEventEncoding(), config->GetEventBufferSize());
+	}
+}
+
+void RunAction::EndOfRunAction(const G4Run* aRun)
+{
+	SimulationConfig* config = SimulationConfig::Instance();
+
+	OutputManager* output = OutputManager::Instance();
+
+	if(IsWorkerRole())
+	{
+		std::ostringstream name;
+		name << "ThreadMap_" << std::setw(3) << std::setfill('0') << std::max(fRun->GetThreadId(), 0) << ".out";
+		const G4String fileName = output->Path(name.str());
+		fRun->WriteMap(fileName);
+		output->Register(fileName, "per-thread pixel map", fRun->GetThreadId());
+	}
+
+	if(fPhspWriter)
+	{
+		fPhspWriter->Close();
+		G4AutoLock lock(&partMutex);
+		fPhspParts.push_back(fPhspWriter->GetFileName());
+		delete fPhspWriter;
+		fPhspWriter = 0;
+	}
+
+	if(fEventWriter)
+	{
+		fEventWriter->Close();
+		G4AutoLock lock(&partMutex);
+		fEventParts.push_back(fEventWriter->GetFileName());
+		delete fEventWriter;
+		fEventWriter = 0;
+	}
+
+	// Workers have all finished when the master reaches this point,
+	// their part files and maps may still be queued
+	if(IsMaster()) AsyncWriter::Instance()->Flush();
+
+	if(IsMaster() && config->IsPhaseSpaceEnabled())
+	{
+		G4AutoLock lock(&partMutex);
+		const G4String fileName = output->Path(config->GetPhaseSpaceFile());
+		if(PhaseSpaceWriter::Merge(fPhspParts, fileName, config->GetPhaseSpacePlaneZ(), aRun->GetNumberOfEvent(),
+				config->GetCompression(), config->GetCompressionBlockSize()))
+			output->Register(fileName, "phase space");
+		else
+		{
+			G4ExceptionDescription ed;
+			ed << "Phase space " << fileName << " is incomplete or missing; parts that were not merged cleanly ("
+					<< fileName << ".part<thread>) are kept";
+			G4Exception("RunAction::EndOfRunAction()", "Out005", JustWarning, ed);
+		}
+		fPhspParts.clear();
+	}
+
+	if(IsMaster() && config->IsEventOutputEnabled())
+	{
+		G4AutoLock lock(&partMutex);
+		const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+				G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+		const G4int nPixel = config->GetNumberOfPixels();
+		const G4String fileName = output->Path(config->GetEventFile());
+		if(EventWriter::Merge(fEventParts, fileName, nPixel,
+				detector->GetScintSizeX()/nPixel, detector->GetScintSizeY()/nPixel))
+			output->Register(fileName, "event dataset");
+		else
+		{
+			G4ExceptionDescription ed;
+			ed << "Event dataset " << fileName << " is incomplete or missing; parts that were not merged cleanly ("
+					<< fileName << ".part<thread>.index/.data) are kept";
+			G4Exception("RunAction::EndOfRunAction()", "Out005", JustWarning, ed);
+		}
+		fEventParts.clear();
+	}
+
+	if(IsMaster())
+	{
+		Monitor::Instance()->Stop();
+
+		fWallTime = WallClock() - fWallStart;
+		fCpuTime = ProcessCpu() - fCpuStart;
+
+		// Statistics describe this job only, the outputs include resumed results
+		PrintStatistics(fRun);
+		WriteStatistics(fRun);
+		if(fRun->GetProfiler()) fRun->GetProfiler()->Print(config->GetProfilerMaxRows());
+
+		const G4int nJobEvents = fRun->GetNumberOfEvent();
+		Checkpoint::RestoreInto(fRun);
+		if(config->IsOpticalFilterCorrection() && fRun->GetFilterCorrection() != 1.)
+			fRun->ScaleSignal(fRun->GetFilterCorrection());
+		const G4String mapFile = output->Path(config->GetMapFile());
+		fRun->WriteMap(mapFile, config->IsBinaryOutput());
+		output->Register(mapFile, "merged pixel map");
+		const G4String spectrumFile = output->Path(config->GetSpectrumFile());
+		fRun->WriteSpectrum(spectrumFile);
+		output->Register(spectrumFile, "detected photon spectrum");
+		if(!config->GetMomentsFile().empty())
+		{
+			const G4String momentsFile = output->Path(config->GetMomentsFile());
+			if(fRun->WriteMoments(momentsFile)) output->Register(momentsFile, "event moments");
+		}
+		if(config->GetFramePeriod() > 0.)
+		{
+			const G4String timeMapFile = output->Path(config->GetTimeMapFile());
+			fRun->WriteTimeMap(timeMapFile, config->IsBinaryOutput());
+			output->Register(timeMapFile, "time-resolved pixel map");
+		}
+		if(!config->GetContainerFile().empty()) WriteContainer(fRun, nJobEvents);
+
+		AsyncWriter::Instance()->Stop();
+		if(config->IsCheckpointEnabled()) Checkpoint::EndRun();
+		output->EndRun(fRun->GetNumberOfEvent());
+	}
+}
+
+void RunAction::PrintStatistics(const Run* aRun) const
+{
+	const G4int nEvents = aRun->GetNumberOfEvent();
+
+	G4cout << G4endl
+			<< "--------------------------- Run statistics ---------------------------" << G4endl
+			<< " Events            : " << nEvents << G4endl
+			<< " Wall time [s]     : " << fWallTime << G4endl
+			<< " CPU time [s]      : " << fCpuTime << G4endl
+			<< " Startup time [s]  : " << startupTime << G4endl
+			<< " Peak RSS [MB]     : " << MB(MemoryReport::GetPeakResidentSize()) << G4endl
+			<< " Events/s          : " << Rate(nEvents, fWallTime) << G4endl
+			<< " Steps/s           : " << Rate(aRun->GetTotalSteps(), fWallTime) << G4endl;
+	for(G4int i=0;i<Run::kNCategories;i++)
+	{
+		G4cout << "   " << std::setw(14) << std::left << Run::GetCategoryName(i) << std::right
+				<< " : " << aRun->GetSteps(i) << " steps, " << Rate(aRun->GetSteps(i), fWallTime)
+				<< " steps/s" << G4endl;
+	}
+	G4cout << " Optical photons   : " << aRun->GetPhotonsCreated() << " created ("
+			<< Rate(aRun->GetPhotonsCreated(), fWallTime) << " /s), "
+			<< aRun->GetPhotonsDetected() << " detected" << G4endl;
+	if(aRun->GetPhotonsCulled() > 0)
+		G4cout << " Culled photons    : " << aRun->GetPhotonsCulled() << " ("
+				<< 100.*aRun->GetPhotonsCulled()/aRun->GetPhotonsCreated() << " % of created), correction "
+				<< aRun->GetFilterCorrection() << G4endl;
+	if(SimulationConfig::Instance()->GetOpticalFilter() == kFilterValidate)
+		G4cout << " Filter validation : " << aRun->GetPhotonsPredictedLost() << " predicted lost, "
+				<< aRun->GetPhotonsMispredicted() << " of them detected; expected detected <= "
+				<< aRun->GetReachKept() << G4endl;
+	if(SimulationConfig::Instance()->GetResponseMode() != kResponseOff)
+		G4cout << " Spectral response : " << SimulationConfig::Instance()->GetResponseFile() << ", mean "
+				<< SpectralResponse::Instance()->GetMean() << " over the emission grid" << G4endl;
+	const AsyncWriter* writer = AsyncWriter::Instance();
+	if(writer->IsRunning())
+		G4cout << " Async output      : " << writer->GetBytesWritten()/1048576. << " MB in "
+				<< writer->GetBuffersWritten() << " buffers, " << writer->GetBytesStored()/1048576. << " MB stored ("
+				<< GetBlockCodecName(writer->GetCodec()) << "), I/O thread busy " << writer->GetWriteTime()
+				<< " s, writers waited " << writer->GetProducerWait() << " s, queue peak "
+				<< writer->GetMaxQueuedBytes()/1048576. << " MB" << G4endl;
+	const PixelMap& map = aRun->GetPixelMap();
+	G4cout << " Pixel map         : " << (map.IsDense() ? "dense" : "sparse") << ", occupancy "
+			<< 100.*map.GetOccupancy() << " %, " << map.GetMemoryBytes()/1024. << " kB" << G4endl;
+
+	const std::vector<Run::WorkerSummary>& workers = aRun->GetWorkerSummaries();
+	for(size_t i=0;i<workers.size();i++)
+	{
+		const Run::WorkerSummary& w = workers[i];
+		G4cout << " Worker " << std::setw(3) << w.threadId << " : " << w.nEvents << " events, "
+				<< Rate(w.nEvents, w.wallTime) << " events/s, "
+				<< Rate(w.nSteps, w.wallTime) << " steps/s, "
+				<< Rate(w.nPhotonsCreated, w.wallTime) << " photons/s, "
+				<< "wall " << w.wallTime << " s, cpu " << w.cpuTime << " s" << G4endl;
+	}
+
+	// Geant4 per-thread state (physics vectors, navigators, allocator
+	// pages) is not accounted and only shows in the estimate per worker
+	G4cout << " Memory [MB]       : " << MB(MemoryReport::GetResidentSize()) << " resident, "
+			<< MB(startupRSS) << " at startup, " << MB(SharedDataBytes()) << " shared read-only, ~"
+			<< MB(WorkerEstimate(workers.size())) << " per worker" << G4endl;
+	for(size_t i=0;i<workers.size();i++)
+	{
+		const Run::WorkerSummary& w = workers[i];
+		G4cout << "   Worker " << std::setw(3) << w.threadId << " :";
+		for(G4int c=0;c<MemoryReport::kNComponents;c++)
+			G4cout << (c ? ", " : " ") << MemoryReport::GetComponentName(c) << " " << MB(w.memory[c]);
+		G4cout << G4endl;
+	}
+	G4cout << "----------------------------------------------------------------------" << G4endl;
+}
+
+void RunAction::WriteStatistics(const Run* aRun) const
+{
+	const G4String& statsFile = SimulationConfig::Instance()->GetStatisticsFile();
+	if(statsFile.empty()) return;
+
+	const G4String fileName = OutputManager::Instance()->Path(statsFile);
+	OutputManager::Instance()->Register(fileName, "run statistics");
+	std::ofstream out(fileName.c_str());
+	FormatStatistics(aRun, out);
+	out.close();
+}
+
+void RunAction::FormatStatistics(const Run* aRun, std::ostream& out) const
+{
+	const G4int nEvents = aRun->GetNumberOfEvent();
+
+	out << std::setprecision(10);
+	out << "{\n";
+	out << "  \"events\": " << nEvents << ",\n";
+	out << "  \"pixel_layout\": \"" << SimulationConfig::Instance()->GetPixelLayoutName() << "\",\n";
+	out << "  \"wall_time_s\": " << fWallTime << ",\n";
+	out << "  \"cpu_time_s\": " << fCpuTime << ",\n";
+	out << "  \"startup_time_s\": " << startupTime << ",\n";
+	out << "  \"peak_rss_mb\": " << MB(MemoryReport::GetPeakResidentSize()) << ",\n";
+	out << "  \"rss_mb\": " << MB(MemoryReport::GetResidentSize()) << ",\n";
+	out << "  \"startup_rss_mb\": " << MB(startupRSS) << ",\n";
+	out << "  \"shared_data_mb\": " << MB(SharedDataBytes()) << ",\n";
+	out << "  \"worker_memory_estimate_mb\": " << MB(WorkerEstimate(aRun->GetWorkerSummaries().size())) << ",\n";
+	out << "  \"events_per_s\": " << Rate(nEvents, fWallTime) << ",\n";
+	out << "  \"steps\": " << aRun->GetTotalSteps() << ",\n";
+	out << "  \"steps_per_s\": " << Rate(aRun->GetTotalSteps(), fWallTime) << ",\n";
+	out << "  \"steps_by_particle\": {";
+	for(G4int i=0;i<Run::kNCategories;i++)
+	{
+		out << (i ? ", " : "") << "\"" << Run::GetCategoryName(i) << "\": " << aRun->GetSteps(i);
+	}
+	out << "},\n";
+	out << "  \"optical_photons_created\": " << aRun->GetPhotonsCreated() << ",\n";
+	out << "  \"optical_photons_created_per_s\": " << Rate(aRun->GetPhotonsCreated(), fWallTime) << ",\n";
+	out << "  \"optical_photons_culled\": " << aRun->GetPhotonsCulled() << ",\n";
+	out << "  \"optical_filter_correction\": " << aRun->GetFilterCorrection() << ",\n";
+	out << "  \"optical_photons_mispredicted\": " << aRun->GetPhotonsMispredicted() << ",\n";
+	out << "  \"optical_photons_detected\": " << aRun->GetPhotonsDetected() << ",\n";
+	out << "  \"async_output_mb\": " << AsyncWriter::Instance()->GetBytesWritten()/1048576. << ",\n";
+	out << "  \"async_stored_mb\": " << AsyncWriter::Instance()->GetBytesStored()/1048576. << ",\n";
+	out << "  \"async_writer_wait_s\": " << AsyncWriter::Instance()->GetProducerWait() << ",\n";
+	out << "  \"workers\": [";
+
+	const std::vector<Run::WorkerSummary>& workers = aRun->GetWorkerSummaries();
+	for(size_t i=0;i<workers.size();i++)
+	{
+		const Run::WorkerSummary& w = workers[i];
+		out << (i ? "," : "") << "\n    {\"thread\": " << w.threadId
+				<< ", \"events\": " << w.nEvents
+				<< ", \"wall_time_s\": " << w.wallTime
+				<< ", \"cpu_time_s\": " << w.cpuTime
+				<< ", \"steps\": " << w.nSteps
+				<< ", \"optical_photons_created\": " << w.nPhotonsCreated
+				<< ", \"optical_photons_detected\": " << w.nPhotonsDetected
+				<< ", \"memory_mb\": {";
+		for(G4int c=0;c<MemoryReport::kNComponents;c++)
+			out << (c ? ", " : "") << "\"" << MemoryReport::GetComponentName(c) << "\": " << MB(w.memory[c]);
+		out << "}}";
+	}
+	out << (workers.empty() ? "]\n" : "\n  ]\n");
+	out << "}\n";
+}
+
+void RunAction::WriteContainer(const Run* aRun, G4int nJobEvents) const
+{
+	SimulationConfig* config = SimulationConfig::Instance();
+	OutputManager* output = OutputManager::Instance();
+	const G4String fileName = output->Path(config->GetContainerFile());
+
+	RunFileWriter writer;
+	std::string error;
+	if(!writer.Open(fileName, true, error))
+	{
+		G4Exception("RunAction::WriteContainer", "Out004", JustWarning, error.c_str());
+		return;
+	}
+	writer.SetCompression(config->GetCompression(), config->GetCompressionBlockSize());
+
+	// Every run written to the same container gets the next free group
+	G4int index = 0;
+	for(G4bool used = true; used; )
+	{
+		std::ostringstream prefix;
+		prefix << "run" << index << "/";
+		used = false;
+		for(size_t k=0;k<writer.GetEntries().size() && !used;k++)
+			used = writer.GetEntries()[k].name.compare(0, prefix.str().size(), prefix.str()) == 0;
+		if(used) index++;
+	}
+	std::ostringstream group;
+	group << "run" << index << "/";
+
+	std::ostringstream runId, seed, events, resumed, pixels;
+	runId << output->GetRunID();
+	seed << output->GetSeed();
+	events << aRun->GetNumberOfEvent();
+	resumed << aRun->GetNumberOfEvent() - nJobEvents;
+	pixels << config->GetNumberOfPixels();
+	RunFileAttributes attributes;
+	attributes.push_back(std::make_pair("run_id", runId.str()));
+	attributes.push_back(std::make_pair("job_id", std::string(output->GetJobId())));
+	attributes.push_back(std::make_pair("host", std::string(output->GetHost())));
+	attributes.push_back(std::make_pair("start_time", std::string(output->GetStartTime())));
+	attributes.push_back(std::make_pair("seed", seed.str()));
+	attributes.push_back(std::make_pair("events", events.str()));
+	attributes.push_back(std::make_pair("resumed_events", resumed.str()));
+	attributes.push_back(std::make_pair("readout", config->GetReadout() == kFaceReadout ? "face" : "volume"));
+	attributes.push_back(std::make_pair("pixels", pixels.str()));
+	attributes.push_back(std::make_pair("pixel_layout", std::string(config->GetPixelLayoutName())));
+	std::ostringstream statistics;
+	FormatStatistics(aRun, statistics);
+	writer.AddText(group.str() + "metadata", statistics.str(), attributes);
+
+	const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+			G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+	if(detector)
+	{
+		std::ostringstream size, centre;
+		size << detector->GetScintSizeX()/mm << " " << detector->GetScintSizeY()/mm << " " << detector->GetScintSizeZ()/mm;
+		const G4ThreeVector c = detector->GetScintCentre();
+		centre << c.x()/mm << " " << c.y()/mm << " " << c.z()/mm;
+		RunFileAttributes geometry;
+		geometry.push_back(std::make_pair("scint_size_mm", size.str()));
+		geometry.push_back(std::make_pair("scint_centre_mm", centre.str()));
+		writer.AddText(group.str() + "geometry", std::string(detector->GetPhantomDescription()), geometry);
+	}
+
+	// Name, density and a hash of the full printout (elements, optical
+	// properties) of every material, to compare the setup of two runs
+	std::ostringstream materials;
+	const G4MaterialTable* table = G4Material::GetMaterialTable();
+	for(size_t k=0;k<table->size();k++)
+	{
+		std::ostringstream dump;
+		dump << *(*table)[k];
+		const std::string text = dump.str();
+		uint64_t hash = 14695981039346656037ULL;
+		for(size_t c=0;c<text.size();c++) hash = (hash ^ (unsigned char)text[c])*1099511628211ULL;
+		materials << (*table)[k]->GetName() << "\t" << (*table)[k]->GetDensity()/(g/cm3) << "\t"
+				<< std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << std::setfill(' ') << "\n";
+	}
+	RunFileAttributes materialAttributes;
+	materialAttributes.push_back(std::make_pair("columns", "name density_g_cm3 fnv1a64"));
+	writer.AddText(group.str() + "materials", materials.str(), materialAttributes);
+
+	// Run seed, then the state seeds of the master engine
+	std::vector<int64_t> seeds(1, output->GetSeed());
+	const long* engineSeeds = G4Random::getTheSeeds();
+	for(G4int k=0;engineSeeds && engineSeeds[k];k++) seeds.push_back(engineSeeds[k]);
+	writer.AddArray(group.str() + "seeds", &seeds[0], std::vector<uint64_t>(1, seeds.size()));
+
+	aRun->WriteContainer(writer, group.str());
+
+	if(!writer.Close(error))
+	{
+		G4Exception("RunAction::WriteContainer", "Out004", JustWarning, error.c_str());
+		return;
+	}
+	output->Register(fileName, "run container");
+}
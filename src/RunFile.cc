@@ -0,0 +1,410 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "RunFile.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace
+{
+	// Directory lines cannot hold line breaks, names no white space
+	std::string Clean(const std::string& value, bool name)
+	{
+		std::string out = value;
+		for(size_t k=0;k<out.size();k++)
+		{
+			if(out[k] == '\n' || out[k] == '\r' || (name && (out[k] == ' ' || out[k] == '\t'))) out[k] = '_';
+		}
+		return out;
+	}
+
+	bool ParseDirectory(const std::string& text, std::vector<RunFileEntry>& entries)
+	{
+		std::istringstream in(text);
+		std::string line;
+		while(std::getline(in, line))
+		{
+			std::istringstream ss(line);
+			std::string tag;
+			ss >> tag;
+			if(tag == "entry")
+			{
+				RunFileEntry entry;
+				std::string type;
+				if(!(ss >> entry.name >> type >> entry.offset >> entry.size)) return false;
+				if(type == "text") entry.type = kRunFileText;
+				else if(type == "float64") entry.type = kRunFileFloat64;
+				else if(type == "int64") entry.type = kRunFileInt64;
+				else return false;
+				uint64_t dim;
+				while(ss >> dim) entry.shape.push_back(dim);
+				entries.push_back(entry);
+			}
+			else if(tag == "attr")
+			{
+				std::string key, value;
+				if(entries.empty() || !(ss >> key)) return false;
+				std::getline(ss, value);
+				if(!value.empty() && value[0] == ' ') value.erase(0, 1);
+				entries.back().attributes.push_back(std::make_pair(key, value));
+			}
+			else if(!tag.empty()) return false;
+		}
+		return true;
+	}
+
+	// Last complete directory: the footer at the end, or the one before an
+	// interrupted append
+	bool FindDirectory(FILE* file, uint64_t fileSize, RunFileFooter& footer)
+	{
+		const size_t window = 1 << 20;
+		std::vector<char> buffer(window + sizeof(footer));
+		uint64_t end = fileSize;
+		while(end >= sizeof(RunFileHeader) + sizeof(footer))
+		{
+			const uint64_t begin = std::max(uint64_t(sizeof(RunFileHeader)), end >= window ? end - window : 0);
+			const size_t n = end - begin;
+			if(fseeko(file, off_t(begin), SEEK_SET) != 0 || fread(&buffer[0], 1, n, file) != n) return false;
+			for(size_t k=n-sizeof(footer)+1;k-->0;)
+			{
+				if(memcmp(&buffer[k] + offsetof(RunFileFooter, magic), RUNFILE_DIR_MAGIC, sizeof(RUNFILE_DIR_MAGIC)) != 0)
+					continue;
+				memcpy(&footer, &buffer[k], sizeof(footer));
+				if(footer.directoryOffset + footer.directorySize == begin + k) return true;
+			}
+			if(begin == sizeof(RunFileHeader)) break;
+			// Overlap so a footer across the window edge is still found
+			end = begin + sizeof(footer) - 1;
+		}
+		return false;
+	}
+
+	bool ReadDirectory(const std::string& fileName, std::vector<RunFileEntry>& entries, uint64_t* endOfData,
+			std::string& error)
+	{
+		entries.clear();
+		FILE* file = fopen(fileName.c_str(), "rb");
+		struct stat st;
+		RunFileHeader header;
+		if(!file || fstat(fileno(file), &st) != 0 || fread(&header, sizeof(header), 1, file) != 1
+				|| strncmp(header.magic, RUNFILE_MAGIC, sizeof(header.magic)) != 0 || header.version != RUNFILE_VERSION)
+		{
+			if(file) fclose(file);
+			error = fileName + " is not a run container";
+			return false;
+		}
+
+		RunFileFooter footer;
+		std::string text;
+		bool ok = FindDirectory(file, st.st_size, footer);
+		if(ok)
+		{
+			text.resize(footer.directorySize);
+			ok = footer.directorySize == 0 || (fseeko(file, off_t(footer.directoryOffset), SEEK_SET) == 0
+					&& fread(&text[0], 1, text.size(), file) == text.size());
+		}
+		fclose(file);
+		if(!ok || !ParseDirectory(text, entries))
+		{
+			error = fileName + ": no readable directory";
+			return false;
+		}
+		if(endOfData) *endOfData = footer.directoryOffset + footer.directorySize + sizeof(footer);
+		return true;
+	}
+}
+
+uint64_t RunFileEntry::GetNumberOfElements() const
+{
+	uint64_t n = 1;
+	for(size_t k=0;k<shape.size();k++) n *= shape[k];
+	return shape.empty() ? 0 : n;
+}
+
+uint64_t RunFileEntry::GetRowLength() const
+{
+	uint64_t n = 1;
+	for(size_t k=1;k<shape.size();k++) n *= shape[k];
+	return n;
+}
+
+std::string RunFileEntry::GetAttribute(const std::string& key) const
+{
+	for(size_t k=attributes.size();k-->0;)
+	{
+		if(attributes[k].first == key) return attributes[k].second;
+	}
+	return "";
+}
+
+const char* GetRunFileTypeName(RunFileType type)
+{
+	switch(type)
+	{
+	case kRunFileText: return "text";
+	case kRunFileFloat64: return "float64";
+	case kRunFileInt64: return "int64";
+	}
+	return "unknown";
+}
+
+RunFileWriter::RunFileWriter()
+:fFile(0), fOffset(0), fCodec(kCodecStored), fBlockSize(1 << 20)
+{}
+
+RunFileWriter::~RunFileWriter()
+{
+	if(fFile) fclose(fFile);
+}
+
+bool RunFileWriter::Open(const std::string& fileName, bool append, std::string& error)
+{
+	if(fFile) fclose(fFile);
+	fEntries.clear();
+
+	struct stat st;
+	if(append && stat(fileName.c_str(), &st) == 0)
+	{
+		// Old data and directory stay, new entries follow the last directory
+		uint64_t end = 0;
+		if(!ReadDirectory(fileName, fEntries, &end, error)) return false;
+		fFile = fopen(fileName.c_str(), "r+b");
+		if(!fFile || fseeko(fFile, off_t(end), SEEK_SET) != 0)
+		{
+			error = "cannot append to " + fileName;
+			return false;
+		}
+		fOffset = end;
+		return true;
+	}
+
+	fFile = fopen(fileName.c_str(), "wb");
+	RunFileHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, RUNFILE_MAGIC, sizeof(header.magic));
+	header.version = RUNFILE_VERSION;
+	if(!fFile || fwrite(&header, sizeof(header), 1, fFile) != 1)
+	{
+		error = "cannot write " + fileName;
+		return false;
+	}
+	fOffset = sizeof(header);
+	return true;
+}
+
+bool RunFileWriter::Add(const std::string& name, RunFileType type, const char* data, size_t n,
+		const std::vector<uint64_t>& shape, const RunFileAttributes& attributes)
+{
+	if(!fFile) return false;
+
+	// Blocks hold whole rows where possible, so row reads touch few blocks
+	size_t blockSize = fBlockSize;
+	if(shape.size() > 1)
+	{
+		RunFileEntry probe;
+		probe.shape = shape;
+		const size_t rowBytes = probe.GetRowLength()*8;
+		if(rowBytes > 0 && rowBytes < blockSize) blockSize -= blockSize%rowBytes;
+	}
+	BlockWriter writer(fCodec, blockSize);
+	std::string packed;
+	writer.Write(data, n, packed);
+	writer.Finish(packed);
+	if(fwrite(packed.data(), 1, packed.size(), fFile) != packed.size()) return false;
+
+	RunFileEntry entry;
+	entry.name = Clean(name, true);
+	entry.type = type;
+	entry.shape = shape;
+	entry.offset = fOffset;
+	entry.size = packed.size();
+	for(size_t k=0;k<attributes.size();k++)
+		entry.attributes.push_back(std::make_pair(Clean(attributes[k].first, true), Clean(attributes[k].second, false)));
+	fEntries.push_back(entry);
+	fOffset += packed.size();
+	return true;
+}
+
+bool RunFileWriter::AddText(const std::string& name, const std::string& text, const RunFileAttributes& attributes)
+{
+	return Add(name, kRunFileText, text.data(), text.size(), std::vector<uint64_t>(), attributes);
+}
+
+bool RunFileWriter::AddArray(const std::string& name, const double* data, const std::vector<uint64_t>& shape,
+		const RunFileAttributes& attributes)
+{
+	RunFileEntry probe;
+	probe.shape = shape;
+	return Add(name, kRunFileFloat64, reinterpret_cast<const char*>(data),
+			probe.GetNumberOfElements()*sizeof(double), shape, attributes);
+}
+
+bool RunFileWriter::AddArray(const std::string& name, const int64_t* data, const std::vector<uint64_t>& shape,
+		const RunFileAttributes& attributes)
+{
+	RunFileEntry probe;
+	probe.shape = shape;
+	return Add(name, kRunFileInt64, reinterpret_cast<const char*>(data),
+			probe.GetNumberOfElements()*sizeof(int64_t), shape, attributes);
+}
+
+bool RunFileWriter::Close(std::string& error)
+{
+	if(!fFile) return false;
+
+	std::ostringstream directory;
+	for(size_t k=0;k<fEntries.size();k++)
+	{
+		const RunFileEntry& entry = fEntries[k];
+		directory << "entry " << entry.name << " " << GetRunFileTypeName(entry.type) << " "
+				<< entry.offset << " " << entry.size;
+		for(size_t d=0;d<entry.shape.size();d++) directory << " " << entry.shape[d];
+		directory << "\n";
+		for(size_t a=0;a<entry.attributes.size();a++)
+			directory << "attr " << entry.attributes[a].first << " " << entry.attributes[a].second << "\n";
+	}
+	const std::string text = directory.str();
+
+	RunFileFooter footer;
+	memset(&footer, 0, sizeof(footer));
+	footer.directoryOffset = fOffset;
+	footer.directorySize = text.size();
+	strncpy(footer.magic, RUNFILE_DIR_MAGIC, sizeof(footer.magic));
+	bool ok = fwrite(text.data(), 1, text.size(), fFile) == text.size()
+			&& fwrite(&footer, sizeof(footer), 1, fFile) == 1;
+	ok = fclose(fFile) == 0 && ok;
+	fFile = 0;
+	if(!ok) error = "cannot write the container directory";
+	return ok;
+}
+
+bool RunFileReader::Open(const std::string& fileName, std::string& error)
+{
+	fFileName = fileName;
+	return ReadDirectory(fileName, fEntries, 0, error);
+}
+
+bool RunFileReader::IsRunFile(const std::string& fileName)
+{
+	char magic[8] = {0};
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if(!file) return false;
+	const bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+			&& strncmp(magic, RUNFILE_MAGIC, sizeof(magic)) == 0;
+	fclose(file);
+	return ok;
+}
+
+const RunFileEntry* RunFileReader::Find(const std::string& name) const
+{
+	for(size_t k=fEntries.size();k-->0;)
+	{
+		if(fEntries[k].name == name) return &fEntries[k];
+	}
+	return 0;
+}
+
+bool RunFileReader::ReadRaw(const RunFileEntry& entry, std::string& raw, std::string& error, int nThreads) const
+{
+	BlockReader reader;
+	return reader.Open(fFileName, entry.offset, entry.size, error) && reader.ReadAll(raw, error, nThreads);
+}
+
+bool RunFileReader::ReadText(const RunFileEntry& entry, std::string& text, std::string& error) const
+{
+	return ReadRaw(entry, text, error, 1);
+}
+
+bool RunFileReader::ReadArray(const RunFileEntry& entry, std::vector<double>& data, std::string& error,
+		int nThreads) const
+{
+	std::string raw;
+	if(entry.type == kRunFileText || !ReadRaw(entry, raw, error, nThreads)) return false;
+	const size_t n = raw.size()/8;
+	data.resize(n);
+	if(entry.type == kRunFileFloat64)
+	{
+		if(n > 0) memcpy(&data[0], raw.data(), n*8);
+		return true;
+	}
+	for(size_t k=0;k<n;k++)
+	{
+		int64_t v;
+		memcpy(&v, raw.data() + 8*k, 8);
+		data[k] = double(v);
+	}
+	return true;
+}
+
+bool RunFileReader::ReadArray(const RunFileEntry& entry, std::vector<int64_t>& data, std::string& error,
+		int nThreads) const
+{
+	std::string raw;
+	if(entry.type != kRunFileInt64)
+	{
+		error = entry.name + " is not an int64 array";
+		return false;
+	}
+	if(!ReadRaw(entry, raw, error, nThreads)) return false;
+	data.resize(raw.size()/8);
+	if(!data.empty()) memcpy(&data[0], raw.data(), data.size()*8);
+	return true;
+}
+
+bool RunFileReader::ReadRows(const RunFileEntry& entry, uint64_t first, uint64_t count,
+		std::vector<double>& data, std::string& error) const
+{
+	if(entry.type == kRunFileText || entry.shape.empty() || first + count > entry.shape[0])
+	{
+		error = entry.name + ": rows outside the array";
+		return false;
+	}
+	BlockReader reader;
+	const uint64_t rowLength = entry.GetRowLength();
+	std::vector<char> raw(count*rowLength*8);
+	if(!reader.Open(fFileName, entry.offset, entry.size, error)
+			|| (!raw.empty() && !reader.Read(first*rowLength*8, &raw[0], raw.size(), error))) return false;
+
+	data.resize(count*rowLength);
+	for(size_t k=0;k<data.size();k++)
+	{
+		if(entry.type == kRunFileFloat64) memcpy(&data[k], &raw[8*k], 8);
+		else
+		{
+			int64_t v;
+			memcpy(&v, &raw[8*k], 8);
+			data[k] = double(v);
+		}
+	}
+	return true;
+}
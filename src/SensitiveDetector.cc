@@ -28,9 +28,19 @@
 
 
 #include "SensitiveDetector.hh"
+#include "Run.hh"
+#include "SimulationConfig.hh"
+#include "StackingAction.hh"
+#include "SpectralResponse.hh"
+#include "MemoryReport.hh"
+#include "RunAction.hh"
 
 #include "G4SystemOfUnits.hh"
 #include "G4Threading.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4SDManager.hh"
+#include "G4EventManager.hh"
+#include "Randomize.hh"
 
 // For Filename
 #include <string.h>
@@ -40,64 +50,45 @@
 #include <time.h>
 #include <stdio.h>
 #include <string>
+#include <algorithm>
 
 using namespace std;
 
 SensitiveDetector::SensitiveDetector(G4String name)
-:G4VSensitiveDetector(name)
+:G4VSensitiveDetector(name), fRun(0), fHitsCollection(0), fHCID(-1)
 {
-
-	//// Time
-	time_t now;
-	struct tm t;
-
-
-	time(&now);
-	t = *localtime(&now);
-	G4int year = t.tm_year + 1900;
-	G4int month = t.tm_mon +1;
-	G4int day = t.tm_mday;
-	G4int hour = t.tm_hour;
-	G4int min = t.tm_min;
-	G4int sec = t.tm_sec;
-
-	// File name
-	stringstream ss_filename;
-	ss_filename<< year << month << day << "_" << hour << "_" << min <<"_" <<sec <<"_ThreadNum_" << G4Threading::G4GetThreadId();
-	filenameForSave = ss_filename.str();
-
-	ofs.open(filenameForSave.c_str());
+	collectionName.insert("PixelHits");
 
 	Counter = 1;
-	ofs_hist.open("ScintHistogram.out");
-
-	//Initialization.
-	for(G4int i=0;i<REPLICA_NUM;i++){
-		for(G4int j=0;j<REPLICA_NUM;j++){
-			DEMatrix[i][j] = 0;
-		}
-	}
+	fNPixel = SimulationConfig::Instance()->GetNumberOfPixels();
+	fFaceReadout = (SimulationConfig::Instance()->GetReadout() == kFaceReadout);
+	fFilterValidate = false;
+	fResponseMode = kResponseOff;
+	fReadoutFaceZ = 0.;
+	fComputedGrid = false;
+	fGridX = fGridY = 0.;
+	fInvPitchX = fInvPitchY = 1.;
+	fEventWriter = 0;
+	fHitSlots.assign(256, std::make_pair(-1, -1));
+	MemoryReport::SetThreadUsage(MemoryReport::kHitIndex, fHitSlots.capacity()*sizeof(fHitSlots[0]));
 
 }
 
 SensitiveDetector::~SensitiveDetector()
 {
-
-	for(G4int i=0;i<REPLICA_NUM;i++){
-		for(G4int j=0;j<REPLICA_NUM;j++){
-			ofs<< i << "\t"<<j<<"\t"<<DEMatrix[i][j]<<G4endl;
-		}
-		ofs<<G4endl;
-	}
-
-
-	ofs.close();
-	ofs_hist.close();
 }
 
-void SensitiveDetector::Initialize(G4HCofThisEvent*)
+void SensitiveDetector::Initialize(G4HCofThisEvent* hce)
 {
-
+	fRun = static_cast<Run*>(G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+	fFilterValidate = fFaceReadout && SimulationConfig::Instance()->GetOpticalFilter() == kFilterValidate;
+	fResponseMode = SimulationConfig::Instance()->GetResponseMode();
+	fEventWriter = static_cast<const RunAction*>(G4RunManager::GetRunManager()->GetUserRunAction())->GetEventWriter();
+	fEventDeposits.clear();
+
+	fHitsCollection = new PixelHitsCollection(SensitiveDetectorName, collectionName[0]);
+	if(fHCID < 0) fHCID = G4SDManager::GetSDMpointer()->GetCollectionID(fHitsCollection);
+	hce->AddHitsCollection(fHCID, fHitsCollection);
 }
 
 G4bool SensitiveDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
@@ -105,14 +96,60 @@ G4bool SensitiveDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
 	G4String ParName = aStep->GetTrack()->GetParticleDefinition()->GetParticleName();
 
 	if(ParName == "opticalphoton"){
-		G4int RepZNo = aStep->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(0);
-		G4int RepXNo = aStep->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(1);
+		G4int RepZNo, RepXNo;
+		if(fComputedGrid)
+		{
+			// Face readout scores where the photon leaves the panel
+			const G4ThreeVector& pos = (fFaceReadout ? aStep->GetPostStepPoint() : aStep->GetPreStepPoint())->GetPosition();
+			RepZNo = std::min(std::max(G4int((pos.y() - fGridY)*fInvPitchY), 0), fNPixel-1);
+			RepXNo = std::min(std::max(G4int((pos.x() - fGridX)*fInvPitchX), 0), fNPixel-1);
+		}
+		else
+		{
+			RepZNo = aStep->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(0);
+			RepXNo = aStep->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(1);
+		}
 
 		//optical photon doesn't have Deposit Energy
 		G4double dE = aStep->GetPreStepPoint()->GetKineticEnergy();
-		ofs_hist<<dE<<G4endl;
+		G4double time = aStep->GetPreStepPoint()->GetGlobalTime();
+
+		if(fFaceReadout)
+		{
+			// Only the step ending on the readout face counts, once per photon
+			const G4StepPoint* post = aStep->GetPostStepPoint();
+			if(post->GetStepStatus() != fGeomBoundary
+					|| post->GetPosition().z() > fReadoutFaceZ + 1e-6*mm) return false;
+			time = post->GetGlobalTime();
+			aStep->GetTrack()->SetTrackStatus(fStopAndKill);
+
+			// Validation of the optical filter: this photon was predicted lost
+			if(fFilterValidate)
+			{
+				const StackingAction* stacking = static_cast<const StackingAction*>(
+						G4EventManager::GetEventManager()->GetUserStackingAction());
+				if(stacking->GetOpticalFilter().IsPredictedLost(aStep->GetTrack()->GetTrackID()))
+					fRun->AddPhotonMispredicted();
+			}
+		}
 
-		DEMatrix[RepZNo][RepXNo] += Counter;
+		ScorePhoton(RepZNo, RepXNo, dE, time, Counter);
+	}
+	else if(fEventWriter && aStep->GetTotalEnergyDeposit() > 0.)
+	{
+		G4int iy, ix;
+		if(fComputedGrid)
+		{
+			const G4ThreeVector pos = 0.5*(aStep->GetPreStepPoint()->GetPosition() + aStep->GetPostStepPoint()->GetPosition());
+			iy = std::min(std::max(G4int((pos.y() - fGridY)*fInvPitchY), 0), fNPixel-1);
+			ix = std::min(std::max(G4int((pos.x() - fGridX)*fInvPitchX), 0), fNPixel-1);
+		}
+		else
+		{
+			iy = aStep->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(0);
+			ix = aStep->GetPreStepPoint()->GetTouchable()->GetReplicaNumber(1);
+		}
+		fEventDeposits.push_back(std::make_pair(iy*fNPixel + ix, G4float(aStep->GetTotalEnergyDeposit()/MeV)));
 	}
 	//  G4cout<< "Sensitive Detector is Activated"<<G4endl;
 	//  G4cout<<"ParName is "<< ParName<<G4endl;
@@ -120,7 +157,88 @@ G4bool SensitiveDetector::ProcessHits(G4Step* aStep, G4TouchableHistory*)
 	return true;
 }
 
+void SensitiveDetector::ScorePhoton(G4int iy, G4int ix, G4double energy, G4double time, G4double weight)
+{
+	// Photodiode response, looked up on the table built for this run
+	if(fResponseMode == kResponseWeight)
+		weight *= SpectralResponse::Instance()->Value(energy);
+	else if(fResponseMode == kResponseAccept
+			&& G4UniformRand() >= SpectralResponse::Instance()->Value(energy)) return;
+
+	fRun->AddDetectedPhoton(iy, ix, energy, time, weight);
+
+	// One hit per pixel and event: only the first photon allocates
+	G4int pixel = iy*fNPixel + ix;
+	size_t slot = FindHitSlot(pixel);
+	if(fHitSlots[slot].first < 0)
+	{
+		// At most half full, so probes stay short; grows by rehashing the hits
+		if(2*(fUsedHitSlots.size() + 1) > fHitSlots.size())
+		{
+			fHitSlots.assign(2*fHitSlots.size(), std::make_pair(-1, -1));
+			fUsedHitSlots.clear();
+			for(size_t i=0;i<fHitsCollection->entries();i++)
+			{
+				const size_t k = FindHitSlot((*fHitsCollection)[i]->GetPixel());
+				fHitSlots[k] = std::make_pair((*fHitsCollection)[i]->GetPixel(), G4int(i));
+				fUsedHitSlots.push_back(k);
+			}
+			MemoryReport::SetThreadUsage(MemoryReport::kHitIndex,
+					fHitSlots.capacity()*sizeof(fHitSlots[0]) + fUsedHitSlots.capacity()*sizeof(size_t));
+			slot = FindHitSlot(pixel);
+		}
+		fHitSlots[slot] = std::make_pair(pixel, G4int(fHitsCollection->insert(new PixelHit(pixel)) - 1));
+		fUsedHitSlots.push_back(slot);
+	}
+	(*fHitsCollection)[fHitSlots[slot].second]->AddPhoton(time, energy, weight);
+}
+
+size_t SensitiveDetector::FindHitSlot(G4int pixel) const
+{
+	// Slot of the pixel, or the free slot where it goes
+	const size_t mask = fHitSlots.size() - 1;
+	size_t k = (size_t(pixel)*2654435761u) & mask;
+	while(fHitSlots[k].first >= 0 && fHitSlots[k].first != pixel) k = (k + 1) & mask;
+	return k;
+}
+
+G4bool SensitiveDetector::AddAnalyticPhoton(const G4Track* track)
+{
+	if(!fTransport.IsInitialized()) fTransport.Initialize(fNPixel);
+	return fTransport.Add(track->GetPosition(), track->GetMomentumDirection(),
+			track->GetKineticEnergy(), track->GetGlobalTime());
+}
+
 void SensitiveDetector::EndOfEvent(G4HCofThisEvent*)
 {
+	// Photons of the analytic transport, before the hit index is reset
+	if(fTransport.GetSize() > 0)
+	{
+		fTransport.Propagate();
+		for(size_t i=0;i<fTransport.GetSize();i++)
+		{
+			if(fTransport.GetWeight(i) > 0.)
+				ScorePhoton(fTransport.GetPixelY(i), fTransport.GetPixelX(i), fTransport.GetEnergy(i),
+						fTransport.GetArrivalTime(i), Counter*fTransport.GetWeight(i));
+		}
+		fTransport.Clear();
+	}
+
+	if(fEventWriter)
+	{
+		fEventPhotons.clear();
+		for(size_t i=0;i<fHitsCollection->entries();i++)
+			fEventPhotons.push_back(std::make_pair((*fHitsCollection)[i]->GetPixel(), G4float((*fHitsCollection)[i]->GetWeight())));
+		fEventWriter->Write(G4EventManager::GetEventManager()->GetConstCurrentEvent(), fEventDeposits, fEventPhotons);
+		fEventDeposits.clear();
+		MemoryReport::SetThreadUsage(MemoryReport::kEventBuffer, fEventWriter->GetMemoryBytes()
+				+ (fEventDeposits.capacity() + fEventPhotons.capacity())*sizeof(fEventPhotons[0]));
+	}
+
+	// Only the slots of the fired pixels need resetting
+	for(size_t i=0;i<fUsedHitSlots.size();i++) fHitSlots[fUsedHitSlots[i]] = std::make_pair(-1, -1);
+	fUsedHitSlots.clear();
 
+	MemoryReport::SetThreadUsage(MemoryReport::kOpticalBatch, fTransport.GetMemoryBytes());
+	if(PixelHitAllocator) MemoryReport::SetThreadUsage(MemoryReport::kHits, PixelHitAllocator->GetAllocatedSize());
 }
@@ -0,0 +1,120 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "SimulationConfig.hh"
+#include "SimulationMessenger.hh"
+
+SimulationConfig* SimulationConfig::fInstance = 0;
+
+SimulationConfig* SimulationConfig::Instance()
+{
+	// First call happens on the master in main(), before any worker exists
+	if(!fInstance) fInstance = new SimulationConfig();
+	return fInstance;
+}
+
+SimulationConfig::SimulationConfig()
+{
+	fNPixel = REPLICA_NUM;
+	fReadout = kVolumeReadout;
+	fPixelLayout = kReplicaLayout;
+	fSmartless = 2.;
+	fPhantomFile = "";
+	fOpticalDefer = false;
+	fOpticalTransport = kGeant4Transport;
+	fOpticalFilter = kFilterOff;
+	fOpticalFilterThreshold = 0.;
+	fOpticalFilterCorrection = true;
+
+	fResponseMode = kResponseOff;
+	fResponseFile = "";
+	fResponseWavelength = true;
+
+	// Default plane: entrance face of the scintillator (z = 0)
+	fPhspEnabled = false;
+	fPhspPlaneZ = 0.0*mm;
+	fPhspFile = "PhaseSpace.phsp";
+	fPhspBufferSize = 65536;
+	fPhspInput = "";
+
+	fEventOutput = false;
+	fEventFile = "Events.evt";
+	fEventEncoding = kEncodingAuto;
+	fEventBufferSize = 4*1024*1024;
+
+	fOutputDir = "runs";
+	fMapFile = "DE.out";
+	fSpectrumFile = "Spectrum.out";
+	fMomentsFile = "";
+	fContainerFile = "RunData.scr";
+	fBinaryOutput = false;
+	fStatsFile = "RunStatistics.json";
+	fAsyncOutput = true;
+	fAsyncQueueSize = 256.;
+	fCompression = kCodecStored;
+	fCompressionBlockSize = 1024*1024;
+
+	fCheckpointEvents = 0;
+	fCheckpointInterval = 0.;
+	fCheckpointDir = "checkpoint";
+	fCheckpointGeneration = 0;
+
+	fMonitorSocket = "";
+	fMonitorMapSize = 32;
+	fMonitorMapPeriod = 100;
+
+	fFramePeriod = 0.;
+	fNFrames = 100;
+	fTimeMapFile = "TimeMap.out";
+
+	fProfilerEnabled = false;
+	fProfilerSamplePeriod = 100;
+	fProfilerMaxRows = 30;
+
+	fStage = kFullStage;
+	fCacheDir = "phsp_cache";
+	fSourceMacro = "";
+
+	fMessenger = new SimulationMessenger(this);
+}
+
+SimulationConfig::~SimulationConfig()
+{
+	delete fMessenger;
+}
+
+const char* SimulationConfig::GetPixelLayoutName() const
+{
+	switch(fPixelLayout)
+	{
+	case kNestedLayout: return "nested";
+	case kSingleLayout: return "single";
+	default: return "replica";
+	}
+}
@@ -0,0 +1,802 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "SimulationMessenger.hh"
+#include "SimulationConfig.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UImanager.hh"
+#include "G4RunManager.hh"
+#include "G4StateManager.hh"
+
+#include "DetectorConstruction.hh"
+#include "PhaseSpaceRecord.hh"
+#include "Checkpoint.hh"
+#include "BlockFile.hh"
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <iomanip>
+#include <vector>
+#include <sys/stat.h>
+
+SimulationMessenger::SimulationMessenger(SimulationConfig* config)
+:G4UImessenger(), fConfig(config)
+{
+	fScintDir = new G4UIdirectory("/scint/", false);
+	fScintDir->SetGuidance("Scintillator_Simple run options");
+
+	// Detector
+	fDetDir = new G4UIdirectory("/scint/det/", false);
+	fDetDir->SetGuidance("Scintillator panel options (before /run/initialize)");
+
+	fPixelsCmd = new G4UIcmdWithAnInteger("/scint/det/pixels", this);
+	fPixelsCmd->SetGuidance("Number of pixels per side of the scoring grid");
+	fPixelsCmd->SetParameterName("n", false);
+	fPixelsCmd->SetRange("n>0");
+	fPixelsCmd->AvailableForStates(G4State_PreInit);
+	fPixelsCmd->SetToBeBroadcasted(false);
+
+	fReadoutCmd = new G4UIcmdWithAString("/scint/det/readout", this);
+	fReadoutCmd->SetGuidance("volume : every optical photon step in a pixel is scored (default)");
+	fReadoutCmd->SetGuidance("face   : photons are scored once where they reach the -z face;");
+	fReadoutCmd->SetGuidance("         the absorbing wrap is applied on all panel faces");
+	fReadoutCmd->SetParameterName("mode", false);
+	fReadoutCmd->SetCandidates("volume face");
+	fReadoutCmd->AvailableForStates(G4State_PreInit);
+	fReadoutCmd->SetToBeBroadcasted(false);
+
+	fLayoutCmd = new G4UIcmdWithAString("/scint/det/layout", this);
+	fLayoutCmd->SetGuidance("Pixel volumes of the panel");
+	fLayoutCmd->SetGuidance("replica : replicas along x, each with replicas along y (default)");
+	fLayoutCmd->SetGuidance("nested  : replicas along x, each with a nested parameterisation along y");
+	fLayoutCmd->SetGuidance("single  : no pixel volumes, the pixel is computed from the photon position");
+	fLayoutCmd->SetGuidance("          (equivalent with face readout; volume readout scores steps in the panel)");
+	fLayoutCmd->SetParameterName("layout", false);
+	fLayoutCmd->SetCandidates("replica nested single");
+	fLayoutCmd->AvailableForStates(G4State_PreInit);
+	fLayoutCmd->SetToBeBroadcasted(false);
+
+	fSmartlessCmd = new G4UIcmdWithADouble("/scint/det/smartless", this);
+	fSmartlessCmd->SetGuidance("Smart voxel quality of the nested pixels (average voxels per pixel, default 2)");
+	fSmartlessCmd->SetParameterName("smartless", false);
+	fSmartlessCmd->SetRange("smartless>0");
+	fSmartlessCmd->AvailableForStates(G4State_PreInit);
+	fSmartlessCmd->SetToBeBroadcasted(false);
+
+	fPhantomCmd = new G4UIcmdWithAString("/scint/det/phantom", this);
+	fPhantomCmd->SetGuidance("Voxelised phantom file (scint_phantom) replacing the water box, navigated");
+	fPhantomCmd->SetGuidance("with G4RegularNavigation; \"none\" restores the water box (default)");
+	fPhantomCmd->SetParameterName("file", false);
+	fPhantomCmd->AvailableForStates(G4State_PreInit);
+	fPhantomCmd->SetToBeBroadcasted(false);
+
+	// Optical photons
+	fOpticalDir = new G4UIdirectory("/scint/optical/", false);
+	fOpticalDir->SetGuidance("Optical photon handling");
+
+	fDeferCmd = new G4UIcmdWithABool("/scint/optical/defer", this);
+	fDeferCmd->SetGuidance("Track optical photons after the charged particles of the event (default false)");
+	fDeferCmd->SetParameterName("defer", false);
+	fDeferCmd->AvailableForStates(G4State_PreInit);
+	fDeferCmd->SetToBeBroadcasted(false);
+
+	fTransportCmd = new G4UIcmdWithAString("/scint/optical/transport", this);
+	fTransportCmd->SetGuidance("Optical photon transport in the panel (face readout only)");
+	fTransportCmd->SetGuidance("geant4   : full optical tracking (default)");
+	fTransportCmd->SetGuidance("analytic : the photons of each event are propagated to the readout face");
+	fTransportCmd->SetGuidance("           by the analytic slab model and scored with their survival weight");
+	fTransportCmd->SetParameterName("engine", false);
+	fTransportCmd->SetCandidates("geant4 analytic");
+	fTransportCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fTransportCmd->SetToBeBroadcasted(false);
+
+	fFilterCmd = new G4UIcmdWithAString("/scint/optical/filter", this);
+	fFilterCmd->SetGuidance("Analytic fate of optical photons at creation (face readout only)");
+	fFilterCmd->SetGuidance("off      : track every photon (default)");
+	fFilterCmd->SetGuidance("cull     : kill photons that cannot reach the readout face");
+	fFilterCmd->SetGuidance("validate : track every photon and count wrong predictions");
+	fFilterCmd->SetGuidance("           (Geant4 transport only, switched off with the analytic transport)");
+	fFilterCmd->SetParameterName("mode", false);
+	fFilterCmd->SetCandidates("off cull validate");
+	fFilterCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fFilterCmd->SetToBeBroadcasted(false);
+
+	fFilterThresholdCmd = new G4UIcmdWithADouble("/scint/optical/filterThreshold", this);
+	fFilterThresholdCmd->SetGuidance("Filter photons whose reach probability is at most this value");
+	fFilterThresholdCmd->SetGuidance("0 (default) filters certain losses only");
+	fFilterThresholdCmd->SetParameterName("p", false);
+	fFilterThresholdCmd->SetRange("p>=0 && p<1");
+	fFilterThresholdCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fFilterThresholdCmd->SetToBeBroadcasted(false);
+
+	fFilterCorrectionCmd = new G4UIcmdWithABool("/scint/optical/filterCorrection", this);
+	fFilterCorrectionCmd->SetGuidance("Scale the outputs for the signal of the filtered photons (default true)");
+	fFilterCorrectionCmd->SetParameterName("correct", false);
+	fFilterCorrectionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fFilterCorrectionCmd->SetToBeBroadcasted(false);
+
+	// Spectral response
+	fResponseDir = new G4UIdirectory("/scint/response/", false);
+	fResponseDir->SetGuidance("Photodiode spectral response applied when photons are scored");
+
+	fResponseModeCmd = new G4UIcmdWithAString("/scint/response/mode", this);
+	fResponseModeCmd->SetGuidance("off    : every photon counts fully (default)");
+	fResponseModeCmd->SetGuidance("weight : photon weight multiplied by the response");
+	fResponseModeCmd->SetGuidance("accept : photon kept with a probability equal to the response");
+	fResponseModeCmd->SetParameterName("mode", false);
+	fResponseModeCmd->SetCandidates("off weight accept");
+	fResponseModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fResponseModeCmd->SetToBeBroadcasted(false);
+
+	fResponseFileCmd = new G4UIcmdWithAString("/scint/response/file", this);
+	fResponseFileCmd->SetGuidance("Response table, one \"x QE\" pair per line, '#' comments");
+	fResponseFileCmd->SetParameterName("file", false);
+	fResponseFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fResponseFileCmd->SetToBeBroadcasted(false);
+
+	fResponseUnitCmd = new G4UIcmdWithAString("/scint/response/unit", this);
+	fResponseUnitCmd->SetGuidance("First column of the table: wavelength in nm (default) or energy in eV");
+	fResponseUnitCmd->SetParameterName("unit", false);
+	fResponseUnitCmd->SetCandidates("nm eV");
+	fResponseUnitCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fResponseUnitCmd->SetToBeBroadcasted(false);
+
+	// Phase-space scoring plane
+	fPhspDir = new G4UIdirectory("/scint/phsp/", false);
+	fPhspDir->SetGuidance("Phase-space recording plane upstream of the scintillator");
+
+	fPhspEnableCmd = new G4UIcmdWithABool("/scint/phsp/enable", this);
+	fPhspEnableCmd->SetGuidance("Record particles crossing the phase-space plane");
+	fPhspEnableCmd->SetParameterName("enable", false);
+	fPhspEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fPhspEnableCmd->SetToBeBroadcasted(false);
+
+	fPhspPlaneZCmd = new G4UIcmdWithADoubleAndUnit("/scint/phsp/planeZ", this);
+	fPhspPlaneZCmd->SetGuidance("z position of the plane (particles crossing towards -z are recorded)");
+	fPhspPlaneZCmd->SetParameterName("z", false);
+	fPhspPlaneZCmd->SetDefaultUnit("mm");
+	fPhspPlaneZCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fPhspPlaneZCmd->SetToBeBroadcasted(false);
+
+	fPhspFileCmd = new G4UIcmdWithAString("/scint/phsp/file", this);
+	fPhspFileCmd->SetGuidance("Output file of the merged phase space");
+	fPhspFileCmd->SetParameterName("file", false);
+	fPhspFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fPhspFileCmd->SetToBeBroadcasted(false);
+
+	fPhspBufferCmd = new G4UIcmdWithAnInteger("/scint/phsp/bufferSize", this);
+	fPhspBufferCmd->SetGuidance("Number of records buffered per thread before writing");
+	fPhspBufferCmd->SetParameterName("n", false);
+	fPhspBufferCmd->SetRange("n>0");
+	fPhspBufferCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fPhspBufferCmd->SetToBeBroadcasted(false);
+
+	fPhspInputCmd = new G4UIcmdWithAString("/scint/phsp/input", this);
+	fPhspInputCmd->SetGuidance("Generate primaries from a phase-space file instead of the GPS");
+	fPhspInputCmd->SetGuidance("\"none\" switches back to the GPS");
+	fPhspInputCmd->SetParameterName("file", false);
+	fPhspInputCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fPhspInputCmd->SetToBeBroadcasted(false);
+
+	// Per-event dataset
+	fEventDir = new G4UIdirectory("/scint/event/", false);
+	fEventDir->SetGuidance("Per-event primaries, deposited energy and photon maps (training datasets)");
+
+	fEventEnableCmd = new G4UIcmdWithABool("/scint/event/enable", this);
+	fEventEnableCmd->SetGuidance("Write one record per event to the event dataset");
+	fEventEnableCmd->SetParameterName("enable", false);
+	fEventEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fEventEnableCmd->SetToBeBroadcasted(false);
+
+	fEventFileCmd = new G4UIcmdWithAString("/scint/event/file", this);
+	fEventFileCmd->SetGuidance("Output file of the merged event dataset (default Events.evt)");
+	fEventFileCmd->SetParameterName("file", false);
+	fEventFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fEventFileCmd->SetToBeBroadcasted(false);
+
+	fEventEncodingCmd = new G4UIcmdWithAString("/scint/event/encoding", this);
+	fEventEncodingCmd->SetGuidance("auto   : sparse unless half of the pixels or more are set (default)");
+	fEventEncodingCmd->SetGuidance("dense  : every map as nPixel x nPixel values");
+	fEventEncodingCmd->SetGuidance("sparse : every map as pixel indices and values");
+	fEventEncodingCmd->SetParameterName("encoding", false);
+	fEventEncodingCmd->SetCandidates("auto dense sparse");
+	fEventEncodingCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fEventEncodingCmd->SetToBeBroadcasted(false);
+
+	fEventBufferCmd = new G4UIcmdWithADouble("/scint/event/bufferSize", this);
+	fEventBufferCmd->SetGuidance("Megabytes buffered per thread before writing (default 4)");
+	fEventBufferCmd->SetParameterName("MB", false);
+	fEventBufferCmd->SetRange("MB>0");
+	fEventBufferCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fEventBufferCmd->SetToBeBroadcasted(false);
+
+	// Outputs
+	fOutputDir = new G4UIdirectory("/scint/output/", false);
+	fOutputDir->SetGuidance("Merged end-of-run outputs");
+
+	fOutputDirCmd = new G4UIcmdWithAString("/scint/output/directory", this);
+	fOutputDirCmd->SetGuidance("Base of the unique run directories (default runs);");
+	fOutputDirCmd->SetGuidance("\"none\" writes the outputs to the current directory");
+	fOutputDirCmd->SetParameterName("dir", false);
+	fOutputDirCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fOutputDirCmd->SetToBeBroadcasted(false);
+
+	fMapFileCmd = new G4UIcmdWithAString("/scint/output/map", this);
+	fMapFileCmd->SetGuidance("Merged pixel map (i j value, as the per-thread files)");
+	fMapFileCmd->SetParameterName("file", false);
+	fMapFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fMapFileCmd->SetToBeBroadcasted(false);
+
+	fSpectrumFileCmd = new G4UIcmdWithAString("/scint/output/spectrum", this);
+	fSpectrumFileCmd->SetGuidance("Merged spectrum of the detected optical photons");
+	fSpectrumFileCmd->SetParameterName("file", false);
+	fSpectrumFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fSpectrumFileCmd->SetToBeBroadcasted(false);
+
+	fMomentsFileCmd = new G4UIcmdWithAString("/scint/output/moments", this);
+	fMomentsFileCmd->SetGuidance("Sums over events of the per-event signal and of its square for every pixel,");
+	fMomentsFileCmd->SetGuidance("row, column, spectrum bin and the total (input of scint_validate; default none)");
+	fMomentsFileCmd->SetParameterName("file", false);
+	fMomentsFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fMomentsFileCmd->SetToBeBroadcasted(false);
+
+	fContainerFileCmd = new G4UIcmdWithAString("/scint/output/container", this);
+	fContainerFileCmd->SetGuidance("Run container with maps, spectrum, time map, metadata, geometry, materials");
+	fContainerFileCmd->SetGuidance("and seeds (default RunData.scr, \"none\" to disable); runs are appended");
+	fContainerFileCmd->SetParameterName("file", false);
+	fContainerFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fContainerFileCmd->SetToBeBroadcasted(false);
+
+	fFormatCmd = new G4UIcmdWithAString("/scint/output/format", this);
+	fFormatCmd->SetGuidance("Format of the merged map and time map");
+	fFormatCmd->SetGuidance("text   : i j value lines (default)");
+	fFormatCmd->SetGuidance("binary : PixelMap file, dense or sparse as stored in the run");
+	fFormatCmd->SetParameterName("format", false);
+	fFormatCmd->SetCandidates("text binary");
+	fFormatCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fFormatCmd->SetToBeBroadcasted(false);
+
+	fTimeMapFileCmd = new G4UIcmdWithAString("/scint/output/timeMap", this);
+	fTimeMapFileCmd->SetGuidance("Merged time-resolved map (frame i j value, non-zero entries)");
+	fTimeMapFileCmd->SetParameterName("file", false);
+	fTimeMapFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fTimeMapFileCmd->SetToBeBroadcasted(false);
+
+	fAsyncCmd = new G4UIcmdWithABool("/scint/output/async", this);
+	fAsyncCmd->SetGuidance("Write maps, checkpoints and phase space on a background I/O thread (default true)");
+	fAsyncCmd->SetParameterName("async", false);
+	fAsyncCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fAsyncCmd->SetToBeBroadcasted(false);
+
+	fAsyncQueueCmd = new G4UIcmdWithADouble("/scint/output/asyncQueue", this);
+	fAsyncQueueCmd->SetGuidance("Buffers queued for the I/O thread [MB] before writers wait (default 256)");
+	fAsyncQueueCmd->SetParameterName("MB", false);
+	fAsyncQueueCmd->SetRange("MB>0");
+	fAsyncQueueCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fAsyncQueueCmd->SetToBeBroadcasted(false);
+
+	fCompressionCmd = new G4UIcmdWithAString("/scint/output/compression", this);
+	fCompressionCmd->SetGuidance("Block compression of maps, spectra, checkpoints and phase space");
+	fCompressionCmd->SetGuidance("none (default), builtin (LZ, always available), zlib or zstd (when found at build time,");
+	fCompressionCmd->SetGuidance("builtin otherwise); the tools and the phase-space source read both forms");
+	fCompressionCmd->SetParameterName("codec", false);
+	fCompressionCmd->SetCandidates("none builtin zlib zstd");
+	fCompressionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fCompressionCmd->SetToBeBroadcasted(false);
+
+	fCompressionBlockCmd = new G4UIcmdWithAnInteger("/scint/output/compressionBlock", this);
+	fCompressionBlockCmd->SetGuidance("Uncompressed size of the independently compressed blocks [kB] (default 1024)");
+	fCompressionBlockCmd->SetParameterName("kB", false);
+	fCompressionBlockCmd->SetRange("kB>=4 && kB<=1048576");
+	fCompressionBlockCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fCompressionBlockCmd->SetToBeBroadcasted(false);
+
+	fStatsFileCmd = new G4UIcmdWithAString("/scint/statsFile", this);
+	fStatsFileCmd->SetGuidance("JSON file of the end-of-run statistics (\"none\" to disable)");
+	fStatsFileCmd->SetParameterName("file", false);
+	fStatsFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fStatsFileCmd->SetToBeBroadcasted(false);
+
+	// Time-resolved scoring
+	fTimeDir = new G4UIdirectory("/scint/time/", false);
+	fTimeDir->SetGuidance("Pixel maps per readout frame of the photon arrival time");
+
+	fFramePeriodCmd = new G4UIcmdWithADoubleAndUnit("/scint/time/framePeriod", this);
+	fFramePeriodCmd->SetGuidance("Frame period of the time-resolved map (0 disables it)");
+	fFramePeriodCmd->SetGuidance("Frame k holds photons arriving in [k, k+1) periods after the primary");
+	fFramePeriodCmd->SetParameterName("period", false);
+	fFramePeriodCmd->SetRange("period>=0");
+	fFramePeriodCmd->SetDefaultUnit("ms");
+	fFramePeriodCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fFramePeriodCmd->SetToBeBroadcasted(false);
+
+	fFramesCmd = new G4UIcmdWithAnInteger("/scint/time/frames", this);
+	fFramesCmd->SetGuidance("Number of frames; later photons are only counted as overflow");
+	fFramesCmd->SetParameterName("n", false);
+	fFramesCmd->SetRange("n>0");
+	fFramesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fFramesCmd->SetToBeBroadcasted(false);
+
+	// Checkpoints
+	fCheckpointDir = new G4UIdirectory("/scint/checkpoint/", false);
+	fCheckpointDir->SetGuidance("Periodic checkpoints of the accumulated results and resume");
+
+	fCheckpointEventsCmd = new G4UIcmdWithAnInteger("/scint/checkpoint/events", this);
+	fCheckpointEventsCmd->SetGuidance("Checkpoint every n events of each worker (0: off)");
+	fCheckpointEventsCmd->SetParameterName("n", false);
+	fCheckpointEventsCmd->SetRange("n>=0");
+	fCheckpointEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fCheckpointEventsCmd->SetToBeBroadcasted(false);
+
+	fCheckpointIntervalCmd = new G4UIcmdWithADoubleAndUnit("/scint/checkpoint/interval", this);
+	fCheckpointIntervalCmd->SetGuidance("Checkpoint every t of wall time of each worker (0: off)");
+	fCheckpointIntervalCmd->SetParameterName("t", false);
+	fCheckpointIntervalCmd->SetRange("t>=0");
+	fCheckpointIntervalCmd->SetDefaultUnit("s");
+	fCheckpointIntervalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fCheckpointIntervalCmd->SetToBeBroadcasted(false);
+
+	fCheckpointDirCmd = new G4UIcmdWithAString("/scint/checkpoint/dir", this);
+	fCheckpointDirCmd->SetGuidance("Directory of the checkpoint files");
+	fCheckpointDirCmd->SetParameterName("dir", false);
+	fCheckpointDirCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fCheckpointDirCmd->SetToBeBroadcasted(false);
+
+	fResumeCmd = new G4UIcmdWithAnInteger("/scint/checkpoint/resume", this);
+	fResumeCmd->SetGuidance("Restore the last checkpoint and run the remaining events up to nTotal");
+	fResumeCmd->SetGuidance("(0: the total of the interrupted job); the outputs include the restored results");
+	fResumeCmd->SetParameterName("nTotal", true);
+	fResumeCmd->SetDefaultValue(0);
+	fResumeCmd->SetRange("nTotal>=0");
+	fResumeCmd->AvailableForStates(G4State_Idle);
+	fResumeCmd->SetToBeBroadcasted(false);
+
+	// Monitoring
+	fMonitorDir = new G4UIdirectory("/scint/monitor/", false);
+	fMonitorDir->SetGuidance("Live progress on a Unix domain socket (client: scint_monitor)");
+
+	fMonitorSocketCmd = new G4UIcmdWithAString("/scint/monitor/socket", this);
+	fMonitorSocketCmd->SetGuidance("Socket path served during each run (\"none\" to disable)");
+	fMonitorSocketCmd->SetParameterName("path", false);
+	fMonitorSocketCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fMonitorSocketCmd->SetToBeBroadcasted(false);
+
+	fMonitorMapSizeCmd = new G4UIcmdWithAnInteger("/scint/monitor/mapSize", this);
+	fMonitorMapSizeCmd->SetGuidance("Cells per side of the downsampled map");
+	fMonitorMapSizeCmd->SetParameterName("n", false);
+	fMonitorMapSizeCmd->SetRange("n>0");
+	fMonitorMapSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fMonitorMapSizeCmd->SetToBeBroadcasted(false);
+
+	fMonitorMapPeriodCmd = new G4UIcmdWithAnInteger("/scint/monitor/mapPeriod", this);
+	fMonitorMapPeriodCmd->SetGuidance("Events of a worker between updates of its downsampled map");
+	fMonitorMapPeriodCmd->SetParameterName("n", false);
+	fMonitorMapPeriodCmd->SetRange("n>0");
+	fMonitorMapPeriodCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fMonitorMapPeriodCmd->SetToBeBroadcasted(false);
+
+	// Stepping profiler
+	fProfileDir = new G4UIdirectory("/scint/profile/", false);
+	fProfileDir->SetGuidance("Step counts and sampled time per (volume, particle, process)");
+
+	fProfileEnableCmd = new G4UIcmdWithABool("/scint/profile/enable", this);
+	fProfileEnableCmd->SetGuidance("Profile the next runs and print the table at end of run");
+	fProfileEnableCmd->SetParameterName("enable", false);
+	fProfileEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fProfileEnableCmd->SetToBeBroadcasted(false);
+
+	fProfilePeriodCmd = new G4UIcmdWithAnInteger("/scint/profile/samplePeriod", this);
+	fProfilePeriodCmd->SetGuidance("Time one step out of n");
+	fProfilePeriodCmd->SetParameterName("n", false);
+	fProfilePeriodCmd->SetRange("n>0");
+	fProfilePeriodCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fProfilePeriodCmd->SetToBeBroadcasted(false);
+
+	fProfileRowsCmd = new G4UIcmdWithAnInteger("/scint/profile/maxRows", this);
+	fProfileRowsCmd->SetGuidance("Rows printed in the table (0: all)");
+	fProfileRowsCmd->SetParameterName("n", false);
+	fProfileRowsCmd->SetRange("n>=0");
+	fProfileRowsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fProfileRowsCmd->SetToBeBroadcasted(false);
+
+	// Two-stage pipeline
+	fPipelineDir = new G4UIdirectory("/scint/pipeline/", false);
+	fPipelineDir->SetGuidance("Source + phantom (stage 1) cached as a phase space, panel (stage 2) re-simulated");
+
+	fStageCmd = new G4UIcmdWithAString("/scint/pipeline/stage", this);
+	fStageCmd->SetGuidance("full    : source, phantom and panel");
+	fStageCmd->SetGuidance("phantom : stage 1, particles are recorded and killed at the plane");
+	fStageCmd->SetGuidance("panel   : stage 2, no phantom, primaries from the stage-1 phase space");
+	fStageCmd->SetParameterName("stage", false);
+	fStageCmd->SetCandidates("full phantom panel");
+	fStageCmd->AvailableForStates(G4State_PreInit);
+	fStageCmd->SetToBeBroadcasted(false);
+
+	fCacheDirCmd = new G4UIcmdWithAString("/scint/pipeline/cacheDir", this);
+	fCacheDirCmd->SetGuidance("Directory holding stage-1 phase spaces");
+	fCacheDirCmd->SetParameterName("dir", false);
+	fCacheDirCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fCacheDirCmd->SetToBeBroadcasted(false);
+
+	fSourceMacroCmd = new G4UIcmdWithAString("/scint/pipeline/sourceMacro", this);
+	fSourceMacroCmd->SetGuidance("Execute the macro defining the source; its content is part of the cache key");
+	fSourceMacroCmd->SetParameterName("macro", false);
+	fSourceMacroCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fSourceMacroCmd->SetToBeBroadcasted(false);
+
+	fPipelineBeamOnCmd = new G4UIcmdWithAnInteger("/scint/pipeline/beamOn", this);
+	fPipelineBeamOnCmd->SetGuidance("Run the current stage; stage 1 is skipped when a cached result");
+	fPipelineBeamOnCmd->SetGuidance("with at least this many primaries exists");
+	fPipelineBeamOnCmd->SetParameterName("nEvents", false);
+	fPipelineBeamOnCmd->SetRange("nEvents>=0");
+	fPipelineBeamOnCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+	fPipelineBeamOnCmd->SetToBeBroadcasted(false);
+}
+
+SimulationMessenger::~SimulationMessenger()
+{
+	delete fPixelsCmd;
+	delete fReadoutCmd;
+	delete fLayoutCmd;
+	delete fSmartlessCmd;
+	delete fPhantomCmd;
+	delete fDetDir;
+
+	delete fDeferCmd;
+	delete fTransportCmd;
+	delete fFilterCmd;
+	delete fFilterThresholdCmd;
+	delete fFilterCorrectionCmd;
+	delete fOpticalDir;
+
+	delete fPhspEnableCmd;
+	delete fPhspPlaneZCmd;
+	delete fPhspFileCmd;
+	delete fPhspBufferCmd;
+	delete fPhspInputCmd;
+	delete fResponseModeCmd;
+	delete fResponseFileCmd;
+	delete fResponseUnitCmd;
+	delete fResponseDir;
+	delete fPhspDir;
+	delete fEventEnableCmd;
+	delete fEventFileCmd;
+	delete fEventEncodingCmd;
+	delete fEventBufferCmd;
+	delete fEventDir;
+
+	delete fOutputDirCmd;
+	delete fMapFileCmd;
+	delete fSpectrumFileCmd;
+	delete fMomentsFileCmd;
+	delete fContainerFileCmd;
+	delete fStatsFileCmd;
+	delete fTimeMapFileCmd;
+	delete fFormatCmd;
+	delete fAsyncCmd;
+	delete fAsyncQueueCmd;
+	delete fCompressionCmd;
+	delete fCompressionBlockCmd;
+	delete fOutputDir;
+
+	delete fFramePeriodCmd;
+	delete fFramesCmd;
+	delete fTimeDir;
+
+	delete fCheckpointEventsCmd;
+	delete fCheckpointIntervalCmd;
+	delete fCheckpointDirCmd;
+	delete fResumeCmd;
+	delete fCheckpointDir;
+
+	delete fMonitorSocketCmd;
+	delete fMonitorMapSizeCmd;
+	delete fMonitorMapPeriodCmd;
+	delete fMonitorDir;
+
+	delete fProfileEnableCmd;
+	delete fProfilePeriodCmd;
+	delete fProfileRowsCmd;
+	delete fProfileDir;
+
+	delete fStageCmd;
+	delete fCacheDirCmd;
+	delete fSourceMacroCmd;
+	delete fPipelineBeamOnCmd;
+	delete fPipelineDir;
+
+	delete fScintDir;
+}
+
+void SimulationMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+	if(command == fPixelsCmd)
+		fConfig->SetNumberOfPixels(fPixelsCmd->GetNewIntValue(newValue));
+	else if(command == fReadoutCmd)
+		fConfig->SetReadout(newValue == "face" ? kFaceReadout : kVolumeReadout);
+	else if(command == fLayoutCmd)
+		fConfig->SetPixelLayout(newValue == "nested" ? kNestedLayout : (newValue == "single" ? kSingleLayout : kReplicaLayout));
+	else if(command == fSmartlessCmd)
+		fConfig->SetSmartless(fSmartlessCmd->GetNewDoubleValue(newValue));
+	else if(command == fPhantomCmd)
+		fConfig->SetPhantomFile(newValue == "none" ? G4String("") : newValue);
+	else if(command == fDeferCmd)
+		fConfig->SetOpticalDeferEnabled(fDeferCmd->GetNewBoolValue(newValue));
+	else if(command == fTransportCmd)
+		fConfig->SetOpticalTransport(newValue == "analytic" ? kAnalyticTransport : kGeant4Transport);
+	else if(command == fFilterCmd)
+		fConfig->SetOpticalFilter(newValue == "cull" ? kFilterCull : (newValue == "validate" ? kFilterValidate : kFilterOff));
+	else if(command == fFilterThresholdCmd)
+		fConfig->SetOpticalFilterThreshold(fFilterThresholdCmd->GetNewDoubleValue(newValue));
+	else if(command == fFilterCorrectionCmd)
+		fConfig->SetOpticalFilterCorrection(fFilterCorrectionCmd->GetNewBoolValue(newValue));
+	else if(command == fResponseModeCmd)
+		fConfig->SetResponseMode(newValue == "weight" ? kResponseWeight : (newValue == "accept" ? kResponseAccept : kResponseOff));
+	else if(command == fResponseFileCmd)
+		fConfig->SetResponseFile(newValue);
+	else if(command == fResponseUnitCmd)
+		fConfig->SetResponseWavelength(newValue == "nm");
+	else if(command == fPhspEnableCmd)
+		fConfig->SetPhaseSpaceEnabled(fPhspEnableCmd->GetNewBoolValue(newValue));
+	else if(command == fPhspPlaneZCmd)
+		fConfig->SetPhaseSpacePlaneZ(fPhspPlaneZCmd->GetNewDoubleValue(newValue));
+	else if(command == fPhspFileCmd)
+		fConfig->SetPhaseSpaceFile(newValue);
+	else if(command == fPhspBufferCmd)
+		fConfig->SetPhaseSpaceBufferSize(fPhspBufferCmd->GetNewIntValue(newValue));
+	else if(command == fPhspInputCmd)
+		fConfig->SetPhaseSpaceInput(newValue == "none" ? G4String("") : newValue);
+	else if(command == fEventEnableCmd)
+		fConfig->SetEventOutputEnabled(fEventEnableCmd->GetNewBoolValue(newValue));
+	else if(command == fEventFileCmd)
+		fConfig->SetEventFile(newValue);
+	else if(command == fEventEncodingCmd)
+		fConfig->SetEventEncoding(newValue == "dense" ? kEncodingDense : (newValue == "sparse" ? kEncodingSparse : kEncodingAuto));
+	else if(command == fEventBufferCmd)
+		fConfig->SetEventBufferSize(size_t(1048576.*fEventBufferCmd->GetNewDoubleValue(newValue)));
+	else if(command == fOutputDirCmd)
+		fConfig->SetOutputDirectory(newValue == "none" ? G4String("") : newValue);
+	else if(command == fMapFileCmd)
+		fConfig->SetMapFile(newValue);
+	else if(command == fSpectrumFileCmd)
+		fConfig->SetSpectrumFile(newValue);
+	else if(command == fMomentsFileCmd)
+		fConfig->SetMomentsFile(newValue == "none" ? G4String("") : newValue);
+	else if(command == fContainerFileCmd)
+		fConfig->SetContainerFile(newValue == "none" ? G4String("") : newValue);
+	else if(command == fFormatCmd)
+		fConfig->SetBinaryOutput(newValue == "binary");
+	else if(command == fTimeMapFileCmd)
+		fConfig->SetTimeMapFile(newValue);
+	else if(command == fAsyncCmd)
+		fConfig->SetAsyncOutput(fAsyncCmd->GetNewBoolValue(newValue));
+	else if(command == fAsyncQueueCmd)
+		fConfig->SetAsyncQueueSize(fAsyncQueueCmd->GetNewDoubleValue(newValue));
+	else if(command == fCompressionCmd)
+	{
+		BlockCodec codec = kCodecStored;
+		ParseBlockCodec(newValue, codec);
+		if(!IsBlockCodecAvailable(codec))
+		{
+			G4ExceptionDescription ed;
+			ed << newValue << " compression is not built in, using builtin";
+			G4Exception("SimulationMessenger::SetNewValue()", "Out003", JustWarning, ed);
+			codec = kCodecBuiltin;
+		}
+		fConfig->SetCompression(codec);
+	}
+	else if(command == fCompressionBlockCmd)
+		fConfig->SetCompressionBlockSize(1024*fCompressionBlockCmd->GetNewIntValue(newValue));
+	else if(command == fFramePeriodCmd)
+		fConfig->SetFramePeriod(fFramePeriodCmd->GetNewDoubleValue(newValue));
+	else if(command == fFramesCmd)
+		fConfig->SetNumberOfFrames(fFramesCmd->GetNewIntValue(newValue));
+	else if(command == fStatsFileCmd)
+		fConfig->SetStatisticsFile(newValue == "none" ? G4String("") : newValue);
+	else if(command == fCheckpointEventsCmd)
+		fConfig->SetCheckpointEvents(fCheckpointEventsCmd->GetNewIntValue(newValue));
+	else if(command == fCheckpointIntervalCmd)
+		fConfig->SetCheckpointInterval(fCheckpointIntervalCmd->GetNewDoubleValue(newValue));
+	else if(command == fCheckpointDirCmd)
+		fConfig->SetCheckpointDirectory(newValue);
+	else if(command == fResumeCmd)
+	{
+		G4long nEvents = Checkpoint::Resume(fResumeCmd->GetNewIntValue(newValue));
+		if(nEvents >= 0)
+		{
+			std::ostringstream beamOn;
+			beamOn << "/run/beamOn " << nEvents;
+			G4UImanager::GetUIpointer()->ApplyCommand(beamOn.str());
+		}
+	}
+	else if(command == fMonitorSocketCmd)
+		fConfig->SetMonitorSocket(newValue == "none" ? G4String("") : newValue);
+	else if(command == fMonitorMapSizeCmd)
+		fConfig->SetMonitorMapSize(fMonitorMapSizeCmd->GetNewIntValue(newValue));
+	else if(command == fMonitorMapPeriodCmd)
+		fConfig->SetMonitorMapPeriod(fMonitorMapPeriodCmd->GetNewIntValue(newValue));
+	else if(command == fProfileEnableCmd)
+		fConfig->SetProfilerEnabled(fProfileEnableCmd->GetNewBoolValue(newValue));
+	else if(command == fProfilePeriodCmd)
+		fConfig->SetProfilerSamplePeriod(fProfilePeriodCmd->GetNewIntValue(newValue));
+	else if(command == fProfileRowsCmd)
+		fConfig->SetProfilerMaxRows(fProfileRowsCmd->GetNewIntValue(newValue));
+	else if(command == fStageCmd)
+	{
+		if(newValue == "phantom") fConfig->SetPipelineStage(kPhantomStage);
+		else if(newValue == "panel") fConfig->SetPipelineStage(kPanelStage);
+		else fConfig->SetPipelineStage(kFullStage);
+	}
+	else if(command == fCacheDirCmd)
+		fConfig->SetCacheDirectory(newValue);
+	else if(command == fSourceMacroCmd)
+	{
+		fConfig->SetSourceMacro(newValue);
+		G4UImanager::GetUIpointer()->ApplyCommand("/control/execute " + newValue);
+	}
+	else if(command == fPipelineBeamOnCmd)
+		PipelineBeamOn(fPipelineBeamOnCmd->GetNewIntValue(newValue));
+}
+
+namespace
+{
+	// FNV-1a, continued from hash
+	uint64_t Hash(const char* data, size_t n, uint64_t hash = 14695981039346656037ULL)
+	{
+		for(size_t i=0;i<n;i++)
+		{
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+}
+
+G4String SimulationMessenger::Stage1Key() const
+{
+	// Configuration only: the panel stage does not build the phantom, so
+	// nothing may come from the constructed geometry
+	std::ostringstream desc;
+
+	std::ifstream macro(fConfig->GetSourceMacro().c_str());
+	desc << macro.rdbuf() << "\n";
+
+	const G4String& phantomFile = fConfig->GetPhantomFile();
+	if(!phantomFile.empty())
+	{
+		uint64_t content = Hash(0, 0);
+		std::ifstream phantom(phantomFile.c_str(), std::ios::binary);
+		std::vector<char> chunk(1 << 20);
+		while(phantom.read(&chunk[0], chunk.size()) || phantom.gcount() > 0)
+			content = Hash(&chunk[0], phantom.gcount(), content);
+		desc << "VoxelPhantom " << phantomFile << " " << std::hex << content << std::dec << "\n";
+	}
+	else
+	{
+		const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+				G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+		desc << detector->GetWaterBoxDescription() << "\n";
+	}
+	desc << "plane " << fConfig->GetPhaseSpacePlaneZ()/mm << "\n";
+
+	const std::string str = desc.str();
+	const uint64_t hash = Hash(str.data(), str.size());
+
+	std::ostringstream key;
+	key << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return key.str();
+}
+
+void SimulationMessenger::PipelineBeamOn(G4int nEvents)
+{
+	G4UImanager* UImanager = G4UImanager::GetUIpointer();
+	// The stage is set by now, so the geometry can be built
+	if(G4StateManager::GetStateManager()->GetCurrentState() == G4State_PreInit)
+		UImanager->ApplyCommand("/run/initialize");
+
+	std::ostringstream beamOn;
+	beamOn << "/run/beamOn " << nEvents;
+
+	if(fConfig->GetPipelineStage() == kFullStage)
+	{
+		UImanager->ApplyCommand(beamOn.str());
+		return;
+	}
+
+	G4String cached = fConfig->GetCacheDirectory() + "/stage1_" + Stage1Key() + ".phsp";
+
+	// Primaries behind the cached phase space, -1 when there is none
+	G4long nCached = -1;
+	BlockReader in;
+	PhaseSpaceHeader header;
+	std::string error;
+	if(in.Open(cached, error) && in.GetSize() >= sizeof(header)
+			&& in.Read(0, reinterpret_cast<char*>(&header), sizeof(header), error)
+			&& strncmp(header.magic, PHSP_MAGIC, sizeof(header.magic)) == 0)
+		nCached = header.nPrimaries;
+	in.Close();
+
+	if(fConfig->GetPipelineStage() == kPhantomStage)
+	{
+		if(nCached >= nEvents)
+		{
+			G4cout << "Stage 1: cached phase space " << cached << " (" << nCached
+					<< " primaries) is reused" << G4endl;
+			return;
+		}
+		mkdir(fConfig->GetCacheDirectory().c_str(), 0755);
+		// Only this run records into the cache; the run has ended (and its
+		// phase space been merged) when ApplyCommand returns
+		const G4bool phspEnabled = fConfig->IsPhaseSpaceEnabled();
+		const G4String phspFile = fConfig->GetPhaseSpaceFile();
+		fConfig->SetPhaseSpaceEnabled(true);
+		fConfig->SetPhaseSpaceFile(cached);
+		UImanager->ApplyCommand(beamOn.str());
+		fConfig->SetPhaseSpaceEnabled(phspEnabled);
+		fConfig->SetPhaseSpaceFile(phspFile);
+		return;
+	}
+
+	// Panel stage: an input set by the user wins over the cache. The cache
+	// is the input of this run only, so a later /run/beamOn or a pipeline
+	// run with another source or phantom does not replay it
+	const G4String input = fConfig->GetPhaseSpaceInput();
+	if(input.empty())
+	{
+		if(nCached < 0)
+		{
+			G4ExceptionDescription ed;
+			ed << "No stage-1 phase space " << cached << " for this source/phantom; run stage 1 first";
+			G4Exception("SimulationMessenger::PipelineBeamOn()", "Pipe001", JustWarning, ed);
+			return;
+		}
+		fConfig->SetPhaseSpaceInput(cached);
+	}
+	else nCached = -1;
+
+	// One event per source primary: more would replay the same primaries
+	if(nCached >= 0 && nEvents > nCached)
+	{
+		G4ExceptionDescription ed;
+		ed << nEvents << " events requested but the stage-1 phase space holds " << nCached
+				<< " primaries; only " << nCached << " events are run";
+		G4Exception("SimulationMessenger::PipelineBeamOn()", "Pipe002", JustWarning, ed);
+		beamOn.str("");
+		beamOn << "/run/beamOn " << nCached;
+	}
+	UImanager->ApplyCommand(beamOn.str());
+	fConfig->SetPhaseSpaceInput(input);
+}
@@ -0,0 +1,189 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "SlabTransport.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4OpticalSurface.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4PhysicalConstants.hh"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	// log(0) stand-in: any reflection gives a zero weight, none gives exp(0)
+	const G4double logZero = -1e30;
+
+	// Vertical direction cosine below which a photon never reaches the face
+	const G4double minCosine = 1e-12;
+}
+
+SlabTransport::SlabTransport()
+:fInitialized(false), fNPixel(0), fRIndex(0), fAbsLength(0), fReflectivity(0)
+{
+	fMinX = fMinY = fMinZ = fMaxZ = 0.;
+	fSizeX = fSizeY = fSizeZ = 0.;
+}
+
+SlabTransport::~SlabTransport()
+{
+
+}
+
+void SlabTransport::Initialize(G4int nPixel)
+{
+	const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+			G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+	fNPixel = nPixel;
+	fSizeX = detector->GetScintSizeX();
+	fSizeY = detector->GetScintSizeY();
+	fSizeZ = detector->GetScintSizeZ();
+	const G4ThreeVector centre = detector->GetScintCentre();
+	fMinX = centre.x() - 0.5*fSizeX;
+	fMinY = centre.y() - 0.5*fSizeY;
+	fMinZ = centre.z() - 0.5*fSizeZ;
+	fMaxZ = centre.z() + 0.5*fSizeZ;
+
+	G4MaterialPropertiesTable* scintTable = detector->GetScintMaterial()->GetMaterialPropertiesTable();
+	fRIndex = scintTable->GetProperty("RINDEX");
+	fAbsLength = scintTable->GetProperty("ABSLENGTH");
+
+	const G4OpticalSurface* wrap = detector->GetWrapSurface();
+	G4MaterialPropertiesTable* wrapTable = wrap ? wrap->GetMaterialPropertiesTable() : 0;
+	fReflectivity = wrapTable ? wrapTable->GetProperty("REFLECTIVITY") : 0;
+
+	// Polished (glisur, polish 1) finishes reflect specularly
+	if(!wrap || wrap->GetType() != dielectric_metal || wrap->GetFinish() == ground || wrap->GetPolish() < 1.)
+	{
+		G4ExceptionDescription ed;
+		ed << "Analytic transport assumes a dielectric_metal wrap with specular reflection";
+		G4Exception("SlabTransport::Initialize()", "Opt002", JustWarning, ed);
+	}
+
+	fInitialized = true;
+}
+
+size_t SlabTransport::GetMemoryBytes() const
+{
+	return (fX.capacity() + fY.capacity() + fZ.capacity() + fDx.capacity() + fDy.capacity() + fDz.capacity()
+			+ fEnergy.capacity() + fTime.capacity() + fInvAbsLength.capacity() + fLogReflectivity.capacity()
+			+ fInvVelocity.capacity() + fArrival.capacity() + fWeight.capacity())*sizeof(G4double)
+			+ (fPixelY.capacity() + fPixelX.capacity())*sizeof(G4int);
+}
+
+G4bool SlabTransport::Add(const G4ThreeVector& pos, const G4ThreeVector& dir, G4double energy, G4double time)
+{
+	if(pos.x() < fMinX || pos.x() > fMinX + fSizeX || pos.y() < fMinY || pos.y() > fMinY + fSizeY
+			|| pos.z() < fMinZ || pos.z() > fMaxZ) return false;
+
+	fX.push_back(pos.x() - fMinX);
+	fY.push_back(pos.y() - fMinY);
+	fZ.push_back(pos.z() - fMinZ);
+	fDx.push_back(dir.x());
+	fDy.push_back(dir.y());
+	fDz.push_back(dir.z());
+	fEnergy.push_back(energy);
+	fTime.push_back(time);
+
+	// Material tables are looked up once per photon, outside the kernel
+	const G4double absLength = fAbsLength ? fAbsLength->Value(energy) : 0.;
+	const G4double reflectivity = fReflectivity ? fReflectivity->Value(energy) : 0.;
+	fInvAbsLength.push_back(absLength > 0. ? 1./absLength : 0.);
+	fLogReflectivity.push_back(reflectivity > 0. ? std::log(reflectivity) : logZero);
+	fInvVelocity.push_back((fRIndex ? fRIndex->Value(energy) : 1.)/c_light);
+	return true;
+}
+
+void SlabTransport::Propagate()
+{
+	const size_t n = fX.size();
+	fArrival.resize(n);
+	fWeight.resize(n);
+	fPixelY.resize(n);
+	fPixelX.resize(n);
+	if(n == 0) return;
+
+	const G4double* x = &fX[0];
+	const G4double* y = &fY[0];
+	const G4double* z = &fZ[0];
+	const G4double* dx = &fDx[0];
+	const G4double* dy = &fDy[0];
+	const G4double* dz = &fDz[0];
+	const G4double* t = &fTime[0];
+	const G4double* invAbs = &fInvAbsLength[0];
+	const G4double* logR = &fLogReflectivity[0];
+	const G4double* invV = &fInvVelocity[0];
+	G4double* arrival = &fArrival[0];
+	G4double* weight = &fWeight[0];
+	G4int* pixelY = &fPixelY[0];
+	G4int* pixelX = &fPixelX[0];
+
+	const G4double sx = fSizeX, sy = fSizeY, sz = fSizeZ;
+	const G4double invSx = 1./sx, invSy = 1./sy;
+	const G4double pixelsPerX = fNPixel*invSx, pixelsPerY = fNPixel*invSy;
+	const G4int lastPixel = fNPixel - 1;
+
+	for(size_t i=0;i<n;i++)
+	{
+		// Photons going up reflect on the top face and cross the whole slab
+		const G4double up = dz[i] > 0. ? 1. : 0.;
+		const G4double height = z[i] + up*2.*(sz - z[i]);
+		const G4double path = height/std::max(std::fabs(dz[i]), minCosine);
+
+		// Unfolded exit point, folded back at the side faces
+		const G4double ux = x[i] + dx[i]*path;
+		const G4double uy = y[i] + dy[i]*path;
+		const G4double nx = std::floor(ux*invSx);
+		const G4double ny = std::floor(uy*invSy);
+		const G4double oddX = nx - 2.*std::floor(0.5*nx);
+		const G4double oddY = ny - 2.*std::floor(0.5*ny);
+		const G4double fx = ux - nx*sx;
+		const G4double fy = uy - ny*sy;
+		const G4double exitX = fx + oddX*(sx - 2.*fx);
+		const G4double exitY = fy + oddY*(sy - 2.*fy);
+
+		const G4double nReflections = up + std::fabs(nx) + std::fabs(ny);
+		weight[i] = std::exp(nReflections*logR[i] - path*invAbs[i]);
+		arrival[i] = t[i] + path*invV[i];
+		pixelX[i] = std::min(G4int(exitX*pixelsPerX), lastPixel);
+		pixelY[i] = std::min(G4int(exitY*pixelsPerY), lastPixel);
+	}
+}
+
+void SlabTransport::Clear()
+{
+	fX.clear(); fY.clear(); fZ.clear();
+	fDx.clear(); fDy.clear(); fDz.clear();
+	fEnergy.clear(); fTime.clear();
+	fInvAbsLength.clear(); fLogReflectivity.clear(); fInvVelocity.clear();
+}
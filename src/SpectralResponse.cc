@@ -0,0 +1,122 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "SpectralResponse.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4PhysicalConstants.hh"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace
+{
+	// 0.5 meV bins over the 2.2 eV wide DRZ emission grid
+	const G4int nBins = 4096;
+}
+
+SpectralResponse SpectralResponse::fInstance;
+
+SpectralResponse* SpectralResponse::Instance()
+{
+	return &fInstance;
+}
+
+SpectralResponse::SpectralResponse()
+:fNBins(0), fEmin(0.), fInvStep(0.)
+{
+
+}
+
+void SpectralResponse::Build(const G4String& fileName, G4bool wavelength)
+{
+	std::ifstream in(fileName.c_str());
+	std::vector<std::pair<G4double, G4double> > points;
+	std::string line;
+	while(std::getline(in, line))
+	{
+		if(line.empty() || line[0] == '#') continue;
+		std::istringstream fields(line);
+		G4double x, qe;
+		if(!(fields >> x >> qe) || x <= 0.) continue;
+		// Wavelengths in nm, energies in eV
+		const G4double energy = wavelength ? h_Planck*c_light/(x*nm) : x*eV;
+		points.push_back(std::make_pair(energy, qe));
+	}
+	if(points.size() < 2)
+	{
+		G4ExceptionDescription ed;
+		ed << "Cannot read a spectral response table from " << fileName;
+		G4Exception("SpectralResponse::Build()", "Resp001", FatalException, ed);
+		return;
+	}
+	std::sort(points.begin(), points.end());
+
+	// Emission grid of the panel material
+	const DetectorConstruction* detector = static_cast<const DetectorConstruction*>(
+			G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+	const G4MaterialPropertyVector* grid =
+			detector->GetScintMaterial()->GetMaterialPropertiesTable()->GetProperty("RINDEX");
+	fEmin = grid->Energy(0);
+	const G4double emax = grid->Energy(grid->GetVectorLength() - 1);
+	const G4double step = (emax - fEmin)/nBins;
+	fInvStep = 1./step;
+	fNBins = nBins;
+
+	if(points.front().first > fEmin || points.back().first < emax)
+	{
+		G4ExceptionDescription ed;
+		ed << "Spectral response " << fileName << " does not cover the emission grid ("
+				<< fEmin/eV << " - " << emax/eV << " eV), response is 0 outside";
+		G4Exception("SpectralResponse::Build()", "Resp002", JustWarning, ed);
+	}
+
+	// Linear interpolation at the bin centres
+	fTable.assign(nBins, 0.);
+	size_t k = 0;
+	for(G4int i=0;i<nBins;i++)
+	{
+		const G4double energy = fEmin + (i + 0.5)*step;
+		if(energy < points.front().first || energy > points.back().first) continue;
+		while(points[k+1].first < energy) k++;
+		const G4double width = points[k+1].first - points[k].first;
+		const G4double f = width > 0. ? (energy - points[k].first)/width : 0.;
+		fTable[i] = points[k].second + f*(points[k+1].second - points[k].second);
+	}
+}
+
+G4double SpectralResponse::GetMean() const
+{
+	G4double sum = 0.;
+	for(size_t i=0;i<fTable.size();i++) sum += fTable[i];
+	return fTable.empty() ? 0. : sum/fTable.size();
+}
@@ -0,0 +1,103 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "StackingAction.hh"
+#include "RunAction.hh"
+#include "Run.hh"
+#include "SimulationConfig.hh"
+#include "SensitiveDetector.hh"
+
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4SDManager.hh"
+
+StackingAction::StackingAction(RunAction* runAction)
+:G4UserStackingAction(), fRunAction(runAction), fFilterReady(false), fDetector(0)
+{
+	fOpticalPhoton = G4OpticalPhoton::Definition();
+}
+
+StackingAction::~StackingAction()
+{
+
+}
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* aTrack)
+{
+	if(aTrack->GetParticleDefinition() != fOpticalPhoton) return fUrgent;
+
+	SimulationConfig* config = SimulationConfig::Instance();
+	Run* run = fRunAction->GetRun();
+	run->AddPhotonCreated();
+
+	const OpticalFilterMode mode = config->GetOpticalFilter();
+	if(mode != kFilterOff && config->GetReadout() == kFaceReadout)
+	{
+		// Geometry and surfaces are fixed once the run is initialized
+		if(!fFilterReady)
+		{
+			fFilter.Initialize();
+			fFilterReady = true;
+		}
+
+		if(fFilter.IsActive())
+		{
+			G4bool direct;
+			const G4double reach = fFilter.ReachProbability(aTrack->GetPosition(),
+					aTrack->GetMomentumDirection(), aTrack->GetKineticEnergy(), direct);
+			if(reach > config->GetOpticalFilterThreshold()) run->AddPhotonKept(reach);
+			else if(mode == kFilterCull)
+			{
+				run->AddPhotonCulled(reach);
+				return fKill;
+			}
+			else
+			{
+				run->AddPhotonKept(reach);
+				run->AddPhotonPredictedLost();
+				fFilter.MarkPredictedLost(aTrack->GetTrackID());
+			}
+		}
+	}
+
+	if(config->GetOpticalTransport() == kAnalyticTransport && config->GetReadout() == kFaceReadout)
+	{
+		// The detector of this thread exists once the run is initialized
+		if(!fDetector) fDetector = static_cast<SensitiveDetector*>(
+				G4SDManager::GetSDMpointer()->FindSensitiveDetector("detector", false));
+		if(fDetector && fDetector->AddAnalyticPhoton(aTrack)) return fKill;
+	}
+
+	return config->IsOpticalDeferEnabled() ? fWaiting : fUrgent;
+}
+
+void StackingAction::PrepareNewEvent()
+{
+	fFilter.Clear();
+}
@@ -0,0 +1,114 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "SteppingAction.hh"
+#include "RunAction.hh"
+#include "Run.hh"
+#include "SteppingProfiler.hh"
+#include "PhaseSpaceWriter.hh"
+#include "SimulationConfig.hh"
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4SystemOfUnits.hh"
+
+SteppingAction::SteppingAction(RunAction* runAction)
+:G4UserSteppingAction(), fRunAction(runAction)
+{
+	fOpticalPhoton = G4OpticalPhoton::Definition();
+}
+
+SteppingAction::~SteppingAction()
+{
+
+}
+
+void SteppingAction::UserSteppingAction(const G4Step* aStep)
+{
+	const G4Track* track = aStep->GetTrack();
+	Run* run = fRunAction->GetRun();
+	run->AddStep(track->GetParticleDefinition());
+
+	if(SteppingProfiler* profiler = run->GetProfiler()) profiler->Fill(aStep);
+
+	if(fRunAction->GetPhaseSpaceWriter()) RecordPhaseSpace(aStep);
+}
+
+void SteppingAction::RecordPhaseSpace(const G4Step* aStep)
+{
+	const G4Track* track = aStep->GetTrack();
+	if(track->GetParticleDefinition() == fOpticalPhoton) return;
+
+	// Only crossings towards the panel (-z) are recorded
+	const G4double planeZ = SimulationConfig::Instance()->GetPhaseSpacePlaneZ();
+	const G4StepPoint* pre = aStep->GetPreStepPoint();
+	const G4StepPoint* post = aStep->GetPostStepPoint();
+	const G4double z0 = pre->GetPosition().z();
+	const G4double z1 = post->GetPosition().z();
+	if(!(z0 > planeZ && z1 <= planeZ)) return;
+
+	G4ThreeVector pos, dir;
+	G4double kinE;
+	if(post->GetStepStatus() == fGeomBoundary && z1 == planeZ)
+	{
+		// Plane coincides with a volume boundary: post-step values are exact
+		pos = post->GetPosition();
+		dir = post->GetMomentumDirection();
+		kinE = post->GetKineticEnergy();
+	}
+	else
+	{
+		G4double f = (z0 - planeZ)/(z0 - z1);
+		pos = pre->GetPosition() + f*(post->GetPosition() - pre->GetPosition());
+		pos.setZ(planeZ);
+		dir = pre->GetMomentumDirection();
+		kinE = pre->GetKineticEnergy();
+	}
+
+	PhaseSpaceRecord rec;
+	rec.x = pos.x()/mm;
+	rec.y = pos.y()/mm;
+	rec.z = pos.z()/mm;
+	rec.dirX = dir.x();
+	rec.dirY = dir.y();
+	rec.dirZ = dir.z();
+	rec.kinE = kinE/MeV;
+	rec.weight = track->GetWeight();
+	rec.pdg = track->GetParticleDefinition()->GetPDGEncoding();
+	rec.eventID = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+
+	fRunAction->GetPhaseSpaceWriter()->Fill(rec);
+
+	// Stage 1 of the pipeline stops at the plane
+	if(SimulationConfig::Instance()->GetPipelineStage() == kPhantomStage)
+		const_cast<G4Track*>(track)->SetTrackStatus(fStopAndKill);
+}
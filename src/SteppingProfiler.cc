@@ -0,0 +1,134 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "SteppingProfiler.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4VProcess.hh"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+	typedef std::pair<G4String, SteppingProfiler::Entry> Row;
+
+	G4bool ByTime(const Row& a, const Row& b)
+	{
+		if(a.second.time != b.second.time) return a.second.time > b.second.time;
+		return a.second.nSteps > b.second.nSteps;
+	}
+}
+
+SteppingProfiler::SteppingProfiler(G4int samplePeriod)
+:fLast(0), fPeriod(samplePeriod > 0 ? samplePeriod : 1), fArmed(false), fT0(0.)
+{
+	fLastKey.volume = 0;
+	fLastKey.particle = 0;
+	fLastKey.process = 0;
+	fCountdown = fPeriod;
+}
+
+SteppingProfiler::~SteppingProfiler()
+{
+
+}
+
+void SteppingProfiler::FoldInto(std::map<G4String, Entry>& named) const
+{
+	// Processes are thread-local objects, so keys become names here
+	for(std::map<Key, Entry>::const_iterator it=fLocal.begin();it!=fLocal.end();++it)
+	{
+		G4String name = it->first.volume->GetName() + "\t" + it->first.particle->GetParticleName()
+				+ "\t" + (it->first.process ? it->first.process->GetProcessName() : G4String("none"));
+		Entry& e = named[name];
+		e.nSteps += it->second.nSteps;
+		e.nSamples += it->second.nSamples;
+		e.time += it->second.time;
+	}
+	for(std::map<G4String, Entry>::const_iterator it=fNamed.begin();it!=fNamed.end();++it)
+	{
+		Entry& e = named[it->first];
+		e.nSteps += it->second.nSteps;
+		e.nSamples += it->second.nSamples;
+		e.time += it->second.time;
+	}
+}
+
+void SteppingProfiler::Merge(const SteppingProfiler& other)
+{
+	other.FoldInto(fNamed);
+}
+
+void SteppingProfiler::Print(G4int maxRows) const
+{
+	std::map<G4String, Entry> named;
+	FoldInto(named);
+
+	std::vector<Row> rows(named.begin(), named.end());
+	std::sort(rows.begin(), rows.end(), ByTime);
+
+	G4long totalSteps = 0;
+	G4double totalTime = 0.;
+	for(size_t i=0;i<rows.size();i++)
+	{
+		totalSteps += rows[i].second.nSteps;
+		totalTime += rows[i].second.time;
+	}
+
+	G4cout << G4endl
+			<< "----------------------------- Stepping profile (sample period " << fPeriod
+			<< ") -----------------------------" << G4endl
+			<< std::setw(12) << "volume" << std::setw(16) << "particle" << std::setw(20) << "process"
+			<< std::setw(14) << "steps" << std::setw(8) << "%" << std::setw(12) << "time [s]"
+			<< std::setw(8) << "%" << std::setw(12) << "ns/step" << G4endl;
+
+	for(size_t i=0;i<rows.size() && (maxRows <= 0 || G4int(i) < maxRows);i++)
+	{
+		const G4String& name = rows[i].first;
+		size_t t1 = name.find('\t');
+		size_t t2 = name.find('\t', t1+1);
+		const Entry& e = rows[i].second;
+
+		G4cout << std::setw(12) << name.substr(0, t1)
+				<< std::setw(16) << name.substr(t1+1, t2-t1-1)
+				<< std::setw(20) << name.substr(t2+1)
+				<< std::setw(14) << e.nSteps
+				<< std::setw(8) << std::setprecision(3) << (totalSteps ? 100.*e.nSteps/totalSteps : 0.)
+				<< std::setw(12) << std::setprecision(4) << e.time
+				<< std::setw(8) << std::setprecision(3) << (totalTime > 0. ? 100.*e.time/totalTime : 0.)
+				<< std::setw(12) << std::setprecision(4) << (e.nSteps ? 1e9*e.time/e.nSteps : 0.)
+				<< G4endl;
+	}
+	G4cout << " " << rows.size() << " (volume, particle, process) entries, " << totalSteps << " steps, "
+			<< totalTime << " s sampled" << G4endl
+			<< "------------------------------------------------------------------------------------------------" << G4endl;
+	G4cout << std::setprecision(6);
+}
@@ -0,0 +1,285 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#include "MapIO.hh"
+#include "PixelMap.hh"
+#include "BlockFile.hh"
+#include "RunFile.hh"
+
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+double MapData::Sum() const
+{
+	double sum = 0.;
+	for(size_t k=0;k<value.size();k++) sum += value[k];
+	return sum;
+}
+
+double SpectrumData::Sum() const
+{
+	double sum = 0.;
+	for(size_t k=0;k<value.size();k++) sum += value[k];
+	return sum;
+}
+
+namespace
+{
+	bool ParseTextMap(const std::string& text, const std::string& fileName, MapData& map, std::string& error)
+	{
+		// Indices are read first, the grid size is known at the end
+		std::vector<int> is, js;
+		std::vector<double> vs;
+		int ni = 0, nj = 0;
+		const char* p = text.c_str();
+		while(*p)
+		{
+			const char* eol = strchr(p, '\n');
+			if(!eol) eol = p + strlen(p);
+			const char* q = p;
+			while(q < eol && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+			if(q == eol || *q == '#')
+			{
+				p = *eol ? eol + 1 : eol;
+				continue;
+			}
+
+			char *end1, *end2, *end3;
+			long i = strtol(q, &end1, 10);
+			long j = strtol(end1, &end2, 10);
+			double v = strtod(end2, &end3);
+			if(end1 == q || end2 == end1 || end3 == end2 || end3 > eol || i < 0 || j < 0)
+			{
+				error = "malformed line in " + fileName + ": " + std::string(p, eol);
+				return false;
+			}
+			is.push_back(int(i));
+			js.push_back(int(j));
+			vs.push_back(v);
+			if(i >= ni) ni = int(i) + 1;
+			if(j >= nj) nj = int(j) + 1;
+			p = *eol ? eol + 1 : eol;
+	}
+
+	map.ni = ni;
+	map.nj = nj;
+	map.value.assign(size_t(ni)*nj, 0.);
+	for(size_t k=0;k<vs.size();k++) map.value[size_t(is[k])*nj + js[k]] += vs[k];
+	return true;
+	}
+}
+
+bool ReadTextMap(const std::string& fileName, MapData& map, std::string& error)
+{
+	// Whole file in one read (decompressed when block-compressed),
+	// parsed in place (1000 x 1000 maps are 10 MB)
+	std::string text;
+	return BlockReader::ReadFile(fileName, text, error) && ParseTextMap(text, fileName, map, error);
+}
+
+namespace
+{
+	// Last entry named <leaf> or <group>/<leaf> of a run container
+	const RunFileEntry* FindLast(const RunFileReader& reader, const std::string& leaf)
+	{
+		const std::vector<RunFileEntry>& entries = reader.GetEntries();
+		for(size_t k=entries.size();k-->0;)
+		{
+			const std::string& name = entries[k].name;
+			if(name == leaf || (name.size() > leaf.size()
+					&& name.compare(name.size() - leaf.size() - 1, std::string::npos, "/" + leaf) == 0))
+				return &entries[k];
+		}
+		return 0;
+	}
+
+	bool ReadContainerArray(const std::string& fileName, const std::string& leaf,
+			const RunFileEntry*& entry, RunFileReader& reader, std::vector<double>& data, std::string& error)
+	{
+		if(!reader.Open(fileName, error)) return false;
+		entry = FindLast(reader, leaf);
+		if(!entry)
+		{
+			error = fileName + ": no " + leaf + " entry";
+			return false;
+		}
+		return reader.ReadArray(*entry, data, error);
+	}
+}
+
+bool ReadMap(const std::string& fileName, MapData& map, std::string& error)
+{
+	if(RunFileReader::IsRunFile(fileName))
+	{
+		RunFileReader reader;
+		const RunFileEntry* entry = 0;
+		if(!ReadContainerArray(fileName, "map", entry, reader, map.value, error)) return false;
+		if(entry->shape.size() != 2)
+		{
+			error = fileName + ": " + entry->name + " is not a 2D array";
+			return false;
+		}
+		map.ni = int(entry->shape[0]);
+		map.nj = int(entry->shape[1]);
+		return true;
+	}
+
+	std::string data;
+	if(!BlockReader::ReadFile(fileName, data, error)) return false;
+	if(data.compare(0, sizeof(PIXELMAP_MAGIC), PIXELMAP_MAGIC, sizeof(PIXELMAP_MAGIC)) != 0)
+		return ParseTextMap(data, fileName, map, error);
+
+	PixelMap pixels;
+	std::istringstream in(data);
+	if(!pixels.Read(in, error))
+	{
+		error = fileName + ": " + error;
+		return false;
+	}
+	std::vector<double> sum;
+	pixels.Downsample(pixels.GetNi(), pixels.GetNj(), sum);
+	map.ni = int(pixels.GetNi());
+	map.nj = int(pixels.GetNj());
+	map.value.swap(sum);
+	return true;
+}
+
+bool WriteTextMap(const std::string& fileName, const MapData& map)
+{
+	FILE* out = fopen(fileName.c_str(), "w");
+	if(!out) return false;
+	for(int i=0;i<map.ni;i++)
+	{
+		for(int j=0;j<map.nj;j++) fprintf(out, "%d\t%d\t%.10g\n", i, j, map.value[size_t(i)*map.nj + j]);
+		fputc('\n', out);
+	}
+	return fclose(out) == 0;
+}
+
+bool ReadSpectrum(const std::string& fileName, SpectrumData& spectrum, std::string& error)
+{
+	if(RunFileReader::IsRunFile(fileName))
+	{
+		RunFileReader reader;
+		const RunFileEntry* entry = 0;
+		if(!ReadContainerArray(fileName, "spectrum", entry, reader, spectrum.value, error)) return false;
+		const double eMin = atof(entry->GetAttribute("e_min_eV").c_str());
+		const double width = atof(entry->GetAttribute("bin_width_eV").c_str());
+		spectrum.edge.resize(spectrum.value.size());
+		for(size_t k=0;k<spectrum.edge.size();k++) spectrum.edge[k] = eMin + k*width;
+		return true;
+	}
+
+	std::string data;
+	if(!BlockReader::ReadFile(fileName, data, error)) return false;
+	std::istringstream in(data);
+
+	spectrum.edge.clear();
+	spectrum.value.clear();
+	std::string line;
+	while(std::getline(in, line))
+	{
+		if(line.empty() || line[0] == '#') continue;
+		std::istringstream ss(line);
+		double e, v;
+		if(!(ss >> e >> v))
+		{
+			error = "malformed line in " + fileName + ": " + line;
+			return false;
+		}
+		spectrum.edge.push_back(e);
+		spectrum.value.push_back(v);
+	}
+	return true;
+}
+
+bool ReadMoments(const std::string& fileName, MomentsData& moments, std::string& error)
+{
+	std::string data;
+	if(!BlockReader::ReadFile(fileName, data, error)) return false;
+	std::istringstream in(data);
+
+	moments = MomentsData();
+	std::string line;
+	while(std::getline(in, line))
+	{
+		if(line.empty() || line[0] == '#') continue;
+		std::istringstream ss(line);
+		std::string key;
+		ss >> key;
+		bool ok = true;
+		if(key == "events") ok = bool(ss >> moments.nEvents);
+		else if(key == "grid")
+		{
+			ok = (ss >> moments.ni >> moments.nj) && moments.ni > 0 && moments.nj > 0;
+			if(ok)
+			{
+				moments.pixel.assign(size_t(moments.ni)*moments.nj, Moments());
+				moments.row.assign(moments.ni, Moments());
+				moments.column.assign(moments.nj, Moments());
+			}
+		}
+		else if(key == "total")
+		{
+			ok = bool(ss >> moments.total.sum >> moments.total.sum2);
+			moments.total.sumt = moments.total.sum2;
+		}
+		else if(key == "row" || key == "column" || key == "spectrum")
+		{
+			long k;
+			Moments m;
+			ok = bool(ss >> k >> m.sum >> m.sum2 >> m.sumt) && k >= 0;
+			std::vector<Moments>& v = key == "row" ? moments.row : (key == "column" ? moments.column : moments.spectrum);
+			if(ok && key == "spectrum" && size_t(k) >= v.size()) v.resize(k + 1);
+			ok = ok && size_t(k) < v.size();
+			if(ok) v[k] = m;
+		}
+		else if(key == "pixel")
+		{
+			long i, j;
+			Moments m;
+			ok = bool(ss >> i >> j >> m.sum >> m.sum2 >> m.sumt) && i >= 0 && i < moments.ni && j >= 0 && j < moments.nj;
+			if(ok) moments.pixel[size_t(i)*moments.nj + j] = m;
+		}
+		else ok = false;
+		if(!ok)
+		{
+			error = "malformed line in " + fileName + ": " + line;
+			return false;
+		}
+	}
+	if(moments.nEvents < 2 || moments.ni <= 0)
+	{
+		error = fileName + ": not an event moments file";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,87 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+#ifndef MapIO_hh_
+#define MapIO_hh_
+
+// Readers for the run outputs used by the command-line tools
+// (no Geant4 dependency).
+
+#include <string>
+#include <vector>
+
+// Pixel map, row-major value[i*nj + j] as in "i \t j \t value" files
+struct MapData
+{
+	MapData() : ni(0), nj(0) {}
+	int ni, nj;
+	std::vector<double> value;
+
+	double Sum() const;
+};
+
+// Binned spectrum, lower bin edges in eV
+struct SpectrumData
+{
+	std::vector<double> edge;
+	std::vector<double> value;
+
+	double Sum() const;
+};
+
+// Sums over events of the per-event signal x, of x^2 and of x times the
+// event total
+struct Moments
+{
+	Moments() : sum(0.), sum2(0.), sumt(0.) {}
+	double sum, sum2, sumt;
+};
+
+// Event moments of a run (/scint/output/moments); pixel row-major
+// [i*nj + j], rows along i, columns along j
+struct MomentsData
+{
+	MomentsData() : nEvents(0), ni(0), nj(0) {}
+	long nEvents;
+	int ni, nj;
+	Moments total;
+	std::vector<Moments> pixel, row, column, spectrum;
+};
+
+bool ReadTextMap(const std::string& fileName, MapData& map, std::string& error);
+// Binary PixelMap files (frames summed), text maps or the last map of a
+// run container, told apart by the magic
+bool ReadMap(const std::string& fileName, MapData& map, std::string& error);
+// Legacy layout of Run::WriteMap, a blank line after every row
+bool WriteTextMap(const std::string& fileName, const MapData& map);
+// Text spectrum or the last spectrum of a run container
+bool ReadSpectrum(const std::string& fileName, SpectrumData& spectrum, std::string& error);
+bool ReadMoments(const std::string& fileName, MomentsData& moments, std::string& error);
+
+#endif
@@ -0,0 +1,324 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Analysis of pixel maps (replaces the gnupCntr / shell workflow).
+//
+//   scint_analyze [-w width_mm] [-o prefix] [-m merged_map [-b]] [-s summary.csv] [-e] map...
+//
+// The maps (text "i j value" or binary PixelMap, e.g. DE.out and the
+// per-thread files) are summed and analysed: total, maximum, centroid,
+// FWHM, flatness and symmetry of the x (j) and y (i) profiles through the
+// centroid. Flatness is 100 (Dmax - Dmin)/(Dmax + Dmin) and symmetry the
+// largest point difference 100 |D(c+d) - D(c-d)|/D(c), both within the
+// central 80 % of the FWHM.
+//
+//   -w  panel width in mm (pixel pitch = width / pixels, default 300)
+//   -o  writes <prefix>_map.csv, <prefix>_profiles.csv and <prefix>.ppm
+//   -m  writes the merged map, text or binary PixelMap (-b)
+//   -s  writes the metrics as CSV, one line per analysed map
+//   -e  analyses every map on its own instead of their sum
+// Exit status 0 on success, 2 on error.
+
+#include "MapIO.hh"
+#include "PixelMap.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Metrics
+	{
+		double total, max;
+		double centroidX, centroidY;     // mm
+		double fwhmX, fwhmY;             // mm, NAN when the profile has no half-maximum edges
+		double flatnessX, flatnessY;     // %
+		double symmetryX, symmetryY;     // %
+	};
+
+	void Usage()
+	{
+		fprintf(stderr, "usage: scint_analyze [-w width_mm] [-o prefix] [-m merged_map [-b]]"
+				" [-s summary.csv] [-e] map...\n");
+	}
+
+	double Interpolate(const std::vector<double>& p, double x)
+	{
+		if(x <= 0.) return p.front();
+		if(x >= p.size() - 1.) return p.back();
+		const size_t k = size_t(x);
+		return p[k] + (x - k)*(p[k+1] - p[k]);
+	}
+
+	// FWHM, flatness and symmetry of a profile, in pixels and %
+	void AnalyseProfile(const std::vector<double>& p, double& fwhm, double& flatness, double& symmetry)
+	{
+		fwhm = flatness = symmetry = NAN;
+		size_t peak = 0;
+		for(size_t k=1;k<p.size();k++) if(p[k] > p[peak]) peak = k;
+		const double half = 0.5*p[peak];
+		if(half <= 0.) return;
+
+		// Half-maximum crossings, linearly interpolated
+		size_t l = peak, r = peak;
+		while(l > 0 && p[l-1] > half) l--;
+		while(r + 1 < p.size() && p[r+1] > half) r++;
+		if(l == 0 || r + 1 == p.size()) return;
+		const double left = (l - 1) + (half - p[l-1])/(p[l] - p[l-1]);
+		const double right = r + (p[r] - half)/(p[r] - p[r+1]);
+		fwhm = right - left;
+
+		const double centre = 0.5*(left + right);
+		const double reach = 0.4*fwhm;
+		double dmin = p[peak], dmax = 0.;
+		for(long k=long(ceil(centre - reach));k<=long(floor(centre + reach));k++)
+		{
+			dmin = std::min(dmin, p[k]);
+			dmax = std::max(dmax, p[k]);
+		}
+		flatness = dmax + dmin > 0. ? 100.*(dmax - dmin)/(dmax + dmin) : NAN;
+
+		const double dc = Interpolate(p, centre);
+		double worst = 0.;
+		for(double d=0.5;d<=reach;d+=0.5)
+			worst = std::max(worst, fabs(Interpolate(p, centre + d) - Interpolate(p, centre - d)));
+		symmetry = dc > 0. ? 100.*worst/dc : NAN;
+	}
+
+	void Profiles(const MapData& map, int row, int column, std::vector<double>& px, std::vector<double>& py)
+	{
+		px.assign(map.value.begin() + size_t(row)*map.nj, map.value.begin() + size_t(row + 1)*map.nj);
+		py.resize(map.ni);
+		for(int i=0;i<map.ni;i++) py[i] = map.value[size_t(i)*map.nj + column];
+	}
+
+	Metrics Analyse(const MapData& map, double width, std::vector<double>& px, std::vector<double>& py)
+	{
+		Metrics m;
+		const double pitchX = width/map.nj, pitchY = width/map.ni;
+		double sumI = 0., sumJ = 0.;
+		m.total = 0.;
+		m.max = 0.;
+		for(int i=0;i<map.ni;i++)
+		{
+			for(int j=0;j<map.nj;j++)
+			{
+				const double v = map.value[size_t(i)*map.nj + j];
+				m.total += v;
+				sumI += v*(i + 0.5);
+				sumJ += v*(j + 0.5);
+				if(v > m.max) m.max = v;
+			}
+		}
+		const double ci = m.total > 0. ? sumI/m.total : 0.5*map.ni;
+		const double cj = m.total > 0. ? sumJ/m.total : 0.5*map.nj;
+		m.centroidX = cj*pitchX - 0.5*width;
+		m.centroidY = ci*pitchY - 0.5*width;
+
+		Profiles(map, std::min(int(ci), map.ni - 1), std::min(int(cj), map.nj - 1), px, py);
+		AnalyseProfile(px, m.fwhmX, m.flatnessX, m.symmetryX);
+		AnalyseProfile(py, m.fwhmY, m.flatnessY, m.symmetryY);
+		m.fwhmX *= pitchX;
+		m.fwhmY *= pitchY;
+		return m;
+	}
+
+	void PrintMetrics(const std::string& name, const MapData& map, const Metrics& m)
+	{
+		printf("%s: %dx%d pixels\n", name.c_str(), map.ni, map.nj);
+		printf("  total       %.6g\n", m.total);
+		printf("  maximum     %.6g\n", m.max);
+		printf("  centroid    x %.3f mm, y %.3f mm\n", m.centroidX, m.centroidY);
+		printf("  FWHM        x %.3f mm, y %.3f mm\n", m.fwhmX, m.fwhmY);
+		printf("  flatness    x %.2f %%, y %.2f %%\n", m.flatnessX, m.flatnessY);
+		printf("  symmetry    x %.2f %%, y %.2f %%\n", m.symmetryX, m.symmetryY);
+	}
+
+	void WriteSummaryLine(FILE* out, const std::string& name, const MapData& map, const Metrics& m)
+	{
+		fprintf(out, "%s,%d,%d,%.10g,%.10g,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", name.c_str(),
+				map.ni, map.nj, m.total, m.max, m.centroidX, m.centroidY, m.fwhmX, m.fwhmY,
+				m.flatnessX, m.flatnessY, m.symmetryX, m.symmetryY);
+	}
+
+	bool WriteMapCsv(const std::string& fileName, const MapData& map)
+	{
+		FILE* out = fopen(fileName.c_str(), "w");
+		if(!out) return false;
+		for(int i=0;i<map.ni;i++)
+		{
+			const double* row = &map.value[size_t(i)*map.nj];
+			for(int j=0;j<map.nj;j++) fprintf(out, j ? ",%.6g" : "%.6g", row[j]);
+			fputc('\n', out);
+		}
+		return fclose(out) == 0;
+	}
+
+	bool WriteProfilesCsv(const std::string& fileName, const std::vector<double>& px,
+			const std::vector<double>& py, double width)
+	{
+		FILE* out = fopen(fileName.c_str(), "w");
+		if(!out) return false;
+		fprintf(out, "axis,index,position_mm,value\n");
+		for(size_t k=0;k<px.size();k++)
+			fprintf(out, "x,%zu,%.4f,%.10g\n", k, (k + 0.5)*width/px.size() - 0.5*width, px[k]);
+		for(size_t k=0;k<py.size();k++)
+			fprintf(out, "y,%zu,%.4f,%.10g\n", k, (k + 0.5)*width/py.size() - 0.5*width, py[k]);
+		return fclose(out) == 0;
+	}
+
+	// Binary PPM, one pixel per map cell, palette of gnupCntr
+	bool WriteImage(const std::string& fileName, const MapData& map, double max)
+	{
+		static const double palette[][3] = { {0,0,0}, {0,0,1}, {0,1,1}, {0,1,0}, {1,1,0}, {1,0,0}, {0.5,0,0.5} };
+		static const double stop[] = { 0., 1., 2., 3., 4., 5., 8. };
+		const int nStops = 7;
+
+		FILE* out = fopen(fileName.c_str(), "wb");
+		if(!out) return false;
+		fprintf(out, "P6\n%d %d\n255\n", map.nj, map.ni);
+		std::vector<unsigned char> row(3*size_t(map.nj));
+		for(int i=0;i<map.ni;i++)
+		{
+			for(int j=0;j<map.nj;j++)
+			{
+				const double f = max > 0. ? stop[nStops-1]*map.value[size_t(i)*map.nj + j]/max : 0.;
+				int s = 0;
+				while(s < nStops - 2 && f > stop[s+1]) s++;
+				const double t = std::min(1., std::max(0., (f - stop[s])/(stop[s+1] - stop[s])));
+				for(int c=0;c<3;c++)
+					row[3*j + c] = (unsigned char)(255.*(palette[s][c] + t*(palette[s+1][c] - palette[s][c])) + 0.5);
+			}
+			fwrite(&row[0], 1, row.size(), out);
+		}
+		return fclose(out) == 0;
+	}
+
+	bool WriteMergedMap(const std::string& fileName, const MapData& map, bool binary)
+	{
+		if(!binary) return WriteTextMap(fileName, map);
+		PixelMap pixels(map.ni, map.nj);
+		for(size_t k=0;k<map.value.size();k++) if(map.value[k] != 0.) pixels.Fill(k, map.value[k]);
+		return pixels.WriteBinary(fileName);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	double width = 300.;
+	std::string prefix, mergedFile, summaryFile;
+	bool binary = false, each = false;
+	std::vector<std::string> files;
+
+	for(int k=1;k<argc;k++)
+	{
+		std::string arg = argv[k];
+		if(arg == "-w" && k+1 < argc) width = atof(argv[++k]);
+		else if(arg == "-o" && k+1 < argc) prefix = argv[++k];
+		else if(arg == "-m" && k+1 < argc) mergedFile = argv[++k];
+		else if(arg == "-s" && k+1 < argc) summaryFile = argv[++k];
+		else if(arg == "-b") binary = true;
+		else if(arg == "-e") each = true;
+		else if(!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+		else files.push_back(arg);
+	}
+	if(files.empty() || width <= 0.) { Usage(); return 2; }
+
+	FILE* summary = 0;
+	if(!summaryFile.empty())
+	{
+		summary = fopen(summaryFile.c_str(), "w");
+		if(!summary)
+		{
+			fprintf(stderr, "scint_analyze: cannot write %s\n", summaryFile.c_str());
+			return 2;
+		}
+		fprintf(summary, "file,ni,nj,total,max,centroid_x_mm,centroid_y_mm,fwhm_x_mm,fwhm_y_mm,"
+				"flatness_x,flatness_y,symmetry_x,symmetry_y\n");
+	}
+
+	MapData sum, map;
+	std::string error;
+	std::vector<double> px, py;
+	for(size_t f=0;f<files.size();f++)
+	{
+		if(!ReadMap(files[f], map, error))
+		{
+			fprintf(stderr, "scint_analyze: %s\n", error.c_str());
+			return 2;
+		}
+		if(each)
+		{
+			Metrics m = Analyse(map, width, px, py);
+			if(summary) WriteSummaryLine(summary, files[f], map, m);
+			else PrintMetrics(files[f], map, m);
+			continue;
+		}
+		if(f == 0) { sum = map; continue; }
+		if(map.ni != sum.ni || map.nj != sum.nj)
+		{
+			fprintf(stderr, "scint_analyze: %s has %dx%d pixels, expected %dx%d\n",
+					files[f].c_str(), map.ni, map.nj, sum.ni, sum.nj);
+			return 2;
+		}
+		for(size_t k=0;k<sum.value.size();k++) sum.value[k] += map.value[k];
+	}
+	if(each)
+	{
+		if(summary) fclose(summary);
+		return 0;
+	}
+
+	const std::string name = files.size() == 1 ? files[0] : "merged";
+	Metrics m = Analyse(sum, width, px, py);
+	PrintMetrics(name, sum, m);
+	if(summary)
+	{
+		WriteSummaryLine(summary, name, sum, m);
+		fclose(summary);
+	}
+
+	bool ok = true;
+	if(!mergedFile.empty()) ok = WriteMergedMap(mergedFile, sum, binary) && ok;
+	if(!prefix.empty())
+	{
+		ok = WriteMapCsv(prefix + "_map.csv", sum) && ok;
+		ok = WriteProfilesCsv(prefix + "_profiles.csv", px, py, width) && ok;
+		ok = WriteImage(prefix + ".ppm", sum, m.max) && ok;
+	}
+	if(!ok)
+	{
+		fprintf(stderr, "scint_analyze: cannot write the outputs\n");
+		return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,257 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Lists and extracts the entries of a run container (see include/RunFile.hh).
+//
+//   scint_dump file                                        list entries
+//   scint_dump [-r first:count] [-j threads] [-o output] file entry
+//   scint_dump -a entry [-c codec] input container        add a legacy file
+//
+// Listing prints name, type, shape, stored and raw size and the attributes
+// of every entry (older entries of the same name are marked "replaced").
+// Extraction writes text entries verbatim, 2D arrays in the legacy map layout
+// "i \t j \t value" with a blank line per row (as DE.out, readable by every
+// tool and gnuplot), spectra as "E_low [eV] \t value" (as Spectrum.out) and
+// other arrays as "index \t value". -r extracts rows
+// [first, first+count) of the first dimension and only decodes their blocks.
+// -a converts a legacy map (any format read by scint_analyze), a spectrum
+// (entry name ending in "spectrum") or any other file (text entry) into an
+// entry of the container, created when missing.
+// Exit status 0 on success, 2 on error.
+
+#include "RunFile.hh"
+#include "MapIO.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	void Usage()
+	{
+		fprintf(stderr, "usage: scint_dump file\n"
+				"       scint_dump [-r first:count] [-j threads] [-o output] file entry\n"
+				"       scint_dump -a entry [-c codec] input container\n");
+	}
+
+	std::string Shape(const RunFileEntry& entry)
+	{
+		if(entry.shape.empty()) return "-";
+		std::ostringstream out;
+		for(size_t k=0;k<entry.shape.size();k++) out << (k ? " x " : "") << entry.shape[k];
+		return out.str();
+	}
+
+	void List(const RunFileReader& reader)
+	{
+		const std::vector<RunFileEntry>& entries = reader.GetEntries();
+		for(size_t k=0;k<entries.size();k++)
+		{
+			const RunFileEntry& entry = entries[k];
+			uint64_t raw = entry.type == kRunFileText ? 0 : 8*entry.GetNumberOfElements();
+			printf("%-32s %-8s %-16s %10.3f MB", entry.name.c_str(), GetRunFileTypeName(entry.type),
+					Shape(entry).c_str(), entry.size/1048576.);
+			if(raw) printf(" (%.3f MB raw)", raw/1048576.);
+			if(reader.Find(entry.name) != &entry) printf(" replaced");
+			printf("\n");
+			for(size_t a=0;a<entry.attributes.size();a++)
+				printf("    %s = %s\n", entry.attributes[a].first.c_str(), entry.attributes[a].second.c_str());
+		}
+	}
+
+	bool Extract(const RunFileReader& reader, const RunFileEntry& entry, uint64_t first, uint64_t count,
+			int nThreads, FILE* out, std::string& error)
+	{
+		if(entry.type == kRunFileText)
+		{
+			std::string text;
+			if(!reader.ReadText(entry, text, error)) return false;
+			return fwrite(text.data(), 1, text.size(), out) == text.size();
+		}
+
+		const uint64_t nRows = entry.shape.empty() ? 0 : entry.shape[0];
+		if(first > nRows) first = nRows;
+		if(count > nRows - first) count = nRows - first;
+		std::vector<double> data;
+		if(first == 0 && count == nRows)
+		{
+			if(!reader.ReadArray(entry, data, error, nThreads)) return false;
+		}
+		else if(!reader.ReadRows(entry, first, count, data, error)) return false;
+
+		const bool integer = entry.type == kRunFileInt64;
+		const uint64_t nj = entry.GetRowLength();
+		const bool spectrum = !entry.GetAttribute("bin_width_eV").empty();
+		const double eMin = atof(entry.GetAttribute("e_min_eV").c_str());
+		const double width = atof(entry.GetAttribute("bin_width_eV").c_str());
+		for(uint64_t n=0;n<data.size();n++)
+		{
+			if(entry.shape.size() == 2)
+			{
+				fprintf(out, integer ? "%lu\t%lu\t%.0f\n" : "%lu\t%lu\t%.10g\n",
+						(unsigned long)(first + n/nj), (unsigned long)(n%nj), data[n]);
+				if(n%nj == nj-1) fputc('\n', out);
+			}
+			else if(spectrum) fprintf(out, "%.10g\t%.10g\n", eMin + (first + n)*width, data[n]);
+			else fprintf(out, integer ? "%lu\t%.0f\n" : "%lu\t%.10g\n", (unsigned long)(first*nj + n), data[n]);
+		}
+		return !ferror(out);
+	}
+
+	bool Add(const std::string& name, const std::string& input, const std::string& container, BlockCodec codec,
+			std::string& error)
+	{
+		RunFileWriter writer;
+		if(!writer.Open(container, true, error)) return false;
+		writer.SetCompression(codec, 1024*1024);
+
+		RunFileAttributes attributes;
+		attributes.push_back(std::make_pair("source", input));
+		const std::string spectrumSuffix = "spectrum";
+		MapData map;
+		SpectrumData spectrum;
+		std::string text, mapError;
+		if(name.size() >= spectrumSuffix.size()
+				&& name.compare(name.size() - spectrumSuffix.size(), std::string::npos, spectrumSuffix) == 0)
+		{
+			if(!ReadSpectrum(input, spectrum, error)) return false;
+			if(spectrum.edge.size() > 1)
+			{
+				std::ostringstream eMin, width;
+				eMin << spectrum.edge[0];
+				width << spectrum.edge[1] - spectrum.edge[0];
+				attributes.push_back(std::make_pair("e_min_eV", eMin.str()));
+				attributes.push_back(std::make_pair("bin_width_eV", width.str()));
+			}
+			writer.AddArray(name, spectrum.value.empty() ? 0 : &spectrum.value[0],
+					std::vector<uint64_t>(1, spectrum.value.size()), attributes);
+		}
+		else if(ReadMap(input, map, mapError) && map.ni > 0)
+		{
+			std::vector<uint64_t> shape;
+			shape.push_back(map.ni);
+			shape.push_back(map.nj);
+			writer.AddArray(name, &map.value[0], shape, attributes);
+		}
+		else if(BlockReader::ReadFile(input, text, error)) writer.AddText(name, text, attributes);
+		else return false;
+		return writer.Close(error);
+	}
+
+	bool ParseRows(const std::string& arg, uint64_t& first, uint64_t& count)
+	{
+		size_t colon = arg.find(':');
+		if(colon == std::string::npos) return false;
+		first = strtoull(arg.substr(0, colon).c_str(), 0, 10);
+		count = strtoull(arg.substr(colon+1).c_str(), 0, 10);
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int nThreads = std::max(1u, std::thread::hardware_concurrency());
+	uint64_t first = 0, count = uint64_t(-1);
+	BlockCodec codec = kCodecBuiltin;
+	std::string output, addName;
+	std::vector<std::string> args;
+
+	for(int k=1;k<argc;k++)
+	{
+		std::string arg = argv[k];
+		if(arg == "-j" && k+1 < argc) nThreads = atoi(argv[++k]);
+		else if(arg == "-o" && k+1 < argc) output = argv[++k];
+		else if(arg == "-a" && k+1 < argc) addName = argv[++k];
+		else if(arg == "-r" && k+1 < argc)
+		{
+			if(!ParseRows(argv[++k], first, count)) { Usage(); return 2; }
+		}
+		else if(arg == "-c" && k+1 < argc)
+		{
+			if(!ParseBlockCodec(argv[++k], codec) || !IsBlockCodecAvailable(codec))
+			{
+				fprintf(stderr, "scint_dump: codec %s is not available (%s)\n", argv[k], GetBlockCodecNames().c_str());
+				return 2;
+			}
+		}
+		else if(!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+		else args.push_back(arg);
+	}
+
+	std::string error;
+	if(!addName.empty())
+	{
+		if(args.size() != 2) { Usage(); return 2; }
+		if(!Add(addName, args[0], args[1], codec, error))
+		{
+			fprintf(stderr, "scint_dump: %s\n", error.c_str());
+			return 2;
+		}
+		return 0;
+	}
+	if(args.empty() || args.size() > 2 || nThreads < 1) { Usage(); return 2; }
+
+	RunFileReader reader;
+	if(!reader.Open(args[0], error))
+	{
+		fprintf(stderr, "scint_dump: %s\n", error.c_str());
+		return 2;
+	}
+	if(args.size() == 1)
+	{
+		List(reader);
+		return 0;
+	}
+
+	const RunFileEntry* entry = reader.Find(args[1]);
+	if(!entry)
+	{
+		fprintf(stderr, "scint_dump: %s: no entry %s\n", args[0].c_str(), args[1].c_str());
+		return 2;
+	}
+	FILE* out = output.empty() ? stdout : fopen(output.c_str(), "w");
+	if(!out)
+	{
+		fprintf(stderr, "scint_dump: cannot write %s\n", output.c_str());
+		return 2;
+	}
+	bool ok = Extract(reader, *entry, first, count, nThreads, out, error);
+	if(out != stdout) ok = fclose(out) == 0 && ok;
+	if(!ok)
+	{
+		fprintf(stderr, "scint_dump: %s\n", error.empty() ? "write error" : error.c_str());
+		return 2;
+	}
+	return 0;
+}
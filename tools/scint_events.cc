@@ -0,0 +1,186 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Event datasets written with /scint/event/enable (see include/EventRecord.hh).
+//
+//   scint_events file                 summary of the dataset
+//   scint_events -e eventID file      primaries and non-zero pixels of one event,
+//                                     "iy \t ix \t edep [MeV] \t photons" per line
+//
+// The summary counts dense and sparse tensors and gives the totals, so the
+// encoding and the size per event can be checked before training.
+// Exit status 0 on success, 2 on error.
+
+#include "EventRecord.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+	void Usage()
+	{
+		fprintf(stderr, "usage: scint_events [-e eventID] file\n");
+	}
+
+	bool ReadAt(FILE* in, uint64_t offset, void* data, size_t n)
+	{
+		return fseeko(in, offset, SEEK_SET) == 0 && fread(data, 1, n, in) == n;
+	}
+
+	// Pixel values of one tensor, dense tensors reduced to their non-zero pixels
+	bool ReadTensor(FILE* in, const EventFileHeader& header, uint64_t offset, uint32_t count,
+			uint32_t encoding, std::map<uint32_t, float>& values)
+	{
+		const uint64_t base = header.dataOffset + offset;
+		if(encoding == kTensorDense)
+		{
+			std::vector<float> dense(count);
+			if(count && !ReadAt(in, base, &dense[0], count*sizeof(float))) return false;
+			for(uint32_t i=0;i<count;i++)
+				if(dense[i] != 0.f) values[i] = dense[i];
+			return true;
+		}
+		std::vector<uint32_t> index(count);
+		std::vector<float> value(count);
+		if(count && (!ReadAt(in, base, &index[0], count*sizeof(uint32_t))
+				|| !ReadAt(in, base + count*sizeof(uint32_t), &value[0], count*sizeof(float)))) return false;
+		for(uint32_t i=0;i<count;i++) values[index[i]] = value[i];
+		return true;
+	}
+
+	void PrintEvent(FILE* in, const EventFileHeader& header, const EventEntry& e)
+	{
+		printf("# event %d: %d primaries, first pdg %d at (%g, %g, %g) mm, direction (%g, %g, %g), weight %g\n",
+				e.eventID, e.nPrimaries, e.pdg, e.x, e.y, e.z, e.dirX, e.dirY, e.dirZ, e.weight);
+		printf("# primary energy %g MeV, deposited %g MeV, photons %g\n", e.kinE, e.edep, e.photons);
+		std::map<uint32_t, float> edep, photons;
+		if(!ReadTensor(in, header, e.edepOffset, e.edepCount, e.edepEncoding, edep)
+				|| !ReadTensor(in, header, e.photonOffset, e.photonCount, e.photonEncoding, photons))
+		{
+			fprintf(stderr, "scint_events: truncated tensor data\n");
+			return;
+		}
+		std::map<uint32_t, std::pair<float, float> > pixels;
+		for(std::map<uint32_t, float>::const_iterator it=edep.begin();it!=edep.end();++it) pixels[it->first].first = it->second;
+		for(std::map<uint32_t, float>::const_iterator it=photons.begin();it!=photons.end();++it) pixels[it->first].second = it->second;
+		for(std::map<uint32_t, std::pair<float, float> >::const_iterator it=pixels.begin();it!=pixels.end();++it)
+			printf("%u\t%u\t%g\t%g\n", it->first/header.nPixelX, it->first%header.nPixelX, it->second.first, it->second.second);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool select = false;
+	long eventID = 0;
+	std::string fileName;
+	for(int i=1;i<argc;i++)
+	{
+		if(!strcmp(argv[i], "-e") && i+1 < argc)
+		{
+			select = true;
+			eventID = atol(argv[++i]);
+		}
+		else if(argv[i][0] != '-' && fileName.empty()) fileName = argv[i];
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+	if(fileName.empty())
+	{
+		Usage();
+		return 2;
+	}
+
+	FILE* in = fopen(fileName.c_str(), "rb");
+	EventFileHeader header;
+	if(!in || !ReadAt(in, 0, &header, sizeof(header)) || strncmp(header.magic, EVENT_MAGIC, sizeof(header.magic))
+			|| header.entrySize != sizeof(EventEntry))
+	{
+		fprintf(stderr, "scint_events: %s is not an event dataset (version %d)\n", fileName.c_str(), EVENT_VERSION);
+		if(in) fclose(in);
+		return 2;
+	}
+
+	uint64_t nDense = 0, nSparse = 0, nValues = 0;
+	double edep = 0., photons = 0.;
+	bool found = false;
+	std::vector<EventEntry> entries(16384);
+	for(uint64_t first=0;first<header.nEvents;first+=entries.size())
+	{
+		const size_t m = std::min(uint64_t(entries.size()), header.nEvents - first);
+		if(!ReadAt(in, sizeof(header) + first*sizeof(EventEntry), &entries[0], m*sizeof(EventEntry)))
+		{
+			fprintf(stderr, "scint_events: %s: truncated entry table\n", fileName.c_str());
+			fclose(in);
+			return 2;
+		}
+		for(size_t k=0;k<m;k++)
+		{
+			const EventEntry& e = entries[k];
+			if(select)
+			{
+				if(e.eventID != eventID) continue;
+				PrintEvent(in, header, e);
+				found = true;
+				break;
+			}
+			nDense += (e.edepEncoding == kTensorDense) + (e.photonEncoding == kTensorDense);
+			nSparse += (e.edepEncoding == kTensorSparse) + (e.photonEncoding == kTensorSparse);
+			nValues += uint64_t(e.edepCount) + e.photonCount;
+			edep += e.edep;
+			photons += e.photons;
+		}
+		if(found) break;
+	}
+	fclose(in);
+
+	if(select)
+	{
+		if(!found) fprintf(stderr, "scint_events: event %ld not in %s\n", eventID, fileName.c_str());
+		return found ? 0 : 2;
+	}
+
+	const double nEvents = header.nEvents ? double(header.nEvents) : 1.;
+	printf("%s: %llu events, %u x %u pixels of %g x %g mm\n", fileName.c_str(), (unsigned long long)header.nEvents,
+			header.nPixelX, header.nPixelY, header.pitchX, header.pitchY);
+	printf("  tensors      : %llu dense, %llu sparse, %g stored values per event\n",
+			(unsigned long long)nDense, (unsigned long long)nSparse, nValues/nEvents);
+	printf("  size         : %g kB per event (%g MB tensor data)\n",
+			(header.dataOffset + header.dataSize)/1024./nEvents, header.dataSize/1048576.);
+	printf("  mean per event: %g MeV deposited, %g photons\n", edep/nEvents, photons/nEvents);
+	return 0;
+}
@@ -0,0 +1,378 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Parallel merge of pixel maps from many jobs and threads.
+//
+//   scint_merge [-j threads] [-o output] [-b] [-k] map...
+//
+// Inputs are legacy text maps ("i \t j \t value", e.g. the per-thread
+// <date>_ThreadNum_<n> files and DE.out), text time maps
+// ("frame \t i \t j \t value") or binary PixelMap files, in any mix,
+// each plain or block-compressed (/scint/output/compression). The grid (and pixel pitch of binary maps) of the first file is the
+// reference; every other file must match it. Files are distributed over
+// the threads, each thread reads its files into one accumulator, and
+// the accumulators are summed at the end, so memory does not grow with
+// the number of files.
+//
+//   -j  worker threads (default: hardware threads)
+//   -o  merged map (default merged.out), text unless -b
+//   -b  binary PixelMap output
+//   -k  skip invalid files instead of failing
+// Exit status 0 on success, 1 when files were skipped, 2 on error.
+
+#include "MapIO.hh"
+#include "PixelMap.hh"
+#include "BlockFile.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+namespace
+{
+	// Reference grid of the merge
+	struct Grid
+	{
+		int64_t ni, nj, nFrames;
+		double pitchX, pitchY;   // mm, 0 when unknown
+	};
+
+	void Usage()
+	{
+		fprintf(stderr, "usage: scint_merge [-j threads] [-o output] [-b] [-k] map...\n");
+	}
+
+	// Uncompressed content starts with the PixelMap magic
+	bool IsBinary(const std::string& fileName)
+	{
+		char magic[8] = {0};
+		BlockReader in;
+		std::string error;
+		return in.Open(fileName, error) && in.GetSize() >= sizeof(magic)
+				&& in.Read(0, magic, sizeof(magic), error) && strncmp(magic, PIXELMAP_MAGIC, sizeof(magic)) == 0;
+	}
+
+	// Next line of text starting at p (NUL-terminated copy in line)
+	bool NextLine(const std::string& text, size_t& p, std::string& line)
+	{
+		if(p >= text.size()) return false;
+		size_t eol = text.find('\n', p);
+		if(eol == std::string::npos) eol = text.size();
+		line.assign(text, p, eol - p);
+		p = eol + 1;
+		return true;
+	}
+
+	bool SamePitch(double a, double b)
+	{
+		return a == 0. || b == 0. || fabs(a - b) <= 1e-9*std::max(a, b);
+	}
+
+	// Text time maps carry "frames F, pixels N" in their header line
+	bool ReadTimeMapHeader(const char* line, Grid& grid)
+	{
+		const char* frames = strstr(line, "frames ");
+		const char* pixels = strstr(line, "pixels ");
+		long nFrames, nPixel;
+		if(!frames || !pixels || sscanf(frames, "frames %ld", &nFrames) != 1
+				|| sscanf(pixels, "pixels %ld", &nPixel) != 1) return false;
+		grid.ni = grid.nj = nPixel;
+		grid.nFrames = nFrames;
+		grid.pitchX = grid.pitchY = 0.;
+		return true;
+	}
+
+	// Numbers of one data line; 0 for blank and comment lines
+	int ParseLine(const char* line, double* field)
+	{
+		int n = 0;
+		const char* p = line;
+		char* end;
+		while(n < 5)
+		{
+			double v = strtod(p, &end);
+			if(end == p) break;
+			field[n++] = v;
+			p = end;
+		}
+		while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+		return *p == '\0' || *p == '#' ? n : -1;
+	}
+
+	// Grid of the first file: binary header, time-map header or the
+	// largest indices of a full-grid text map
+	bool ReadGrid(const std::string& fileName, Grid& grid, std::string& error)
+	{
+		if(IsBinary(fileName))
+		{
+			PixelMap map;
+			if(!map.ReadBinary(fileName, error)) return false;
+			grid.ni = map.GetNi();
+			grid.nj = map.GetNj();
+			grid.nFrames = map.GetNFrames();
+			grid.pitchX = map.GetPitchX();
+			grid.pitchY = map.GetPitchY();
+			return true;
+		}
+
+		std::string text, line;
+		if(!BlockReader::ReadFile(fileName, text, error)) return false;
+		size_t p = 0;
+		double field[5];
+		bool ok = false;
+		if(NextLine(text, p, line))
+		{
+			if(line[0] == '#') ok = ReadTimeMapHeader(line.c_str(), grid);
+			else
+			{
+				MapData map;
+				ok = ReadTextMap(fileName, map, error);
+				grid.ni = map.ni;
+				grid.nj = map.nj;
+				grid.nFrames = 1;
+				grid.pitchX = grid.pitchY = 0.;
+				ok = ok && ParseLine(line.c_str(), field) == 3;
+			}
+		}
+		if(!ok && error.empty()) error = "cannot determine the grid of " + fileName;
+		return ok && grid.ni > 0 && grid.nj > 0 && grid.nFrames > 0;
+	}
+
+	// Parses a text map into part, checking every index; the whole file is
+	// read at once (decompressed when block-compressed)
+	bool ReadText(const std::string& fileName, const Grid& grid, PixelMap& part, std::string& error)
+	{
+		std::string text, line;
+		if(!BlockReader::ReadFile(fileName, text, error)) return false;
+
+		size_t p = 0;
+		double field[5];
+		int64_t maxI = -1, maxJ = -1;
+		int columns = 0;
+		bool ok = true;
+		while(ok && NextLine(text, p, line))
+		{
+			const int n = ParseLine(line.c_str(), field);
+			if(n == 0) continue;
+			if(columns == 0) columns = n;
+
+			// "i j value" or "frame i j value"
+			const int64_t frame = n == 4 ? int64_t(field[0]) : 0;
+			const int64_t i = int64_t(field[n-3]);
+			const int64_t j = int64_t(field[n-2]);
+			if(n != columns || (n != 3 && n != 4) || (n == 3 && grid.nFrames != 1))
+			{
+				error = fileName + ": unexpected line: " + line;
+				ok = false;
+			}
+			else if(frame < 0 || frame >= grid.nFrames || i < 0 || i >= grid.ni || j < 0 || j >= grid.nj)
+			{
+				error = fileName + ": index outside the reference grid: " + line;
+				ok = false;
+			}
+			else
+			{
+				part.Fill((frame*grid.ni + i)*grid.nj + j, field[n-1]);
+				maxI = std::max(maxI, i);
+				maxJ = std::max(maxJ, j);
+			}
+		}
+
+		// Plain maps list every pixel, a smaller grid is a different detector
+		if(ok && columns == 3 && (maxI + 1 != grid.ni || maxJ + 1 != grid.nj))
+		{
+			error = fileName + ": grid differs from the reference";
+			ok = false;
+		}
+		return ok;
+	}
+
+	bool ReadBinary(const std::string& fileName, const Grid& grid, PixelMap& part, std::string& error)
+	{
+		if(!part.ReadBinary(fileName, error)) return false;
+		if(part.GetNi() != grid.ni || part.GetNj() != grid.nj || part.GetNFrames() != grid.nFrames)
+		{
+			error = fileName + ": grid differs from the reference";
+			return false;
+		}
+		if(!SamePitch(part.GetPitchX(), grid.pitchX) || !SamePitch(part.GetPitchY(), grid.pitchY))
+		{
+			error = fileName + ": pixel pitch differs from the reference";
+			return false;
+		}
+		return true;
+	}
+
+	// Shared state of the worker threads
+	struct Job
+	{
+		const std::vector<std::string>* files;
+		Grid grid;
+		bool keepGoing;
+		std::atomic<size_t> next;
+		std::atomic<bool> failed;
+		std::atomic<long> nMerged, nSkipped;
+		std::atomic<long long> nBytes;
+		std::mutex errorMutex;
+	};
+
+	void Worker(Job& job, PixelMap& sum)
+	{
+		const std::vector<std::string>& files = *job.files;
+		for(size_t k=job.next++;k<files.size() && !job.failed;k=job.next++)
+		{
+			// Each file is read completely before it is added, so an invalid
+			// file never contributes partial sums
+			PixelMap part(job.grid.ni, job.grid.nj, job.grid.nFrames);
+			std::string error;
+			bool ok = IsBinary(files[k]) ? ReadBinary(files[k], job.grid, part, error)
+					: ReadText(files[k], job.grid, part, error);
+			if(ok && !sum.Add(part))
+			{
+				ok = false;
+				error = files[k] + ": grid differs from the reference";
+			}
+			if(ok)
+			{
+				job.nMerged++;
+				struct stat st;
+				if(stat(files[k].c_str(), &st) == 0) job.nBytes += st.st_size;
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock(job.errorMutex);
+			fprintf(stderr, "scint_merge: %s%s\n", error.c_str(), job.keepGoing ? ", skipped" : "");
+			if(job.keepGoing) job.nSkipped++;
+			else job.failed = true;
+		}
+	}
+
+	bool WriteText(const std::string& fileName, const PixelMap& map)
+	{
+		FILE* out = fopen(fileName.c_str(), "w");
+		if(!out) return false;
+		const int64_t ni = map.GetNi(), nj = map.GetNj();
+		if(map.GetNFrames() == 1)
+		{
+			// Legacy layout of Run::WriteMap
+			for(int64_t i=0;i<ni;i++)
+			{
+				for(int64_t j=0;j<nj;j++) fprintf(out, "%ld\t%ld\t%.10g\n", long(i), long(j), map.Get(i*nj + j));
+				fputc('\n', out);
+			}
+		}
+		else
+		{
+			// Layout of Run::WriteTimeMap (square grids)
+			std::vector<std::pair<int64_t, double> > entries;
+			map.GetEntries(entries);
+			fprintf(out, "# merged, frames %ld, pixels %ld\n", long(map.GetNFrames()), long(ni));
+			for(size_t k=0;k<entries.size();k++)
+			{
+				const int64_t cell = entries[k].first;
+				fprintf(out, "%ld\t%ld\t%ld\t%.10g\n", long(cell/(ni*nj)), long(cell%(ni*nj)/nj),
+						long(cell%nj), entries[k].second);
+			}
+		}
+		return fclose(out) == 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int nThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::string output = "merged.out";
+	bool binary = false, keepGoing = false;
+	std::vector<std::string> files;
+
+	for(int k=1;k<argc;k++)
+	{
+		std::string arg = argv[k];
+		if(arg == "-j" && k+1 < argc) nThreads = atoi(argv[++k]);
+		else if(arg == "-o" && k+1 < argc) output = argv[++k];
+		else if(arg == "-b") binary = true;
+		else if(arg == "-k") keepGoing = true;
+		else if(!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+		else files.push_back(arg);
+	}
+	if(files.empty() || nThreads < 1) { Usage(); return 2; }
+	nThreads = std::min<int>(nThreads, files.size());
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	Job job;
+	job.files = &files;
+	job.keepGoing = keepGoing;
+	job.next = 0;
+	job.failed = false;
+	job.nMerged = job.nSkipped = 0;
+	job.nBytes = 0;
+	std::string error;
+	if(!ReadGrid(files[0], job.grid, error))
+	{
+		fprintf(stderr, "scint_merge: %s\n", error.c_str());
+		return 2;
+	}
+
+	// One accumulator per thread, reduced at the end
+	std::vector<PixelMap> sums(nThreads, PixelMap(job.grid.ni, job.grid.nj, job.grid.nFrames));
+	std::vector<std::thread> threads;
+	for(int t=0;t<nThreads;t++) threads.push_back(std::thread(Worker, std::ref(job), std::ref(sums[t])));
+	for(int t=0;t<nThreads;t++) threads[t].join();
+	if(job.failed) return 2;
+
+	PixelMap& total = sums[0];
+	for(int t=1;t<nThreads;t++)
+		if(!total.Add(sums[t])) return 2;
+	total.SetPitch(job.grid.pitchX, job.grid.pitchY);
+
+	const bool ok = binary ? total.WriteBinary(output) : WriteText(output, total);
+	if(!ok)
+	{
+		fprintf(stderr, "scint_merge: cannot write %s\n", output.c_str());
+		return 2;
+	}
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double mb = job.nBytes/1048576.;
+	printf("merged %ld files (%.1f MB, %ldx%ldx%ld cells) into %s with %d threads in %.2f s: "
+			"%.1f files/s, %.1f MB/s%s\n", long(job.nMerged), mb, long(job.grid.nFrames), long(job.grid.ni),
+			long(job.grid.nj), output.c_str(), nThreads, elapsed, elapsed > 0. ? job.nMerged/elapsed : 0.,
+			elapsed > 0. ? mb/elapsed : 0., job.nSkipped ? ", some files skipped" : "");
+	return job.nSkipped ? 1 : 0;
+}
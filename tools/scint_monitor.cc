@@ -0,0 +1,113 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Client of the monitoring socket of a running Scintillator_Simple.
+//
+//   scint_monitor <socket> [status|map] [-w seconds]
+//
+// Prints the reply of the simulation once, or every <seconds> with -w
+// until the socket goes away (end of run).
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace
+{
+	bool Query(const std::string& path, const std::string& command, std::string& reply)
+	{
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0) return false;
+
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		std::string request = command + "\n";
+		if(write(fd, request.data(), request.size()) != ssize_t(request.size()))
+		{
+			close(fd);
+			return false;
+		}
+
+		reply.clear();
+		char buffer[4096];
+		ssize_t n;
+		while((n = read(fd, buffer, sizeof(buffer))) > 0) reply.append(buffer, n);
+		close(fd);
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string path, command = "status";
+	double period = 0.;
+
+	for(int k=1;k<argc;k++)
+	{
+		std::string arg = argv[k];
+		if(arg == "-w" && k+1 < argc) period = atof(argv[++k]);
+		else if(path.empty()) path = arg;
+		else command = arg;
+	}
+	if(path.empty())
+	{
+		fprintf(stderr, "usage: scint_monitor <socket> [status|map] [-w seconds]\n");
+		return 2;
+	}
+
+	std::string reply;
+	if(!Query(path, command, reply))
+	{
+		fprintf(stderr, "scint_monitor: cannot connect to %s\n", path.c_str());
+		return 1;
+	}
+	fputs(reply.c_str(), stdout);
+
+	while(period > 0.)
+	{
+		usleep(useconds_t(period*1e6));
+		if(!Query(path, command, reply)) break;
+		printf("\n");
+		fputs(reply.c_str(), stdout);
+		fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,210 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Block compression of run outputs (see include/BlockFile.hh).
+//
+//   scint_pack [-c codec] [-B kB] [-o output] file...   compress
+//   scint_pack -d [-j threads] [-o output] file...      decompress
+//   scint_pack -l file...                               list
+//
+// Compression replaces every file in place (through <file>.tmp) unless -o
+// names the output of a single file; already compressed files are
+// recompressed with the requested codec, so -c none restores plain files.
+// Decompression writes the content of all files, in order, to the output
+// (default standard output), e.g. "scint_pack -d DE.out | gnuplot ...";
+// blocks are decompressed on -j threads. The run outputs can be compressed
+// directly with /scint/output/compression, and every tool reads both forms.
+//
+//   -c  none (or stored), builtin (default), zlib, zstd (when built in)
+//   -B  uncompressed block size in kB (default 1024)
+// Exit status 0 on success, 2 on error (including a file truncated inside
+// a block).
+
+#include "BlockFile.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	void Usage()
+	{
+		fprintf(stderr, "usage: scint_pack [-c codec] [-B kB] [-o output] file...\n"
+				"       scint_pack -d [-j threads] [-o output] file...\n"
+				"       scint_pack -l file...\n");
+	}
+
+	bool WriteFile(const std::string& fileName, const std::string& data)
+	{
+		const std::string tmpName = fileName + ".tmp";
+		FILE* out = fopen(tmpName.c_str(), "wb");
+		if(!out) return false;
+		bool ok = fwrite(data.data(), 1, data.size(), out) == data.size();
+		ok = fclose(out) == 0 && ok;
+		return ok && rename(tmpName.c_str(), fileName.c_str()) == 0;
+	}
+
+	bool Compress(const std::string& input, const std::string& output, BlockCodec codec, size_t blockSize,
+			int nThreads, std::string& error)
+	{
+		std::string data;
+		if(!BlockReader::ReadFile(input, data, error, nThreads)) return false;
+
+		const size_t rawSize = data.size();
+		std::string packed;
+		if(codec == kCodecStored) packed.swap(data);
+		else
+		{
+			BlockWriter writer(codec, blockSize);
+			writer.Write(data.data(), data.size(), packed);
+			writer.Finish(packed);
+		}
+		if(!WriteFile(output, packed))
+		{
+			error = "cannot write " + output;
+			return false;
+		}
+		printf("%s: %.1f MB -> %.1f MB (%s)\n", output.c_str(), rawSize/1048576.,
+				packed.size()/1048576., GetBlockCodecName(codec));
+		return true;
+	}
+
+	bool List(const std::string& fileName, std::string& error)
+	{
+		BlockReader in;
+		if(!in.Open(fileName, error)) return false;
+		if(!in.IsCompressed())
+		{
+			printf("%s: plain, %.1f MB\n", fileName.c_str(), in.GetSize()/1048576.);
+			return true;
+		}
+		printf("%s: %s, %lu blocks of %lu kB, %.1f MB -> %.1f MB (%.1f %%)\n", fileName.c_str(),
+				GetBlockCodecName(in.GetCodec()), (unsigned long)in.GetNumberOfBlocks(),
+				(unsigned long)(in.GetBlockSize()/1024), in.GetSize()/1048576., in.GetStoredSize()/1048576.,
+				in.GetSize() ? 100.*in.GetStoredSize()/in.GetSize() : 0.);
+		if(in.GetTruncatedBytes() > 0)
+		{
+			char message[128];
+			snprintf(message, sizeof(message), ": truncated, %lu bytes of a partial block",
+					(unsigned long)in.GetTruncatedBytes());
+			error = fileName + message;
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	enum { kCompress, kDecompress, kList } mode = kCompress;
+	int nThreads = std::max(1u, std::thread::hardware_concurrency());
+	BlockCodec codec = kCodecBuiltin;
+	size_t blockSize = 1024*1024;
+	std::string output;
+	std::vector<std::string> files;
+
+	for(int k=1;k<argc;k++)
+	{
+		std::string arg = argv[k];
+		if(arg == "-d") mode = kDecompress;
+		else if(arg == "-l") mode = kList;
+		else if(arg == "-j" && k+1 < argc) nThreads = atoi(argv[++k]);
+		else if(arg == "-B" && k+1 < argc) blockSize = size_t(atol(argv[++k]))*1024;
+		else if(arg == "-o" && k+1 < argc) output = argv[++k];
+		else if(arg == "-c" && k+1 < argc)
+		{
+			if(!ParseBlockCodec(argv[++k], codec) || !IsBlockCodecAvailable(codec))
+			{
+				fprintf(stderr, "scint_pack: codec %s is not available (%s)\n", argv[k], GetBlockCodecNames().c_str());
+				return 2;
+			}
+		}
+		else if(!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+		else files.push_back(arg);
+	}
+	if(files.empty() || nThreads < 1 || (mode == kCompress && !output.empty() && files.size() > 1))
+	{
+		Usage();
+		return 2;
+	}
+
+	std::string error;
+	if(mode == kCompress)
+	{
+		for(size_t f=0;f<files.size();f++)
+		{
+			if(!Compress(files[f], output.empty() ? files[f] : output, codec, blockSize, nThreads, error))
+			{
+				fprintf(stderr, "scint_pack: %s\n", error.c_str());
+				return 2;
+			}
+		}
+		return 0;
+	}
+
+	if(mode == kList)
+	{
+		for(size_t f=0;f<files.size();f++)
+		{
+			if(!List(files[f], error))
+			{
+				fprintf(stderr, "scint_pack: %s\n", error.c_str());
+				return 2;
+			}
+		}
+		return 0;
+	}
+
+	FILE* out = output.empty() ? stdout : fopen(output.c_str(), "wb");
+	if(!out)
+	{
+		fprintf(stderr, "scint_pack: cannot write %s\n", output.c_str());
+		return 2;
+	}
+	std::string data;
+	for(size_t f=0;f<files.size();f++)
+	{
+		if(!BlockReader::ReadFile(files[f], data, error, nThreads)
+				|| fwrite(data.data(), 1, data.size(), out) != data.size())
+		{
+			fprintf(stderr, "scint_pack: %s\n", error.empty() ? "write error" : error.c_str());
+			return 2;
+		}
+	}
+	if(out != stdout && fclose(out) != 0)
+	{
+		fprintf(stderr, "scint_pack: cannot write %s\n", output.c_str());
+		return 2;
+	}
+	return 0;
+}
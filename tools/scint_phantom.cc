@@ -0,0 +1,239 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Voxelised phantoms for /scint/det/phantom (see include/PhantomFile.hh).
+//
+//   scint_phantom -n nx ny nz -v vx vy vz [-s step] [-c codec] -d density.raw -o out
+//   scint_phantom -n nx ny nz -v vx vy vz [-c codec] -t -o out
+//   scint_phantom -l file...
+//
+// -d converts a CT density volume (float32 g/cm3, x fastest, e.g. exported
+// from HU with the scanner calibration) into air, lung, soft tissue and
+// bone, each density rounded to -s g/cm3 (default 0.02) so that neighbouring
+// voxels share materials and regular navigation can skip their boundaries.
+// -t writes a test phantom: water with a bone cylinder along y and a lung
+// block, both through the centre in z. Voxel sizes are in mm; the phantom
+// extent is n x v along each axis. -l prints grid, extent and the voxels
+// per material.
+// Exit status 0 on success, 2 on error.
+
+#include "PhantomFile.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	void Usage()
+	{
+		fprintf(stderr, "usage: scint_phantom -n nx ny nz -v vx vy vz [-s step] [-c codec] -d density.raw -o out\n"
+				"       scint_phantom -n nx ny nz -v vx vy vz [-c codec] -t -o out\n"
+				"       scint_phantom -l file...\n");
+	}
+
+	// Material index of (name, density), added on first use
+	class MaterialTable
+	{
+	public:
+		MaterialTable(PhantomData& phantom) : fPhantom(phantom) {}
+
+		int Get(const std::string& name, double density)
+		{
+			std::pair<std::string, long> key(name, lround(density*1000.));
+			std::map<std::pair<std::string, long>, int>::iterator it = fIndex.find(key);
+			if(it != fIndex.end()) return it->second;
+			if(fPhantom.materials.size() >= 65535) return -1;
+			fPhantom.materials.push_back(PhantomMaterial(name, density));
+			return fIndex[key] = int(fPhantom.materials.size()) - 1;
+		}
+
+	private:
+		PhantomData& fPhantom;
+		std::map<std::pair<std::string, long>, int> fIndex;
+	};
+
+	// Density ramp of the usual CT calibrations [g/cm3]
+	int DensityMaterial(MaterialTable& table, double density, double step)
+	{
+		if(density < 0.05) return table.Get("G4_AIR", 0.);
+		double rounded = std::max(step, step*floor(density/step + 0.5));
+		if(density < 0.85) return table.Get("G4_LUNG_ICRP", rounded);
+		if(density < 1.10) return table.Get("G4_WATER", rounded);
+		return table.Get("G4_BONE_COMPACT_ICRU", rounded);
+	}
+
+	bool ConvertDensity(const std::string& fileName, double step, PhantomData& phantom, std::string& error)
+	{
+		std::string data;
+		if(!BlockReader::ReadFile(fileName, data, error)) return false;
+		const uint64_t nVoxels = phantom.GetNumberOfVoxels();
+		if(data.size() != nVoxels*sizeof(float))
+		{
+			error = fileName + ": size does not match the grid (float32 per voxel expected)";
+			return false;
+		}
+		const float* density = (const float*)data.data();
+		MaterialTable table(phantom);
+		phantom.material.resize(nVoxels);
+		for(uint64_t v=0;v<nVoxels;v++)
+		{
+			int index = DensityMaterial(table, density[v], step);
+			if(index < 0)
+			{
+				error = "more than 65535 materials, increase -s";
+				return false;
+			}
+			phantom.material[v] = uint16_t(index);
+		}
+		return true;
+	}
+
+	void TestPhantom(PhantomData& phantom)
+	{
+		MaterialTable table(phantom);
+		const int water = table.Get("G4_WATER", 0.);
+		const int bone = table.Get("G4_BONE_COMPACT_ICRU", 0.);
+		const int lung = table.Get("G4_LUNG_ICRP", 0.);
+		double size[3];
+		for(int k=0;k<3;k++) size[k] = phantom.n[k]*phantom.voxel[k];
+
+		phantom.material.resize(phantom.GetNumberOfVoxels());
+		for(uint32_t iz=0;iz<phantom.n[2];iz++)
+		{
+			double z = (iz + 0.5)*phantom.voxel[2] - 0.5*size[2];
+			for(uint32_t iy=0;iy<phantom.n[1];iy++)
+			{
+				double y = (iy + 0.5)*phantom.voxel[1] - 0.5*size[1];
+				for(uint32_t ix=0;ix<phantom.n[0];ix++)
+				{
+					double x = (ix + 0.5)*phantom.voxel[0] - 0.5*size[0];
+					int m = water;
+					double dx = x + 0.25*size[0];
+					if(dx*dx + z*z < pow(0.1*size[0], 2)) m = bone;
+					else if(fabs(x - 0.25*size[0]) < 0.1*size[0] && fabs(y) < 0.25*size[1]
+							&& fabs(z) < 0.25*size[2]) m = lung;
+					phantom.material[phantom.Index(ix, iy, iz)] = uint16_t(m);
+				}
+			}
+		}
+	}
+
+	bool List(const std::string& fileName, std::string& error)
+	{
+		PhantomData phantom;
+		if(!phantom.Read(fileName, error)) return false;
+		printf("%s: %u x %u x %u voxels of %g x %g x %g mm (%g x %g x %g mm), %lu materials, hash %016llx\n",
+				fileName.c_str(), phantom.n[0], phantom.n[1], phantom.n[2],
+				phantom.voxel[0], phantom.voxel[1], phantom.voxel[2], phantom.n[0]*phantom.voxel[0],
+				phantom.n[1]*phantom.voxel[1], phantom.n[2]*phantom.voxel[2],
+				(unsigned long)phantom.materials.size(), (unsigned long long)phantom.GetHash());
+		std::vector<uint64_t> count(phantom.materials.size(), 0);
+		for(size_t v=0;v<phantom.material.size();v++) count[phantom.material[v]]++;
+		for(size_t m=0;m<phantom.materials.size();m++)
+		{
+			printf("  %5lu %-24s", (unsigned long)m, phantom.materials[m].name.c_str());
+			if(phantom.materials[m].density > 0.) printf(" %6.3f g/cm3", phantom.materials[m].density);
+			else printf(" %12s", "default");
+			printf(" %12lu voxels\n", (unsigned long)count[m]);
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	PhantomData phantom;
+	double step = 0.02;
+	BlockCodec codec = kCodecStored;
+	bool list = false, test = false;
+	std::string densityFile, output;
+	std::vector<std::string> files;
+
+	for(int k=1;k<argc;k++)
+	{
+		std::string arg = argv[k];
+		if(arg == "-l") list = true;
+		else if(arg == "-t") test = true;
+		else if(arg == "-d" && k+1 < argc) densityFile = argv[++k];
+		else if(arg == "-o" && k+1 < argc) output = argv[++k];
+		else if(arg == "-s" && k+1 < argc) step = atof(argv[++k]);
+		else if(arg == "-n" && k+3 < argc) for(int a=0;a<3;a++) phantom.n[a] = uint32_t(atol(argv[++k]));
+		else if(arg == "-v" && k+3 < argc) for(int a=0;a<3;a++) phantom.voxel[a] = atof(argv[++k]);
+		else if(arg == "-c" && k+1 < argc)
+		{
+			if(!ParseBlockCodec(argv[++k], codec) || !IsBlockCodecAvailable(codec))
+			{
+				fprintf(stderr, "scint_phantom: codec %s is not available (%s)\n", argv[k], GetBlockCodecNames().c_str());
+				return 2;
+			}
+		}
+		else if(!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+		else files.push_back(arg);
+	}
+
+	std::string error;
+	if(list)
+	{
+		if(files.empty()) { Usage(); return 2; }
+		for(size_t f=0;f<files.size();f++)
+		{
+			if(!List(files[f], error))
+			{
+				fprintf(stderr, "scint_phantom: %s\n", error.c_str());
+				return 2;
+			}
+		}
+		return 0;
+	}
+
+	if(output.empty() || test == !densityFile.empty() || phantom.GetNumberOfVoxels() == 0
+			|| phantom.voxel[0] <= 0. || phantom.voxel[1] <= 0. || phantom.voxel[2] <= 0. || step <= 0.)
+	{
+		Usage();
+		return 2;
+	}
+	if(test) TestPhantom(phantom);
+	else if(!ConvertDensity(densityFile, step, phantom, error))
+	{
+		fprintf(stderr, "scint_phantom: %s\n", error.c_str());
+		return 2;
+	}
+	if(!phantom.Write(output, error, codec))
+	{
+		fprintf(stderr, "scint_phantom: %s\n", error.c_str());
+		return 2;
+	}
+	return List(output, error) ? 0 : 2;
+}
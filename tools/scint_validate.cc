@@ -0,0 +1,184 @@
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// 	Author: wjcheon (Medical physics Lab, Sungkyunkwan University, Seoul, Republic of Korea)
+//  GitHub: http://github.com/wjcheon
+//
+
+
+// Physics regression check of a run against golden references.
+//
+//   scint_validate [-a alpha] [-z zmax] moments golden_moments
+//
+// Both files are event moments (/scint/output/moments): per pixel, row,
+// column, spectrum bin and for the total, the sums over events of the
+// per-event signal, of its square and of its product with the event
+// total. The photons of one event are correlated (one gamma gives
+// hundreds), so the uncertainties are event-level variances, not Poisson
+// counts:
+//
+// Pixels, rows (profile i), columns (profile j), spectrum: the fractions
+//   of the total, largest |z| over the elements, Bonferroni-corrected
+//   (valid for correlated elements).
+// Total: z-test of the mean signal per event.
+// Exit status 0 when all tests pass, 1 on a significant deviation, 2 on error.
+
+#include "MapIO.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Result
+	{
+		std::string name;
+		double statistic;
+		double pValue;
+		bool pass;
+	};
+
+	// Mean signal per event and the variance of that mean
+	void Mean(const Moments& m, long n, double& mean, double& variance)
+	{
+		mean = m.sum/n;
+		variance = std::max(m.sum2 - m.sum*mean, 0.)/(double(n)*(n - 1));
+	}
+
+	// Fraction of the total and its variance (ratio of sums over events,
+	// first order): the yield fluctuation common to all elements cancels
+	void Fraction(const Moments& m, const Moments& total, long n, double& fraction, double& variance)
+	{
+		fraction = total.sum > 0. ? m.sum/total.sum : 0.;
+		const double residual = m.sum2 - 2.*fraction*m.sumt + fraction*fraction*total.sum2;
+		variance = total.sum > 0. ? std::max(residual, 0.)*n/((n - 1)*total.sum*total.sum) : 0.;
+	}
+
+	// Shape: largest |z| of the fractions over the elements fired on either
+	// side, Bonferroni-corrected so that any correlation between the
+	// elements (photons of one event cluster) keeps the test valid
+	Result ShapeTest(const std::string& name, const std::vector<Moments>& a, const Moments& ta, long na,
+			const std::vector<Moments>& b, const Moments& tb, long nb, double alpha)
+	{
+		double zmax = 0.;
+		long nTested = 0;
+		for(size_t k=0;k<a.size();k++)
+		{
+			double fa, va, fb, vb;
+			Fraction(a[k], ta, na, fa, va);
+			Fraction(b[k], tb, nb, fb, vb);
+			if(va + vb <= 0.) continue;
+			nTested++;
+			zmax = std::max(zmax, fabs(fa - fb)/sqrt(va + vb));
+		}
+
+		Result r;
+		r.name = name;
+		r.statistic = zmax;
+		r.pValue = std::min(1., nTested*erfc(zmax/sqrt(2.)));
+		r.pass = r.pValue >= alpha;
+		return r;
+	}
+
+	// Mean total signal per event: |ma - mb| / sqrt(va + vb)
+	Result YieldTest(const std::string& name, const Moments& a, long na, const Moments& b, long nb, double zmax)
+	{
+		double ma, va, mb, vb;
+		Mean(a, na, ma, va);
+		Mean(b, nb, mb, vb);
+
+		Result r;
+		r.name = name;
+		r.statistic = (va + vb > 0.) ? fabs(ma - mb)/sqrt(va + vb) : 0.;
+		r.pValue = erfc(r.statistic/sqrt(2.));
+		r.pass = r.statistic <= zmax;
+		return r;
+	}
+
+	void Usage()
+	{
+		fprintf(stderr, "usage: scint_validate [-a alpha] [-z zmax] moments golden_moments\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	double alpha = 1e-3;
+	double zmax = 4.;
+	std::vector<std::string> files;
+
+	for(int k=1;k<argc;k++)
+	{
+		std::string arg = argv[k];
+		if(arg == "-a" && k+1 < argc) alpha = atof(argv[++k]);
+		else if(arg == "-z" && k+1 < argc) zmax = atof(argv[++k]);
+		else if(!arg.empty() && arg[0] == '-') { Usage(); return 2; }
+		else files.push_back(arg);
+	}
+	if(files.size() != 2) { Usage(); return 2; }
+
+	MomentsData run, golden;
+	std::string error;
+	if(!ReadMoments(files[0], run, error) || !ReadMoments(files[1], golden, error))
+	{
+		fprintf(stderr, "scint_validate: %s\n", error.c_str());
+		return 2;
+	}
+	if(run.ni != golden.ni || run.nj != golden.nj)
+	{
+		fprintf(stderr, "scint_validate: grid %dx%d differs from golden %dx%d\n",
+				run.ni, run.nj, golden.ni, golden.nj);
+		return 1;
+	}
+	if(run.spectrum.size() != golden.spectrum.size())
+	{
+		fprintf(stderr, "scint_validate: %zu spectrum bins, golden has %zu\n",
+				run.spectrum.size(), golden.spectrum.size());
+		return 1;
+	}
+
+	const long n = run.nEvents, ng = golden.nEvents;
+	std::vector<Result> results;
+	results.push_back(ShapeTest("map pixels (max |z|)", run.pixel, run.total, n, golden.pixel, golden.total, ng, alpha));
+	results.push_back(ShapeTest("map profile i (max |z|)", run.row, run.total, n, golden.row, golden.total, ng, alpha));
+	results.push_back(ShapeTest("map profile j (max |z|)", run.column, run.total, n, golden.column, golden.total, ng, alpha));
+	results.push_back(ShapeTest("spectrum (max |z|)", run.spectrum, run.total, n, golden.spectrum, golden.total, ng, alpha));
+	results.push_back(YieldTest("map total (z)", run.total, n, golden.total, ng, zmax));
+
+	printf("  %ld events, golden %ld\n", n, ng);
+	bool pass = true;
+	for(size_t k=0;k<results.size();k++)
+	{
+		const Result& r = results[k];
+		printf("  %-24s %12.5g   p = %-10.4g %s\n", r.name.c_str(), r.statistic, r.pValue, r.pass ? "ok" : "FAIL");
+		pass = pass && r.pass;
+	}
+	printf("%s (alpha = %g, zmax = %g)\n", pass ? "PASSED" : "FAILED", alpha, zmax);
+
+	return pass ? 0 : 1;
+}
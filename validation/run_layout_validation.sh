@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# Pixel layouts must not change the physics.
+#
+#   run_layout_validation.sh <Scintillator_Simple> <scint_validate>
+#
+# Runs validation/layouts.mac (same seed, optical photons only, face
+# readout) with the replica, nested and single layouts and requires the
+# nested and single maps to be identical to the replica map. When they are
+# not, scint_validate shows how far they are apart.
+
+VALIDATION_DIR=$(cd "$(dirname "$0")" && pwd)
+
+EXE="$1"
+TOOL="$2"
+if [ -z "$EXE" ] || [ ! -x "$EXE" ] || [ -z "$TOOL" ] || [ ! -x "$TOOL" ]; then
+    echo "usage: $0 <Scintillator_Simple> <scint_validate>"
+    exit 2
+fi
+
+: ${VALIDATION_ALPHA:=0.001}
+
+for layout in replica nested single; do
+    echo "=== $layout layout"
+    VALIDATION_LAYOUT=$layout
+    export VALIDATION_LAYOUT
+    if ! "$EXE" "$VALIDATION_DIR/layouts.mac" > layout_$layout.log 2>&1; then
+        echo "    FAILED, see layout_$layout.log"
+        exit 1
+    fi
+done
+
+STATUS=0
+for layout in nested single; do
+    if cmp -s layout_${layout}_DE.out layout_replica_DE.out; then
+        echo "$layout: map identical to replica"
+    else
+        echo "$layout: map differs from replica"
+        "$TOOL" -a "$VALIDATION_ALPHA" layout_${layout}_Moments.out layout_replica_Moments.out
+        STATUS=1
+    fi
+done
+exit $STATUS
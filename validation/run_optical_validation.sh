@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Analytic optical transport against full Geant4 optical tracking.
+#
+#   run_optical_validation.sh <Scintillator_Simple> <scint_validate>
+#
+# Runs the same face-readout workload with /scint/optical/transport geant4
+# and analytic, compares maps and spectra through their event moments with
+# scint_validate (the Geant4 run is the reference) and prints the speedup
+# of the event loop.
+
+VALIDATION_DIR=$(cd "$(dirname "$0")" && pwd)
+
+EXE="$1"
+TOOL="$2"
+if [ -z "$EXE" ] || [ ! -x "$EXE" ] || [ -z "$TOOL" ] || [ ! -x "$TOOL" ]; then
+    echo "usage: $0 <Scintillator_Simple> <scint_validate>"
+    exit 2
+fi
+
+: ${VALIDATION_ALPHA:=0.001}
+
+for engine in geant4 analytic; do
+    echo "=== $engine transport"
+    if ! "$EXE" "$VALIDATION_DIR/optical_$engine.mac" > optical_$engine.log 2>&1; then
+        echo "    FAILED, see optical_$engine.log"
+        exit 1
+    fi
+done
+
+wall() { sed -n 's/.*"wall_time_s": \([0-9.e+-]*\),.*/\1/p' "$1" | head -1; }
+G4_TIME=$(wall optical_geant4_stats.json)
+AN_TIME=$(wall optical_analytic_stats.json)
+echo "wall time: geant4 $G4_TIME s, analytic $AN_TIME s, speedup" \
+    $(awk -v a="$G4_TIME" -v b="$AN_TIME" 'BEGIN { if (b > 0) printf "%.1f", a/b; else print "n/a" }')
+
+"$TOOL" -a "$VALIDATION_ALPHA" optical_analytic_Moments.out optical_geant4_Moments.out
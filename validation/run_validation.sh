@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# Physics regression check of Scintillator_Simple.
+#
+#   run_validation.sh <Scintillator_Simple> <scint_validate> [--update-golden]
+#
+# Runs validation/reference.mac and compares the event moments of the
+# merged pixel map, its profiles and the detected-photon spectrum with
+# validation/golden/Moments.out (shape of map, profiles and spectrum,
+# total yield, all with event-level uncertainties). Fails when a deviation
+# is significant at VALIDATION_ALPHA (default 0.001). Missing golden
+# references are an error, not a skipped check.
+
+VALIDATION_DIR=$(cd "$(dirname "$0")" && pwd)
+GOLDEN="$VALIDATION_DIR/golden"
+
+EXE="$1"
+TOOL="$2"
+if [ -z "$EXE" ] || [ ! -x "$EXE" ] || [ -z "$TOOL" ] || [ ! -x "$TOOL" ]; then
+    echo "usage: $0 <Scintillator_Simple> <scint_validate> [--update-golden]"
+    exit 2
+fi
+
+: ${VALIDATION_ALPHA:=0.001}
+
+# Checked before the reference run so a tree without references fails at once
+if [ "$3" != "--update-golden" ] && [ ! -f "$GOLDEN/Moments.out" ]; then
+    echo "ERROR: no golden references in $GOLDEN (Moments.out)" >&2
+    echo "       generate them with --update-golden on a trusted build and commit them" >&2
+    exit 1
+fi
+
+echo "=== reference run"
+if ! "$EXE" "$VALIDATION_DIR/reference.mac" > validation.log 2>&1; then
+    echo "    FAILED, see validation.log"
+    exit 1
+fi
+
+if [ "$3" = "--update-golden" ]; then
+    mkdir -p "$GOLDEN"
+    cp validation_Moments.out "$GOLDEN/Moments.out"
+    echo "Golden references written to $GOLDEN"
+    exit 0
+fi
+
+"$TOOL" -a "$VALIDATION_ALPHA" validation_Moments.out "$GOLDEN/Moments.out"